@@ -0,0 +1,214 @@
+#include "vfindinnotebookdialog.h"
+
+#include <QtWidgets>
+#include "vnote.h"
+#include "vnotebook.h"
+
+extern VNote *g_vnote;
+
+VFindInNotebookDialog::VFindInNotebookDialog(QWidget *p_parent)
+    : QDialog(p_parent)
+{
+    m_searcher = new VGrepSearcher(this);
+    connect(m_searcher, &VGrepSearcher::matchesFound,
+            this, &VFindInNotebookDialog::handleMatchesFound);
+    connect(m_searcher, &VGrepSearcher::finished,
+            this, &VFindInNotebookDialog::handleSearchFinished);
+
+    setupUI();
+}
+
+void VFindInNotebookDialog::setupUI()
+{
+    m_scopeCombo = new QComboBox();
+    m_scopeCombo->setToolTip(tr("Notebooks to search"));
+
+    m_patternEdit = new QLineEdit();
+    m_patternEdit->setPlaceholderText(tr("Text or regular expression to find"));
+    connect(m_patternEdit, &QLineEdit::returnPressed,
+            this, &VFindInNotebookDialog::startSearch);
+    connect(m_patternEdit, &QLineEdit::textChanged,
+            this, &VFindInNotebookDialog::updateFindButton);
+
+    m_regExpCB = new QCheckBox(tr("Regular &expression"));
+    m_caseSensitiveCB = new QCheckBox(tr("&Case sensitive"));
+
+    m_findBtn = new QPushButton(tr("&Find"));
+    m_findBtn->setDefault(true);
+    connect(m_findBtn, &QPushButton::clicked,
+            this, &VFindInNotebookDialog::handleFindBtnClicked);
+
+    m_infoLabel = new QLabel();
+    m_infoLabel->setWordWrap(true);
+
+    m_resultTree = new QTreeWidget();
+    m_resultTree->setColumnCount(2);
+    m_resultTree->setHeaderLabels(QStringList() << tr("Note") << tr("Matches"));
+    m_resultTree->setSelectionMode(QAbstractItemView::SingleSelection);
+    connect(m_resultTree, &QTreeWidget::itemActivated,
+            this, &VFindInNotebookDialog::handleItemActivated);
+
+    QFormLayout *topLayout = new QFormLayout();
+    topLayout->addRow(tr("&Scope:"), m_scopeCombo);
+    topLayout->addRow(tr("&Pattern:"), m_patternEdit);
+
+    QHBoxLayout *optionLayout = new QHBoxLayout();
+    optionLayout->addWidget(m_regExpCB);
+    optionLayout->addWidget(m_caseSensitiveCB);
+    optionLayout->addStretch();
+    optionLayout->addWidget(m_findBtn);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout();
+    mainLayout->addLayout(topLayout);
+    mainLayout->addLayout(optionLayout);
+    mainLayout->addWidget(m_infoLabel);
+    mainLayout->addWidget(m_resultTree);
+    setLayout(mainLayout);
+
+    setWindowTitle(tr("Find In Notebook"));
+    resize(600, 400);
+
+    updateFindButton();
+}
+
+void VFindInNotebookDialog::openDialog(const QString &p_text)
+{
+    if (!m_searcher->isRunning()) {
+        updateScopes();
+    }
+
+    if (!p_text.isEmpty()) {
+        m_patternEdit->setText(p_text);
+    }
+
+    show();
+    raise();
+    activateWindow();
+    m_patternEdit->setFocus();
+    m_patternEdit->selectAll();
+}
+
+void VFindInNotebookDialog::updateScopes()
+{
+    QString cur = m_scopeCombo->currentText();
+    int curIdx = m_scopeCombo->currentIndex();
+
+    m_scopeCombo->clear();
+    m_scopeCombo->addItem(tr("All notebooks"));
+    for (auto const &nb : g_vnote->getNotebooks()) {
+        m_scopeCombo->addItem(nb->getName());
+    }
+
+    // Keep the notebook chosen last time.
+    int idx = curIdx > 0 ? m_scopeCombo->findText(cur) : 0;
+    m_scopeCombo->setCurrentIndex(idx > 0 ? idx : 0);
+}
+
+void VFindInNotebookDialog::handleFindBtnClicked()
+{
+    if (m_searcher->isRunning()) {
+        stopSearch();
+    } else {
+        startSearch();
+    }
+}
+
+void VFindInNotebookDialog::startSearch()
+{
+    QString pattern = m_patternEdit->text();
+    if (pattern.isEmpty()) {
+        return;
+    }
+
+    m_resultTree->clear();
+    m_noteItems.clear();
+
+    QStringList notes;
+    const QVector<VNotebook *> &notebooks = g_vnote->getNotebooks();
+    QString scope = m_scopeCombo->currentIndex() > 0 ? m_scopeCombo->currentText() : QString();
+    for (auto const &nb : notebooks) {
+        if (scope.isEmpty() || nb->getName() == scope) {
+            VGrepSearcher::collectNotes(nb->getRootDir(), notes);
+        }
+    }
+
+    m_timer.start();
+    if (!m_searcher->start(notes,
+                           pattern,
+                           m_regExpCB->isChecked(),
+                           m_caseSensitiveCB->isChecked())) {
+        m_infoLabel->setText(tr("Invalid pattern."));
+        return;
+    }
+
+    m_infoLabel->setText(tr("Searching %1 notes...").arg(notes.size()));
+    updateFindButton();
+}
+
+void VFindInNotebookDialog::stopSearch()
+{
+    m_searcher->cancel();
+    m_infoLabel->setText(tr("Search cancelled. %1 notes matched.").arg(m_noteItems.size()));
+    updateFindButton();
+}
+
+void VFindInNotebookDialog::updateFindButton()
+{
+    if (m_searcher->isRunning()) {
+        m_findBtn->setText(tr("&Cancel"));
+        m_findBtn->setEnabled(true);
+    } else {
+        m_findBtn->setText(tr("&Find"));
+        m_findBtn->setEnabled(!m_patternEdit->text().isEmpty());
+    }
+}
+
+void VFindInNotebookDialog::handleMatchesFound(const QVector<VGrepMatch> &p_matches)
+{
+    for (auto const &match : p_matches) {
+        QTreeWidgetItem *noteItem = m_noteItems.value(match.m_path, NULL);
+        if (!noteItem) {
+            noteItem = new QTreeWidgetItem(m_resultTree);
+            noteItem->setText(0, QFileInfo(match.m_path).completeBaseName());
+            noteItem->setToolTip(0, match.m_path);
+            noteItem->setData(0, Qt::UserRole, match.m_path);
+            m_noteItems.insert(match.m_path, noteItem);
+        }
+
+        QTreeWidgetItem *lineItem = new QTreeWidgetItem(noteItem);
+        lineItem->setText(0, tr("%1: %2").arg(match.m_lineNumber).arg(match.m_lineText));
+        lineItem->setToolTip(0, match.m_lineText);
+        lineItem->setData(0, Qt::UserRole, match.m_path);
+
+        noteItem->setText(1, QString::number(noteItem->childCount()));
+    }
+}
+
+void VFindInNotebookDialog::handleSearchFinished(int p_fileCount, int p_matchCount)
+{
+    m_infoLabel->setText(tr("%1 matches in %2 of %3 notes (%4 ms).")
+                           .arg(p_matchCount)
+                           .arg(m_noteItems.size())
+                           .arg(p_fileCount)
+                           .arg(m_timer.elapsed()));
+    updateFindButton();
+}
+
+void VFindInNotebookDialog::handleItemActivated(QTreeWidgetItem *p_item, int p_column)
+{
+    Q_UNUSED(p_column);
+    if (!p_item) {
+        return;
+    }
+
+    emit noteActivated(p_item->data(0, Qt::UserRole).toString());
+}
+
+void VFindInNotebookDialog::closeEvent(QCloseEvent *p_event)
+{
+    if (m_searcher->isRunning()) {
+        stopSearch();
+    }
+
+    QDialog::closeEvent(p_event);
+}
@@ -0,0 +1,71 @@
+#ifndef VFINDINNOTEBOOKDIALOG_H
+#define VFINDINNOTEBOOKDIALOG_H
+
+#include <QDialog>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include "vgrepsearcher.h"
+
+class QComboBox;
+class QLineEdit;
+class QCheckBox;
+class QPushButton;
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+// Dialog to search the raw content of the notes in notebooks like grep.
+// Matches are listed as soon as they are found.
+class VFindInNotebookDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit VFindInNotebookDialog(QWidget *p_parent = 0);
+
+    // Show the dialog with @p_text as the pattern.
+    void openDialog(const QString &p_text);
+
+signals:
+    // Request to open note @p_path.
+    void noteActivated(const QString &p_path);
+
+protected:
+    void closeEvent(QCloseEvent *p_event) Q_DECL_OVERRIDE;
+
+private slots:
+    // Start a search or cancel current search.
+    void handleFindBtnClicked();
+    void handleMatchesFound(const QVector<VGrepMatch> &p_matches);
+    void handleSearchFinished(int p_fileCount, int p_matchCount);
+    void handleItemActivated(QTreeWidgetItem *p_item, int p_column);
+
+private:
+    void setupUI();
+
+    // Fill the scope combo box with current notebooks.
+    void updateScopes();
+
+    void startSearch();
+
+    void stopSearch();
+
+    void updateFindButton();
+
+    VGrepSearcher *m_searcher;
+
+    QComboBox *m_scopeCombo;
+    QLineEdit *m_patternEdit;
+    QCheckBox *m_regExpCB;
+    QCheckBox *m_caseSensitiveCB;
+    QPushButton *m_findBtn;
+    QLabel *m_infoLabel;
+    QTreeWidget *m_resultTree;
+
+    // Path -> item of the note in the result tree.
+    QHash<QString, QTreeWidgetItem *> m_noteItems;
+
+    QElapsedTimer m_timer;
+};
+
+#endif // VFINDINNOTEBOOKDIALOG_H
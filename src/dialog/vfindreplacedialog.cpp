@@ -31,6 +31,7 @@ void VFindReplaceDialog::setupUI()
     m_findNextBtn->setDefault(true);
     m_findPrevBtn = new QPushButton(tr("Find &Previous"));
     m_findPrevBtn->setProperty("FlatBtn", true);
+    m_matchLabel = new QLabel();
 
     // Replace
     QLabel *replaceLabel = new QLabel(tr("&Replace with:"));
@@ -66,6 +67,7 @@ void VFindReplaceDialog::setupUI()
     gridLayout->addWidget(m_findEdit, 0, 1);
     gridLayout->addWidget(m_findNextBtn, 0, 2);
     gridLayout->addWidget(m_findPrevBtn, 0, 3);
+    gridLayout->addWidget(m_matchLabel, 0, 4, 1, 2);
     gridLayout->addWidget(replaceLabel, 1, 0);
     gridLayout->addWidget(m_replaceEdit, 1, 1);
     gridLayout->addWidget(m_replaceBtn, 1, 2);
@@ -187,6 +189,8 @@ void VFindReplaceDialog::openDialog(QString p_text)
 
 void VFindReplaceDialog::handleFindTextChanged(const QString &p_text)
 {
+    // Matches of the old text are stale.
+    m_matchLabel->clear();
     emit findTextChanged(p_text, m_options);
 }
 
@@ -301,3 +305,17 @@ void VFindReplaceDialog::updateState(DocType p_docType, bool p_editMode)
 
     m_replaceAvailable = p_editMode;
 }
+
+void VFindReplaceDialog::updateMatchCount(int p_current, int p_count)
+{
+    if (p_count < 0) {
+        m_matchLabel->clear();
+    } else if (p_count == 0) {
+        m_matchLabel->setText(tr("No match"));
+    } else if (p_current > 0) {
+        m_matchLabel->setText(tr("%1 of %2").arg(p_current).arg(p_count));
+    } else {
+        m_matchLabel->setText(tr("%1 %2").arg(p_count)
+                                         .arg(p_count > 1 ? tr("matches") : tr("match")));
+    }
+}
@@ -8,6 +8,7 @@
 class QLineEdit;
 class QPushButton;
 class QCheckBox;
+class QLabel;
 
 class VFindReplaceDialog : public QWidget
 {
@@ -41,6 +42,11 @@ public slots:
     void replaceFind();
     void replaceAll();
 
+    // Show the index of current match and the number of matches.
+    // @p_current: based on 1, or 0 if unknown.
+    // @p_count: -1 to clear.
+    void updateMatchCount(int p_current, int p_count);
+
 private slots:
     void handleFindTextChanged(const QString &p_text);
     void advancedBtnToggled(bool p_checked);
@@ -65,6 +71,7 @@ private:
     QCheckBox *m_wholeWordOnlyCheck;
     QCheckBox *m_regularExpressionCheck;
     QCheckBox *m_incrementalSearchCheck;
+    QLabel *m_matchLabel;
 };
 
 #endif // VFINDREPLACEDIALOG_H
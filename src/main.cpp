@@ -11,6 +11,7 @@
 #include "utils/vutils.h"
 #include "vsingleinstanceguard.h"
 #include "vconfigmanager.h"
+#include "vcommandlineexporter.h"
 
 VConfigManager *g_config;
 
@@ -93,6 +94,27 @@ void VLogger(QtMsgType type, const QMessageLogContext &context, const QString &m
 
 int main(int argc, char *argv[])
 {
+    QTextCodec *codec = QTextCodec::codecForName("UTF8");
+    if (codec) {
+        QTextCodec::setCodecForLocale(codec);
+    }
+
+    // Export notes from the command line without the main window.
+    if (VCommandLineExporter::isExportRequested(argc, argv)) {
+        // Use the offscreen platform to run on a machine without display.
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+
+        QApplication app(argc, argv);
+
+        VConfigManager vconfig;
+        vconfig.initialize();
+        g_config = &vconfig;
+
+        return VCommandLineExporter::run(app.arguments());
+    }
+
     VSingleInstanceGuard guard;
     bool canRun = guard.tryRun();
 
@@ -107,11 +129,6 @@ int main(int argc, char *argv[])
         qInstallMessageHandler(VLogger);
     }
 
-    QTextCodec *codec = QTextCodec::codecForName("UTF8");
-    if (codec) {
-        QTextCodec::setCodecForLocale(codec);
-    }
-
     QApplication app(argc, argv);
 
     // The file path passed via command line arguments.
@@ -56,8 +56,13 @@ var updateHtml = function(html) {
     }
 };
 
+// Return the highlighted HTML of @text.
+var highlightTextToHtml = function(text) {
+    return marked(text);
+};
+
 var highlightText = function(text, id, timeStamp) {
-    var html = marked(text);
+    var html = highlightTextToHtml(text);
     content.highlightTextCB(html, id, timeStamp);
 }
 
@@ -109,8 +109,13 @@ var updateText = function(text) {
     }
 };
 
+// Return the highlighted HTML of @text.
+var highlightTextToHtml = function(text) {
+    return mdit.render(text);
+};
+
 var highlightText = function(text, id, timeStamp) {
-    var html = mdit.render(text);
+    var html = highlightTextToHtml(text);
     content.highlightTextCB(html, id, timeStamp);
 }
 
@@ -47,10 +47,34 @@ new QWebChannel(qt.webChannelTransport,
 
         if (typeof highlightText == "function") {
             content.requestHighlightText.connect(highlightText);
+
+            if (typeof highlightTextToHtml == "function") {
+                content.requestHighlightTexts.connect(highlightTexts);
+            }
+
             content.noticeReadyToHighlightText();
         }
     });
 
+// @texts: array of {id, text} to highlight.
+// Highlight all of them and send back the results in one call.
+var highlightTexts = function(texts, timeStamp) {
+    var results = [];
+    for (var i = 0; i < texts.length; ++i) {
+        var item = texts[i];
+        var html = "";
+        try {
+            html = highlightTextToHtml(item.text);
+        } catch (err) {
+            content.setLog("err: " + err);
+        }
+
+        results.push({ id: item.id, html: html });
+    }
+
+    content.highlightTextsCB(results, timeStamp);
+};
+
 var VHighlightedAnchorClass = 'highlighted-anchor';
 
 var clearHighlightedAnchor = function() {
@@ -91,7 +91,8 @@ var updateText = function(text) {
     }
 };
 
-var highlightText = function(text, id, timeStamp) {
+// Return the highlighted HTML of @text.
+var highlightTextToHtml = function(text) {
     var html = renderer.makeHtml(text);
 
     var parser = new DOMParser();
@@ -102,6 +103,11 @@ var highlightText = function(text, id, timeStamp) {
 
     delete parser;
 
+    return html;
+};
+
+var highlightText = function(text, id, timeStamp) {
+    var html = highlightTextToHtml(text);
     content.highlightTextCB(html, id, timeStamp);
 }
 
@@ -71,7 +71,20 @@ SOURCES += main.cpp\
     vbuttonwithwidget.cpp \
     vtabindicator.cpp \
     dialog/vupdater.cpp \
-    dialog/vorphanfileinfodialog.cpp
+    dialog/vorphanfileinfodialog.cpp \
+    vbatchexporter.cpp \
+    vhtmlexporter.cpp \
+    vcommandlineexporter.cpp \
+    utils/vpdfmerger.cpp \
+    vsearchindex.cpp \
+    vsearchpanel.cpp \
+    vsearchindexer.cpp \
+    vgrepsearcher.cpp \
+    dialog/vfindinnotebookdialog.cpp \
+    vfilesaver.cpp \
+    veditjournal.cpp \
+    vdirconfigcache.cpp \
+    vtextsearcher.cpp
 
 HEADERS  += vmainwindow.h \
     vdirectorytree.h \
@@ -130,7 +143,20 @@ HEADERS  += vmainwindow.h \
     vedittabinfo.h \
     vtabindicator.h \
     dialog/vupdater.h \
-    dialog/vorphanfileinfodialog.h
+    dialog/vorphanfileinfodialog.h \
+    vbatchexporter.h \
+    vhtmlexporter.h \
+    vcommandlineexporter.h \
+    utils/vpdfmerger.h \
+    vsearchindex.h \
+    vsearchpanel.h \
+    vsearchindexer.h \
+    vgrepsearcher.h \
+    dialog/vfindinnotebookdialog.h \
+    vfilesaver.h \
+    veditjournal.h \
+    vdirconfigcache.h \
+    vtextsearcher.h
 
 RESOURCES += \
     vnote.qrc \
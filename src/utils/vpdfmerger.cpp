@@ -0,0 +1,872 @@
+#include "vpdfmerger.h"
+
+#include <QSet>
+#include <QRegularExpression>
+#include <QDebug>
+
+// Object numbers reserved for the merged PDF.
+enum ReservedObject
+{
+    CatalogObject = 1,
+    PagesObject = 2,
+    OutlinesObject = 3,
+    FirstFreeObject = 4
+};
+
+// Attributes a page could inherit from its ancestors in the page tree.
+static const char *c_inheritableKeys[] = {"Resources", "MediaBox", "CropBox", "Rotate"};
+
+static inline bool isWhiteChar(char p_ch)
+{
+    return p_ch == ' ' || p_ch == '\n' || p_ch == '\r'
+           || p_ch == '\t' || p_ch == '\f' || p_ch == '\0';
+}
+
+static inline bool isDelimiterChar(char p_ch)
+{
+    switch (p_ch) {
+    case '(':
+    case ')':
+    case '<':
+    case '>':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '/':
+    case '%':
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static inline bool isRegularChar(char p_ch)
+{
+    return !isWhiteChar(p_ch) && !isDelimiterChar(p_ch);
+}
+
+static bool isInteger(const QByteArray &p_token)
+{
+    if (p_token.isEmpty()) {
+        return false;
+    }
+
+    for (int i = 0; i < p_token.size(); ++i) {
+        if (p_token[i] < '0' || p_token[i] > '9') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Skip white spaces and comments from @p_idx.
+static int skipWhite(const QByteArray &p_data, int p_idx)
+{
+    int size = p_data.size();
+    while (p_idx < size) {
+        char ch = p_data[p_idx];
+        if (isWhiteChar(ch)) {
+            ++p_idx;
+        } else if (ch == '%') {
+            while (p_idx < size && p_data[p_idx] != '\n' && p_data[p_idx] != '\r') {
+                ++p_idx;
+            }
+        } else {
+            break;
+        }
+    }
+
+    return p_idx;
+}
+
+// Skip a literal string starting at @p_idx.
+static int skipLiteralString(const QByteArray &p_data, int p_idx)
+{
+    int size = p_data.size();
+    int depth = 0;
+    while (p_idx < size) {
+        char ch = p_data[p_idx++];
+        if (ch == '\\') {
+            ++p_idx;
+        } else if (ch == '(') {
+            ++depth;
+        } else if (ch == ')') {
+            if (--depth == 0) {
+                break;
+            }
+        }
+    }
+
+    return qMin(p_idx, size);
+}
+
+// Skip one object (or one token of it) starting at @p_idx.
+// References "N G R" are skipped token by token.
+static int skipObject(const QByteArray &p_data, int p_idx)
+{
+    int size = p_data.size();
+    if (p_idx >= size) {
+        return size;
+    }
+
+    char ch = p_data[p_idx];
+    if (ch == '<') {
+        if (p_idx + 1 < size && p_data[p_idx + 1] == '<') {
+            // Dictionary.
+            p_idx += 2;
+            while (true) {
+                p_idx = skipWhite(p_data, p_idx);
+                if (p_idx >= size) {
+                    return size;
+                }
+
+                if (p_data[p_idx] == '>' && p_idx + 1 < size && p_data[p_idx + 1] == '>') {
+                    return p_idx + 2;
+                }
+
+                p_idx = skipObject(p_data, p_idx);
+            }
+        }
+
+        // Hex string.
+        int end = p_data.indexOf('>', p_idx);
+        return end == -1 ? size : end + 1;
+    } else if (ch == '[') {
+        ++p_idx;
+        while (true) {
+            p_idx = skipWhite(p_data, p_idx);
+            if (p_idx >= size) {
+                return size;
+            }
+
+            if (p_data[p_idx] == ']') {
+                return p_idx + 1;
+            }
+
+            p_idx = skipObject(p_data, p_idx);
+        }
+    } else if (ch == '(') {
+        return skipLiteralString(p_data, p_idx);
+    } else if (ch == '/') {
+        ++p_idx;
+    } else if (isDelimiterChar(ch)) {
+        // Unbalanced delimiter.
+        return p_idx + 1;
+    }
+
+    while (p_idx < size && isRegularChar(p_data[p_idx])) {
+        ++p_idx;
+    }
+
+    return p_idx;
+}
+
+// Skip a value starting at @p_idx, treating "N G R" as one value.
+static int skipValue(const QByteArray &p_data, int p_idx)
+{
+    int end = skipObject(p_data, p_idx);
+    if (!isInteger(p_data.mid(p_idx, end - p_idx))) {
+        return end;
+    }
+
+    int genStart = skipWhite(p_data, end);
+    int genEnd = skipObject(p_data, genStart);
+    if (!isInteger(p_data.mid(genStart, genEnd - genStart))) {
+        return end;
+    }
+
+    int rIdx = skipWhite(p_data, genEnd);
+    if (rIdx < p_data.size()
+        && p_data[rIdx] == 'R'
+        && (rIdx + 1 == p_data.size() || !isRegularChar(p_data[rIdx + 1]))) {
+        return rIdx + 1;
+    }
+
+    return end;
+}
+
+// Read the next token from @p_idx and move @p_idx after it.
+static QByteArray readToken(const QByteArray &p_data, int &p_idx)
+{
+    int start = skipWhite(p_data, p_idx);
+    p_idx = skipObject(p_data, start);
+    return p_data.mid(start, p_idx - start);
+}
+
+// Find the entry of @p_key at the top level of dictionary @p_dict.
+static bool findDictEntry(const QByteArray &p_dict,
+                          const QByteArray &p_key,
+                          int &p_keyStart,
+                          int &p_valueStart,
+                          int &p_valueEnd)
+{
+    int size = p_dict.size();
+    int idx = skipWhite(p_dict, 0);
+    if (!p_dict.mid(idx, 2).startsWith("<<")) {
+        return false;
+    }
+
+    idx += 2;
+    while (true) {
+        idx = skipWhite(p_dict, idx);
+        if (idx >= size || (p_dict[idx] == '>' && p_dict.mid(idx, 2) == ">>")) {
+            return false;
+        }
+
+        if (p_dict[idx] != '/') {
+            // Malformed.
+            idx = skipObject(p_dict, idx);
+            continue;
+        }
+
+        int keyStart = idx;
+        int keyEnd = skipObject(p_dict, idx);
+        int valueStart = skipWhite(p_dict, keyEnd);
+        int valueEnd = skipValue(p_dict, valueStart);
+        if (p_dict.mid(keyStart + 1, keyEnd - keyStart - 1) == p_key) {
+            p_keyStart = keyStart;
+            p_valueStart = valueStart;
+            p_valueEnd = valueEnd;
+            return true;
+        }
+
+        idx = valueEnd;
+    }
+}
+
+// Insert @p_entries right after "<<" of dictionary @p_dict.
+static void insertDictEntries(QByteArray &p_dict, const QByteArray &p_entries)
+{
+    int idx = p_dict.indexOf("<<");
+    if (idx != -1) {
+        p_dict.insert(idx + 2, p_entries);
+    }
+}
+
+// Get object numbers of all the references in array @p_array.
+static QVector<int> refNumbers(const QByteArray &p_array)
+{
+    QVector<int> nums;
+    QList<QByteArray> tokens = QByteArray(p_array).replace('[', ' ')
+                                                  .replace(']', ' ')
+                                                  .simplified()
+                                                  .split(' ');
+    for (int i = 0; i + 2 < tokens.size(); ++i) {
+        if (tokens[i + 2] == "R" && isInteger(tokens[i]) && isInteger(tokens[i + 1])) {
+            nums.append(tokens[i].toInt());
+            i += 2;
+        }
+    }
+
+    return nums;
+}
+
+VPdfMerger::VPdfMerger()
+    : m_nextNum(FirstFreeObject)
+{
+}
+
+VPdfMerger::~VPdfMerger()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool VPdfMerger::begin(const QString &p_filePath)
+{
+    m_offsets.clear();
+    m_nextNum = FirstFreeObject;
+    m_pages.clear();
+    m_outline.clear();
+
+    m_file.setFileName(p_filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "fail to open file" << p_filePath << "to write";
+        return false;
+    }
+
+    // Binary comment to indicate the file contains binary data.
+    m_file.write("%PDF-1.7\n%\xE2\xE3\xCF\xD3\n");
+    return m_file.error() == QFile::NoError;
+}
+
+bool VPdfMerger::addFile(const QString &p_filePath, const QStringList &p_titlePath)
+{
+    Q_ASSERT(m_file.isOpen());
+
+    QHash<int, PdfObject> objects;
+    int root = 0;
+    {
+        QFile file(p_filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "fail to open PDF file" << p_filePath;
+            return false;
+        }
+
+        root = parseObjects(file.readAll(), objects);
+    }
+
+    if (root == 0) {
+        qWarning() << "fail to find the catalog of PDF file" << p_filePath;
+        return false;
+    }
+
+    int pagesNum = refNumber(dictValue(objects[root].m_body, "Pages"));
+    QVector<QPair<int, QHash<QByteArray, QByteArray>>> pages;
+    collectPages(pagesNum, objects, QHash<QByteArray, QByteArray>(), pages, 0);
+    if (pages.isEmpty()) {
+        qWarning() << "no page found in PDF file" << p_filePath;
+        return false;
+    }
+
+    QHash<int, QHash<QByteArray, QByteArray>> pageAttrs;
+    for (auto const &page : pages) {
+        pageAttrs.insert(page.first, page.second);
+    }
+
+    // New object number is @base + old number.
+    int base = m_nextNum - 1;
+    int maxNum = 0;
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        int num = it.key();
+        maxNum = qMax(maxNum, num);
+
+        // The catalog and page tree are replaced by ours.
+        if (num == root || dictType(it->m_body) == "Pages") {
+            continue;
+        }
+
+        QByteArray body = renumber(it->m_body, base);
+        auto attrIt = pageAttrs.constFind(num);
+        if (attrIt != pageAttrs.constEnd()) {
+            removeDictEntry(body, "Parent");
+
+            QByteArray entries = " /Parent " + QByteArray::number(PagesObject) + " 0 R";
+            for (auto ait = attrIt->constBegin(); ait != attrIt->constEnd(); ++ait) {
+                entries += " /" + ait.key() + " " + renumber(ait.value(), base);
+            }
+
+            insertDictEntries(body, entries);
+        }
+
+        writeObject(base + num, body, it->m_hasStream ? &it->m_stream : NULL);
+    }
+
+    m_nextNum = base + maxNum + 1;
+
+    for (auto const &page : pages) {
+        m_pages.append(base + page.first);
+    }
+
+    addOutlineItem(p_titlePath, base + pages.first().first);
+
+    return m_file.error() == QFile::NoError;
+}
+
+bool VPdfMerger::end()
+{
+    Q_ASSERT(m_file.isOpen());
+
+    // Page tree.
+    QByteArray kids;
+    for (auto num : m_pages) {
+        kids += QByteArray::number(num) + " 0 R ";
+    }
+
+    writeObject(PagesObject,
+                "<< /Type /Pages /Kids [" + kids.trimmed() + "] /Count "
+                + QByteArray::number(m_pages.size()) + " >>");
+
+    // Outline.
+    allocateOutline(m_outline);
+    int count = writeOutline(m_outline, OutlinesObject);
+    QByteArray outlines = "<< /Type /Outlines";
+    if (!m_outline.isEmpty()) {
+        outlines += " /First " + QByteArray::number(m_outline.first().m_objNum) + " 0 R"
+                    + " /Last " + QByteArray::number(m_outline.last().m_objNum) + " 0 R"
+                    + " /Count " + QByteArray::number(count);
+    }
+
+    outlines += " >>";
+    writeObject(OutlinesObject, outlines);
+
+    writeObject(CatalogObject,
+                "<< /Type /Catalog /Pages " + QByteArray::number(PagesObject) + " 0 R"
+                + " /Outlines " + QByteArray::number(OutlinesObject) + " 0 R"
+                + " /PageMode /UseOutlines >>");
+
+    // Cross-reference table.
+    qint64 xrefOffset = m_file.pos();
+    int size = m_nextNum;
+    if (m_offsets.size() < size) {
+        m_offsets.resize(size);
+    }
+
+    QByteArray xref = "xref\n0 " + QByteArray::number(size) + "\n";
+    xref += "0000000000 65535 f \n";
+    for (int i = 1; i < size; ++i) {
+        if (m_offsets[i] > 0) {
+            xref += QByteArray::number(m_offsets[i]).rightJustified(10, '0') + " 00000 n \n";
+        } else {
+            xref += "0000000000 65535 f \n";
+        }
+    }
+
+    xref += "trailer\n<< /Size " + QByteArray::number(size)
+            + " /Root " + QByteArray::number(CatalogObject) + " 0 R >>\n"
+            + "startxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    m_file.write(xref);
+
+    bool ret = m_file.error() == QFile::NoError && !m_pages.isEmpty();
+    m_file.close();
+    return ret;
+}
+
+int VPdfMerger::parseObjects(const QByteArray &p_data, QHash<int, PdfObject> &p_objects) const
+{
+    QHash<int, int> offsets;
+    QByteArray trailer;
+    if (!readXrefTables(p_data, offsets, trailer)) {
+        // Cross-reference streams or broken tables.
+        offsets.clear();
+        scanObjects(p_data, offsets);
+
+        trailer.clear();
+        int idx = p_data.lastIndexOf("trailer");
+        if (idx != -1) {
+            trailer = p_data.mid(idx + 7);
+        }
+    }
+
+    for (auto it = offsets.constBegin(); it != offsets.constEnd(); ++it) {
+        PdfObject obj;
+        if (parseObject(p_data, it.value(), offsets, obj)) {
+            p_objects.insert(it.key(), obj);
+        } else {
+            qWarning() << "fail to parse PDF object" << it.key();
+        }
+    }
+
+    int root = refNumber(dictValue(trailer, "Root"));
+    if (root > 0 && p_objects.contains(root)) {
+        return root;
+    }
+
+    for (auto it = p_objects.constBegin(); it != p_objects.constEnd(); ++it) {
+        if (dictType(it->m_body) == "Catalog") {
+            return it.key();
+        }
+    }
+
+    return 0;
+}
+
+bool VPdfMerger::readXrefTables(const QByteArray &p_data,
+                                QHash<int, int> &p_offsets,
+                                QByteArray &p_trailer) const
+{
+    int idx = p_data.lastIndexOf("startxref");
+    if (idx == -1) {
+        return false;
+    }
+
+    idx += 9;
+    int offset = readToken(p_data, idx).toInt();
+
+    QSet<int> visited;
+    while (offset > 0 && offset < p_data.size() && !visited.contains(offset)) {
+        visited.insert(offset);
+        if (p_data.mid(offset, 4) != "xref") {
+            return false;
+        }
+
+        idx = offset + 4;
+        while (true) {
+            idx = skipWhite(p_data, idx);
+            if (idx >= p_data.size()) {
+                return false;
+            }
+
+            if (p_data.mid(idx, 7) == "trailer") {
+                idx += 7;
+                break;
+            }
+
+            QByteArray start = readToken(p_data, idx);
+            QByteArray count = readToken(p_data, idx);
+            if (!isInteger(start) || !isInteger(count)) {
+                return false;
+            }
+
+            int startNum = start.toInt();
+            int countNum = count.toInt();
+            for (int i = 0; i < countNum; ++i) {
+                int entryOffset = readToken(p_data, idx).toInt();
+                readToken(p_data, idx);
+                QByteArray type = readToken(p_data, idx);
+                // Entries of later sections override those of previous ones.
+                if (type == "n" && entryOffset > 0 && !p_offsets.contains(startNum + i)) {
+                    p_offsets.insert(startNum + i, entryOffset);
+                }
+            }
+        }
+
+        int dictStart = skipWhite(p_data, idx);
+        QByteArray trailer = p_data.mid(dictStart, skipObject(p_data, dictStart) - dictStart);
+        if (p_trailer.isEmpty()) {
+            p_trailer = trailer;
+        }
+
+        offset = dictValue(trailer, "Prev").toInt();
+    }
+
+    return !p_offsets.isEmpty();
+}
+
+void VPdfMerger::scanObjects(const QByteArray &p_data, QHash<int, int> &p_offsets) const
+{
+    int size = p_data.size();
+    int pos = 0;
+    while ((pos = p_data.indexOf("obj", pos)) != -1) {
+        int end = pos + 3;
+        if (pos == 0 || !isWhiteChar(p_data[pos - 1]) || (end < size && isRegularChar(p_data[end]))) {
+            pos = end;
+            continue;
+        }
+
+        // Find "N G" before "obj".
+        int idx = pos - 1;
+        while (idx >= 0 && isWhiteChar(p_data[idx])) {
+            --idx;
+        }
+
+        int genEnd = idx + 1;
+        while (idx >= 0 && p_data[idx] >= '0' && p_data[idx] <= '9') {
+            --idx;
+        }
+
+        int genStart = idx + 1;
+        while (idx >= 0 && isWhiteChar(p_data[idx])) {
+            --idx;
+        }
+
+        int numEnd = idx + 1;
+        while (idx >= 0 && p_data[idx] >= '0' && p_data[idx] <= '9') {
+            --idx;
+        }
+
+        int numStart = idx + 1;
+        if (genStart == genEnd
+            || numStart == numEnd
+            || numEnd == genStart
+            || (idx >= 0 && isRegularChar(p_data[idx]))) {
+            pos = end;
+            continue;
+        }
+
+        // Later definitions override previous ones.
+        p_offsets.insert(p_data.mid(numStart, numEnd - numStart).toInt(), numStart);
+
+        // Skip the content of the object, especially the binary stream.
+        int streamIdx = p_data.indexOf("stream", end);
+        int endobjIdx = p_data.indexOf("endobj", end);
+        if (streamIdx != -1 && (endobjIdx == -1 || streamIdx < endobjIdx)) {
+            int endstreamIdx = p_data.indexOf("endstream", streamIdx + 6);
+            pos = endstreamIdx == -1 ? size : endstreamIdx + 9;
+        } else {
+            pos = endobjIdx == -1 ? size : endobjIdx + 6;
+        }
+    }
+}
+
+bool VPdfMerger::parseObject(const QByteArray &p_data,
+                             int p_offset,
+                             const QHash<int, int> &p_offsets,
+                             PdfObject &p_obj) const
+{
+    int idx = p_offset;
+    QByteArray num = readToken(p_data, idx);
+    QByteArray gen = readToken(p_data, idx);
+    if (!isInteger(num) || !isInteger(gen) || readToken(p_data, idx) != "obj") {
+        return false;
+    }
+
+    int bodyStart = idx;
+    int bodyEnd = skipObject(p_data, skipWhite(p_data, bodyStart));
+    int streamIdx = skipWhite(p_data, bodyEnd);
+    p_obj.m_body = p_data.mid(bodyStart, bodyEnd - bodyStart);
+    p_obj.m_hasStream = p_data.mid(streamIdx, 6) == "stream";
+    if (!p_obj.m_hasStream) {
+        return true;
+    }
+
+    // Stream data starts after the EOL following "stream".
+    int dataStart = streamIdx + 6;
+    if (dataStart < p_data.size() && p_data[dataStart] == '\r') {
+        ++dataStart;
+    }
+
+    if (dataStart < p_data.size() && p_data[dataStart] == '\n') {
+        ++dataStart;
+    }
+
+    int length = -1;
+    QByteArray lengthVal = dictValue(p_obj.m_body, "Length");
+    int lengthRef = refNumber(lengthVal);
+    if (lengthRef > 0) {
+        int lengthIdx = p_offsets.value(lengthRef, -1);
+        if (lengthIdx >= 0) {
+            readToken(p_data, lengthIdx);
+            readToken(p_data, lengthIdx);
+            if (readToken(p_data, lengthIdx) == "obj") {
+                QByteArray token = readToken(p_data, lengthIdx);
+                if (isInteger(token)) {
+                    length = token.toInt();
+                }
+            }
+        }
+    } else if (isInteger(lengthVal)) {
+        length = lengthVal.toInt();
+    }
+
+    if (length >= 0 && dataStart + length <= p_data.size()) {
+        int endIdx = skipWhite(p_data, dataStart + length);
+        if (p_data.mid(endIdx, 9) == "endstream") {
+            p_obj.m_stream = p_data.mid(dataStart, length);
+            return true;
+        }
+    }
+
+    // Invalid length. Search for the end of the stream.
+    int endIdx = p_data.indexOf("endstream", dataStart);
+    if (endIdx == -1) {
+        return false;
+    }
+
+    if (endIdx > dataStart && p_data[endIdx - 1] == '\n') {
+        --endIdx;
+    }
+
+    if (endIdx > dataStart && p_data[endIdx - 1] == '\r') {
+        --endIdx;
+    }
+
+    p_obj.m_stream = p_data.mid(dataStart, endIdx - dataStart);
+    return true;
+}
+
+void VPdfMerger::collectPages(int p_num,
+                              const QHash<int, PdfObject> &p_objects,
+                              QHash<QByteArray, QByteArray> p_inherited,
+                              QVector<QPair<int, QHash<QByteArray, QByteArray>>> &p_pages,
+                              int p_depth) const
+{
+    // Guard against cycles in broken files.
+    if (p_depth > 64) {
+        return;
+    }
+
+    auto it = p_objects.constFind(p_num);
+    if (it == p_objects.constEnd()) {
+        return;
+    }
+
+    const QByteArray &body = it->m_body;
+    QByteArray type = dictType(body);
+    if (type == "Pages") {
+        for (auto key : c_inheritableKeys) {
+            QByteArray val = dictValue(body, key);
+            if (!val.isEmpty()) {
+                p_inherited.insert(key, val);
+            }
+        }
+
+        QByteArray kids = dictValue(body, "Kids");
+        int kidsRef = refNumber(kids);
+        if (kidsRef > 0) {
+            kids = p_objects.value(kidsRef).m_body;
+        }
+
+        QVector<int> kidNums = refNumbers(kids);
+        for (auto num : kidNums) {
+            collectPages(num, p_objects, p_inherited, p_pages, p_depth + 1);
+        }
+    } else if (type == "Page") {
+        QHash<QByteArray, QByteArray> attrs;
+        for (auto key : c_inheritableKeys) {
+            if (p_inherited.contains(key) && dictValue(body, key).isEmpty()) {
+                attrs.insert(key, p_inherited.value(key));
+            }
+        }
+
+        p_pages.append(qMakePair(p_num, attrs));
+    }
+}
+
+void VPdfMerger::writeObject(int p_num, const QByteArray &p_body, const QByteArray *p_stream)
+{
+    if (m_offsets.size() <= p_num) {
+        m_offsets.resize(p_num + 1);
+    }
+
+    m_offsets[p_num] = m_file.pos();
+
+    QByteArray data = QByteArray::number(p_num) + " 0 obj\n";
+    if (p_stream) {
+        // The length may be an indirect object or be incorrect.
+        QByteArray dict = p_body.trimmed();
+        removeDictEntry(dict, "Length");
+        insertDictEntries(dict, " /Length " + QByteArray::number(p_stream->size()));
+
+        data += dict + "\nstream\n";
+        m_file.write(data);
+        m_file.write(*p_stream);
+        m_file.write("\nendstream\nendobj\n");
+    } else {
+        data += p_body.trimmed() + "\nendobj\n";
+        m_file.write(data);
+    }
+}
+
+void VPdfMerger::addOutlineItem(const QStringList &p_titlePath, int p_page)
+{
+    QVector<OutlineNode> *nodes = &m_outline;
+    for (int i = 0; i < p_titlePath.size(); ++i) {
+        const QString &title = p_titlePath[i];
+        OutlineNode *node = NULL;
+
+        // Group into the previous folder item with the same title.
+        bool isFolder = i < p_titlePath.size() - 1;
+        if (isFolder
+            && !nodes->isEmpty()
+            && nodes->last().m_title == title
+            && !nodes->last().m_children.isEmpty()) {
+            node = &nodes->last();
+        }
+
+        if (!node) {
+            OutlineNode newNode;
+            newNode.m_title = title;
+            newNode.m_page = p_page;
+            nodes->append(newNode);
+            node = &nodes->last();
+        }
+
+        nodes = &node->m_children;
+    }
+}
+
+void VPdfMerger::allocateOutline(QVector<OutlineNode> &p_nodes)
+{
+    for (auto &node : p_nodes) {
+        node.m_objNum = m_nextNum++;
+        allocateOutline(node.m_children);
+    }
+}
+
+int VPdfMerger::writeOutline(const QVector<OutlineNode> &p_nodes, int p_parent)
+{
+    int count = 0;
+    for (int i = 0; i < p_nodes.size(); ++i) {
+        const OutlineNode &node = p_nodes[i];
+        int childCount = writeOutline(node.m_children, node.m_objNum);
+
+        QByteArray body = "<< /Title " + textString(node.m_title)
+                          + " /Parent " + QByteArray::number(p_parent) + " 0 R";
+        if (i > 0) {
+            body += " /Prev " + QByteArray::number(p_nodes[i - 1].m_objNum) + " 0 R";
+        }
+
+        if (i < p_nodes.size() - 1) {
+            body += " /Next " + QByteArray::number(p_nodes[i + 1].m_objNum) + " 0 R";
+        }
+
+        if (!node.m_children.isEmpty()) {
+            body += " /First " + QByteArray::number(node.m_children.first().m_objNum) + " 0 R"
+                    + " /Last " + QByteArray::number(node.m_children.last().m_objNum) + " 0 R"
+                    + " /Count " + QByteArray::number(childCount);
+        }
+
+        body += " /Dest [" + QByteArray::number(node.m_page) + " 0 R /XYZ null null null] >>";
+        writeObject(node.m_objNum, body);
+
+        count += 1 + childCount;
+    }
+
+    return count;
+}
+
+QByteArray VPdfMerger::renumber(const QByteArray &p_body, int p_base)
+{
+    static const QRegularExpression refExp("(?<![\\w.])(\\d+)\\s+(\\d+)\\s+R(?!\\w)");
+
+    QString body = QString::fromLatin1(p_body);
+    QString result;
+    result.reserve(body.size() + 16);
+
+    int lastEnd = 0;
+    QRegularExpressionMatchIterator it = refExp.globalMatch(body);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        result += body.midRef(lastEnd, match.capturedStart() - lastEnd);
+        result += QString("%1 %2 R").arg(match.captured(1).toInt() + p_base)
+                                    .arg(match.captured(2));
+        lastEnd = match.capturedEnd();
+    }
+
+    result += body.midRef(lastEnd);
+    return result.toLatin1();
+}
+
+QByteArray VPdfMerger::dictValue(const QByteArray &p_dict, const QByteArray &p_key)
+{
+    int keyStart, valueStart, valueEnd;
+    if (findDictEntry(p_dict, p_key, keyStart, valueStart, valueEnd)) {
+        return p_dict.mid(valueStart, valueEnd - valueStart);
+    }
+
+    return QByteArray();
+}
+
+void VPdfMerger::removeDictEntry(QByteArray &p_dict, const QByteArray &p_key)
+{
+    int keyStart, valueStart, valueEnd;
+    if (findDictEntry(p_dict, p_key, keyStart, valueStart, valueEnd)) {
+        p_dict.remove(keyStart, valueEnd - keyStart);
+    }
+}
+
+QByteArray VPdfMerger::dictType(const QByteArray &p_dict)
+{
+    QByteArray type = dictValue(p_dict, "Type");
+    if (type.startsWith('/')) {
+        return type.mid(1);
+    }
+
+    return QByteArray();
+}
+
+int VPdfMerger::refNumber(const QByteArray &p_ref)
+{
+    QList<QByteArray> tokens = p_ref.simplified().split(' ');
+    if (tokens.size() == 3 && tokens[2] == "R" && isInteger(tokens[0])) {
+        return tokens[0].toInt();
+    }
+
+    return 0;
+}
+
+QByteArray VPdfMerger::textString(const QString &p_text)
+{
+    QByteArray str = "<FEFF";
+    for (auto const &ch : p_text) {
+        str += QByteArray::number(ch.unicode(), 16).rightJustified(4, '0').toUpper();
+    }
+
+    str += ">";
+    return str;
+}
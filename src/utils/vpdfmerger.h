@@ -0,0 +1,148 @@
+#ifndef VPDFMERGER_H
+#define VPDFMERGER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QFile>
+
+// Merge multiple PDF files into one PDF file incrementally with an outline.
+// Each input file is read, renumbered and written to the output one by one,
+// so only one input file is held in memory at a time.
+// Only PDF files with classic cross-reference tables are fully supported,
+// such as those generated by QWebEnginePage::printToPdf().
+class VPdfMerger
+{
+public:
+    VPdfMerger();
+
+    ~VPdfMerger();
+
+    // Start to write the merged PDF to @p_filePath.
+    bool begin(const QString &p_filePath);
+
+    // Append all the pages of @p_filePath to the merged PDF.
+    // @p_titlePath: the path of the outline item pointing to the first page
+    // of @p_filePath. Such as {"chapter", "section", "note"}. Items with the
+    // same parent path will be grouped together.
+    bool addFile(const QString &p_filePath, const QStringList &p_titlePath);
+
+    // Write the page tree, outline and cross-reference table and finish.
+    bool end();
+
+    // Number of pages merged.
+    int pageCount() const;
+
+private:
+    // A node of the outline.
+    struct OutlineNode
+    {
+        OutlineNode() : m_page(0), m_objNum(0)
+        {
+        }
+
+        QString m_title;
+
+        // Object number of the destination page.
+        int m_page;
+
+        // Object number of this outline item.
+        int m_objNum;
+
+        QVector<OutlineNode> m_children;
+    };
+
+    // An indirect object in an input file.
+    struct PdfObject
+    {
+        PdfObject() : m_hasStream(false)
+        {
+        }
+
+        // Content between "obj" and "stream" (or "endobj" if no stream).
+        QByteArray m_body;
+
+        bool m_hasStream;
+
+        // Raw data of the stream.
+        QByteArray m_stream;
+    };
+
+    // Parse all the indirect objects of @p_data into @p_objects.
+    // Returns the object number of the catalog or 0 if failed.
+    int parseObjects(const QByteArray &p_data, QHash<int, PdfObject> &p_objects) const;
+
+    // Read the offsets of objects from the cross-reference tables.
+    bool readXrefTables(const QByteArray &p_data,
+                        QHash<int, int> &p_offsets,
+                        QByteArray &p_trailer) const;
+
+    // Scan the whole @p_data for objects without cross-reference tables.
+    void scanObjects(const QByteArray &p_data, QHash<int, int> &p_offsets) const;
+
+    bool parseObject(const QByteArray &p_data,
+                     int p_offset,
+                     const QHash<int, int> &p_offsets,
+                     PdfObject &p_obj) const;
+
+    // Collect the page objects of the page tree node @p_num in order.
+    // @p_inherited: inheritable attributes from ancestors.
+    void collectPages(int p_num,
+                      const QHash<int, PdfObject> &p_objects,
+                      QHash<QByteArray, QByteArray> p_inherited,
+                      QVector<QPair<int, QHash<QByteArray, QByteArray>>> &p_pages,
+                      int p_depth) const;
+
+    void writeObject(int p_num, const QByteArray &p_body,
+                     const QByteArray *p_stream = NULL);
+
+    void addOutlineItem(const QStringList &p_titlePath, int p_page);
+
+    // Allocate object numbers of @p_nodes and their children.
+    void allocateOutline(QVector<OutlineNode> &p_nodes);
+
+    // Write @p_nodes with parent @p_parent. Returns the number of descendants.
+    int writeOutline(const QVector<OutlineNode> &p_nodes, int p_parent);
+
+    // Replace object references "N G R" in @p_body with @p_base + N.
+    static QByteArray renumber(const QByteArray &p_body, int p_base);
+
+    // Get the value of @p_key in dictionary @p_dict.
+    // Returns empty if not found.
+    static QByteArray dictValue(const QByteArray &p_dict, const QByteArray &p_key);
+
+    // Remove @p_key and its value in dictionary @p_dict.
+    static void removeDictEntry(QByteArray &p_dict, const QByteArray &p_key);
+
+    // Get the type of dictionary @p_dict, such as "Page".
+    static QByteArray dictType(const QByteArray &p_dict);
+
+    // Get object number of reference "N G R" in @p_ref.
+    static int refNumber(const QByteArray &p_ref);
+
+    // Encode @p_text as a PDF text string in UTF-16BE.
+    static QByteArray textString(const QString &p_text);
+
+    QFile m_file;
+
+    // Object number -> offset in the output file.
+    QVector<qint64> m_offsets;
+
+    // Next available object number.
+    int m_nextNum;
+
+    // Object numbers of all the pages in order.
+    QVector<int> m_pages;
+
+    QVector<OutlineNode> m_outline;
+};
+
+inline int VPdfMerger::pageCount() const
+{
+    return m_pages.size();
+}
+
+#endif // VPDFMERGER_H
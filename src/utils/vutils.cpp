@@ -53,12 +53,31 @@ void VUtils::initAvailableLanguage()
 QString VUtils::readFileFromDisk(const QString &filePath)
 {
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "fail to read file" << filePath;
         return QString();
     }
-    QString fileText(file.readAll());
+
+    // Map the file and decode it directly instead of copying it into a buffer
+    // first. Fall back to reading if mapping is not supported.
+    QString fileText;
+    qint64 size = file.size();
+    uchar *data = size > 0 ? file.map(0, size) : NULL;
+    if (data) {
+        fileText = QString::fromUtf8(reinterpret_cast<const char *>(data), size);
+        file.unmap(data);
+    } else {
+        fileText = QString::fromUtf8(file.readAll());
+    }
+
     file.close();
+
+    // Translate the end-of-line terminators only when needed, which
+    // QIODevice::Text would do for every read.
+    if (fileText.contains(QChar('\r'))) {
+        fileText.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    }
+
     qDebug() << "read file content:" << filePath;
     return fileText;
 }
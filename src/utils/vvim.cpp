@@ -21,6 +21,8 @@ const QChar VVim::c_selectionRegister = QChar('+');
 
 const int VVim::SearchHistory::c_capacity = 50;
 
+const int VVim::c_maxReplayDepth = 10;
+
 #define ADDKEY(x, y) case (x): {ch = (y); break;}
 
 // See if @p_modifiers is Control which is different on macOs and Windows.
@@ -91,6 +93,40 @@ static QChar keyToChar(int p_key, int p_modifiers)
     return ch;
 }
 
+// Map @p_char to the key press typing it on a US keyboard.
+// Returns false if there is no such key.
+static bool charToKey(QChar p_char, int &p_key, int &p_modifiers)
+{
+    static const QString shiftChars("~!@#$%^&*()_+{}|:\"<>?");
+
+    ushort uc = p_char.unicode();
+    p_modifiers = Qt::NoModifier;
+    if (uc == '\t') {
+        p_key = Qt::Key_Tab;
+    } else if (uc == '\n') {
+        p_key = Qt::Key_Return;
+    } else if (uc == 0x1b) {
+        p_key = Qt::Key_Escape;
+    } else if (uc == 0x08) {
+        p_key = Qt::Key_Backspace;
+    } else if (uc < 0x20 || uc > 0x7e) {
+        return false;
+    } else if (uc >= 'a' && uc <= 'z') {
+        p_key = Qt::Key_A + (uc - 'a');
+    } else if (uc >= 'A' && uc <= 'Z') {
+        p_key = Qt::Key_A + (uc - 'A');
+        p_modifiers = Qt::ShiftModifier;
+    } else {
+        // Qt::Key of printable ASCII characters equals to their codes.
+        p_key = uc;
+        if (shiftChars.contains(p_char)) {
+            p_modifiers = Qt::ShiftModifier;
+        }
+    }
+
+    return true;
+}
+
 static QString keyToString(int p_key, int p_modifiers)
 {
     QChar ch = keyToChar(p_key, p_modifiers);
@@ -105,12 +141,52 @@ static QString keyToString(int p_key, int p_modifiers)
     }
 }
 
+// Text of the key triggering a command line of type @p_type.
+static QChar commandLinePrefix(VVim::CommandLineType p_type)
+{
+    switch (p_type) {
+    case VVim::CommandLineType::Command:
+        return ':';
+
+    case VVim::CommandLineType::SearchForward:
+        return '/';
+
+    case VVim::CommandLineType::SearchBackward:
+        return '?';
+
+    default:
+        return QChar();
+    }
+}
+
+// Text of a key in a macro saved in a register.
+static QString keyToMacroText(int p_key, int p_modifiers)
+{
+    switch (p_key) {
+    case Qt::Key_Escape:
+        return QString(QChar(0x1b));
+
+    case Qt::Key_Return:
+        // Fall through.
+    case Qt::Key_Enter:
+        return QString("\n");
+
+    case Qt::Key_Backspace:
+        return QString(QChar(0x08));
+
+    default:
+        return keyToString(p_key, p_modifiers);
+    }
+}
+
 VVim::VVim(VEdit *p_editor)
     : QObject(p_editor), m_editor(p_editor),
       m_editConfig(&p_editor->getConfig()), m_mode(VimMode::Invalid),
       m_resetPositionInBlock(true), m_regName(c_unnamedRegister),
       m_leaderKey(Key(Qt::Key_Space)), m_replayLeaderSequence(false),
-      m_registerPending(false)
+      m_registerPending(false), m_replayDepth(0), m_changeRecorded(false),
+      m_repeatingChange(false), m_pendingCommandLine(CommandLineType::Invalid),
+      m_insertStart(-1), m_insertEnd(-1)
 {
     Q_ASSERT(m_editConfig->m_enableVimMode);
 
@@ -120,6 +196,9 @@ VVim::VVim(VEdit *p_editor)
 
     connect(m_editor, &VEdit::selectionChangedByMouse,
             this, &VVim::selectionToVisualMode);
+
+    connect(m_editor->document(), &QTextDocument::contentsChange,
+            this, &VVim::handleContentsChange);
 }
 
 // Set @p_cursor's position specified by @p_positionInBlock.
@@ -519,6 +598,24 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
     bool unindent = false;
     int autoIndentPos = -1;
 
+    bool modifierKey = key == Qt::Key_Control
+                       || key == Qt::Key_Shift
+                       || key == Qt::Key_Meta
+                       || key == Qt::Key_Alt;
+
+    // Record the key into current macro. Keys typed in Insert mode are
+    // recorded as the text of the session instead.
+    if (!m_macroRegister.isNull()
+        && m_replayDepth == 0
+        && !modifierKey
+        && m_mode != VimMode::Insert) {
+        m_macroEntries.append(keyInfo);
+    }
+
+    VimMode modeBefore = m_mode;
+    QList<Key> keysBefore = m_keys;
+    m_changeRecorded = false;
+
     // Handle Insert mode key press.
     if (VimMode::Insert == m_mode) {
         if (key == Qt::Key_Escape
@@ -636,6 +733,40 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
         goto clear_accept;
     }
 
+    if (expectingMacroRegister()) {
+        // Expecting a register name to record a macro into.
+        QChar reg = keyToRegisterName(keyInfo);
+        if (!reg.isNull()
+            && (m_registers[reg].isNamedRegister() || m_registers[reg].isUnnamedRegister())) {
+            startRecordingMacro(reg, modifiers == Qt::ShiftModifier);
+        }
+
+        goto clear_accept;
+    }
+
+    if (expectingMacroToReplay()) {
+        // Expecting a register name of the macro to replay.
+        int repeat = 1;
+        if (hasRepeatToken()) {
+            repeat = getRepeatToken()->m_repeat;
+        }
+
+        QChar reg;
+        if (keyInfo == Key(Qt::Key_At, Qt::ShiftModifier)) {
+            // @@, replay last macro.
+            reg = m_lastMacroRegister;
+        } else {
+            reg = keyToRegisterName(keyInfo);
+        }
+
+        resetState();
+        if (!reg.isNull()) {
+            replayMacro(reg, repeat);
+        }
+
+        goto clear_accept;
+    }
+
     if (expectingMarkTarget()) {
         // Expecting a mark name as the target.
         Movement mm = Movement::Invalid;
@@ -1896,7 +2027,7 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
             if (m_keys.isEmpty()
                 && m_tokens.isEmpty()
                 && checkMode(VimMode::Normal)) {
-                emit commandLineTriggered(CommandLineType::Command);
+                triggerCommandLine(CommandLineType::Command);
             }
         }
 
@@ -1939,6 +2070,59 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
         break;
     }
 
+    case Qt::Key_Q:
+    {
+        if (modifiers == Qt::NoModifier && m_replayDepth == 0) {
+            if (m_keys.isEmpty() && m_tokens.isEmpty()) {
+                if (!m_macroRegister.isNull()) {
+                    // q, stop recording the macro.
+                    stopRecordingMacro();
+                    goto clear_accept;
+                }
+
+                // q, start recording a macro.
+                m_keys.append(keyInfo);
+                goto accept;
+            }
+        }
+
+        break;
+    }
+
+    case Qt::Key_Period:
+    {
+        if (modifiers == Qt::NoModifier && checkMode(VimMode::Normal)) {
+            tryGetRepeatToken(m_keys, m_tokens);
+            if (m_keys.isEmpty() && !hasActionToken()) {
+                // ., repeat last change.
+                int repeat = -1;
+                if (hasRepeatToken()) {
+                    repeat = getRepeatToken()->m_repeat;
+                }
+
+                resetState();
+                repeatLastChange(repeat);
+                goto clear_accept;
+            }
+        }
+
+        break;
+    }
+
+    case Qt::Key_At:
+    {
+        if (modifiers == Qt::ShiftModifier) {
+            tryGetRepeatToken(m_keys, m_tokens);
+            if (m_keys.isEmpty() && !hasActionToken()) {
+                // @, replay a macro.
+                m_keys.append(keyInfo);
+                goto accept;
+            }
+        }
+
+        break;
+    }
+
     case Qt::Key_M:
     {
         if (modifiers == Qt::NoModifier) {
@@ -2114,7 +2298,7 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
             if (m_tokens.isEmpty()
                 && m_keys.isEmpty()
                 && checkMode(VimMode::Normal)) {
-                emit commandLineTriggered(CommandLineType::SearchForward);
+                triggerCommandLine(CommandLineType::SearchForward);
             }
         }
 
@@ -2127,7 +2311,7 @@ bool VVim::handleKeyPressEvent(int key, int modifiers, int *p_autoIndentPos)
             if (m_tokens.isEmpty()
                 && m_keys.isEmpty()
                 && checkMode(VimMode::Normal)) {
-                emit commandLineTriggered(CommandLineType::SearchBackward);
+                triggerCommandLine(CommandLineType::SearchBackward);
             }
         }
 
@@ -2211,6 +2395,8 @@ accept:
 
 exit:
     m_resetPositionInBlock = resetPositionInBlock;
+    updateInsertSession(modeBefore, keyInfo);
+    updateLastChange(modeBefore, keysBefore, keyInfo);
     emit vimStatusUpdated(this);
     return ret;
 }
@@ -2259,6 +2445,8 @@ void VVim::processCommand(QList<Token> &p_tokens)
 
     V_ASSERT(p_tokens.at(0).isAction());
 
+    recordLastChange(p_tokens);
+
     Token act = p_tokens.takeFirst();
     switch (act.m_action) {
     case Action::Move:
@@ -3024,12 +3212,11 @@ handle_target:
         m_locations.addLocation(p_cursor);
 
         const SearchItem &item = m_searchHistory.lastItem();
-        while (--p_repeat >= 0) {
-            hasMoved = m_editor->findText(item.m_text, item.m_options,
-                                          forward ? item.m_forward : !item.m_forward,
-                                          &p_cursor, p_moveMode);
-        }
-
+        hasMoved = findSearchItem(item,
+                                  forward ? item.m_forward : !item.m_forward,
+                                  p_repeat,
+                                  &p_cursor,
+                                  p_moveMode);
         break;
     }
 
@@ -3086,14 +3273,12 @@ handle_target:
         item.m_rawStr = text;
         item.m_text = text;
         item.m_forward = forward;
+        item.compile();
 
         m_searchHistory.addItem(item);
         m_searchHistory.resetIndex();
-        while (--p_repeat >= 0) {
-            hasMoved = m_editor->findText(item.m_text, item.m_options,
-                                          item.m_forward,
-                                          &p_cursor, p_moveMode);
-        }
+        hasMoved = findSearchItem(item, item.m_forward, p_repeat,
+                                  &p_cursor, p_moveMode);
 
         Q_ASSERT(hasMoved);
 
@@ -4748,6 +4933,16 @@ bool VVim::expectingMarkName() const
     return checkPendingKey(Key(Qt::Key_M)) && m_tokens.isEmpty();
 }
 
+bool VVim::expectingMacroRegister() const
+{
+    return checkPendingKey(Key(Qt::Key_Q)) && m_tokens.isEmpty();
+}
+
+bool VVim::expectingMacroToReplay() const
+{
+    return checkPendingKey(Key(Qt::Key_At, Qt::ShiftModifier)) && !hasActionToken();
+}
+
 bool VVim::expectingMarkTarget() const
 {
     return checkPendingKey(Key(Qt::Key_Apostrophe))
@@ -5136,6 +5331,11 @@ bool VVim::checkMode(VimMode p_mode)
 
 bool VVim::processCommandLine(VVim::CommandLineType p_type, const QString &p_cmd)
 {
+    if (!m_macroRegister.isNull() && m_replayDepth == 0) {
+        dropCommandLineTrigger();
+        m_macroEntries.append(MacroEntry(p_type, p_cmd));
+    }
+
     setMode(VimMode::Normal);
 
     bool ret = false;
@@ -5149,7 +5349,7 @@ bool VVim::processCommandLine(VVim::CommandLineType p_type, const QString &p_cmd
     case CommandLineType::SearchBackward:
     {
         SearchItem item = fetchSearchItem(p_type, p_cmd);
-        m_editor->findText(item.m_text, item.m_options, item.m_forward);
+        findSearchItem(item, item.m_forward, 1);
         m_searchHistory.addItem(item);
         m_searchHistory.resetIndex();
         break;
@@ -5177,6 +5377,10 @@ void VVim::processCommandLineChanged(VVim::CommandLineType p_type,
 
 void VVim::processCommandLineCancelled()
 {
+    if (!m_macroRegister.isNull() && m_replayDepth == 0) {
+        dropCommandLineTrigger();
+    }
+
     m_searchHistory.resetIndex();
     m_editor->clearIncrementalSearchedWordHighlight();
 }
@@ -5198,10 +5402,38 @@ VVim::SearchItem VVim::fetchSearchItem(VVim::CommandLineType p_type,
     }
 
     item.m_options |= FindOption::RegularExpression;
+    item.compile();
 
     return item;
 }
 
+bool VVim::findSearchItem(const SearchItem &p_item, bool p_forward, int p_repeat,
+                          QTextCursor *p_cursor, QTextCursor::MoveMode p_moveMode)
+{
+    Q_ASSERT(p_repeat > 0);
+    int position = p_cursor ? p_cursor->position() : m_editor->textCursor().position();
+    bool wrapped = false;
+    VTextMatch match;
+    while (--p_repeat >= 0) {
+        bool matchWrapped = false;
+        if (!m_editor->findMatch(p_item.m_text, p_item.m_options, p_forward,
+                                 p_forward ? position + 1 : position,
+                                 matchWrapped, match)) {
+            // Let the editor clear the highlight and report it.
+            return m_editor->findText(p_item.m_text, p_item.m_options, p_forward,
+                                      p_cursor, p_moveMode);
+        }
+
+        wrapped = wrapped || matchWrapped;
+        position = match.m_start;
+    }
+
+    m_editor->jumpToMatch(p_item.m_text, p_item.m_options,
+                          match.m_start, match.m_start + match.m_length,
+                          wrapped, p_cursor, p_moveMode);
+    return true;
+}
+
 bool VVim::executeCommand(const QString &p_cmd)
 {
     bool validCommand = true;
@@ -5274,6 +5506,10 @@ bool VVim::executeCommand(const QString &p_cmd)
         }
     }
 
+    if (!validCommand) {
+        validCommand = executeRangeCommand(p_cmd, msg);
+    }
+
     if (!validCommand) {
         message(tr("Not an editor command: %1").arg(p_cmd));
     } else {
@@ -5283,157 +5519,1132 @@ bool VVim::executeCommand(const QString &p_cmd)
     return validCommand;
 }
 
-bool VVim::hasNonDigitPendingKeys(const QList<Key> &p_keys)
+// Whether @p_name is an abbreviation of command @p_command of at least
+// @p_minLength characters.
+static bool isCommandName(const QString &p_name, const QString &p_command, int p_minLength)
 {
-    for (auto const &key : p_keys) {
-        if (!key.isDigit()) {
-            return true;
+    return p_name.size() >= p_minLength && p_command.startsWith(p_name);
+}
+
+// Read the text at @p_idx of @p_str till an unescaped @p_delim, and move
+// @p_idx after the delimiter.
+// Escaped @p_delim is unescaped while other escapes are kept.
+static QString readDelimitedText(const QString &p_str, int &p_idx, QChar p_delim)
+{
+    QString text;
+    while (p_idx < p_str.size()) {
+        QChar ch = p_str[p_idx++];
+        if (ch == p_delim) {
+            break;
+        } else if (ch == '\\' && p_idx < p_str.size()) {
+            QChar next = p_str[p_idx++];
+            if (next != p_delim) {
+                text.append(ch);
+            }
+
+            text.append(next);
+        } else {
+            text.append(ch);
         }
     }
 
-    return false;
+    return text;
 }
 
-bool VVim::hasNonDigitPendingKeys()
+// Whether @p_char could be the delimiter of a pattern in a command.
+static bool isPatternDelimiter(QChar p_char)
 {
-    return hasNonDigitPendingKeys(m_keys);
+    return !p_char.isLetterOrNumber()
+           && !p_char.isSpace()
+           && p_char != '\\'
+           && p_char != '"'
+           && p_char != '|';
 }
 
-bool VVim::processLeaderSequence(const Key &p_key)
+// Expand the {string} of :substitute for @p_match.
+// & and \0 for the whole match, \1 - \9 for the captured groups, \r and \n
+// for a line break, \t for a tab.
+static QString expandReplacement(const QString &p_replace, const QRegularExpressionMatch &p_match)
 {
-    // Different from Vim:
-    // If it is not a valid sequence, we just do nothing here.
-    V_ASSERT(checkPendingKey(Key(Qt::Key_Backslash)));
-    bool validSequence = true;
-    QList<Key> replaySeq;
+    QString text;
+    for (int i = 0; i < p_replace.size(); ++i) {
+        QChar ch = p_replace[i];
+        if (ch == '&') {
+            text.append(p_match.captured(0));
+        } else if (ch == '\\' && i + 1 < p_replace.size()) {
+            QChar next = p_replace[++i];
+            if (next.isDigit()) {
+                text.append(p_match.captured(next.digitValue()));
+            } else if (next == 'r' || next == 'n') {
+                text.append('\n');
+            } else if (next == 't') {
+                text.append('\t');
+            } else {
+                text.append(next);
+            }
+        } else {
+            text.append(ch);
+        }
+    }
 
-    if (p_key == Key(Qt::Key_Y)) {
-        // <leader>y, "+y
-        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_Y));
-    } else if (p_key == Key(Qt::Key_D)) {
-        // <leader>d, "+d
-        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_D));
-    } else if (p_key == Key(Qt::Key_P)) {
-        // <leader>p, "+p
-        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_P));
-    } else if (p_key == Key(Qt::Key_P, Qt::ShiftModifier)) {
-        // <leader>P, "+P
-        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
-        replaySeq.append(Key(Qt::Key_P, Qt::ShiftModifier));
-    } else if (p_key == Key(Qt::Key_Space)) {
-        // <leader><space>, clear search highlight
-        clearSearchHighlight();
-    } else {
-        validSequence = false;
+    return text;
+}
+
+int VVim::parseLineAddress(const QString &p_cmd, int &p_idx)
+{
+    const QTextDocument *doc = m_editor->document();
+    int curBlock = m_editor->textCursor().block().blockNumber();
+    int blockNum = -1;
+    int idx = p_idx;
+    if (idx < p_cmd.size()) {
+        QChar ch = p_cmd[idx];
+        if (ch.isDigit()) {
+            int end = idx;
+            while (end < p_cmd.size() && p_cmd[end].isDigit()) {
+                ++end;
+            }
+
+            blockNum = qMax(p_cmd.mid(idx, end - idx).toInt() - 1, 0);
+            idx = end;
+        } else if (ch == '.') {
+            blockNum = curBlock;
+            ++idx;
+        } else if (ch == '$') {
+            blockNum = doc->blockCount() - 1;
+            ++idx;
+        } else if (ch == '\'' && idx + 1 < p_cmd.size()) {
+            Location loc = m_marks.getMarkLocation(p_cmd[idx + 1]);
+            if (!loc.isValid()) {
+                return -2;
+            }
+
+            blockNum = loc.m_blockNumber;
+            idx += 2;
+        }
     }
 
-    if (!replaySeq.isEmpty()) {
-        // Replay the sequence.
-        m_replayLeaderSequence = true;
-        m_keys.clear();
-        for (int i = 0; i < 2; ++i) {
-            m_pendingKeys.pop_back();
+    // Offsets.
+    while (idx < p_cmd.size() && (p_cmd[idx] == '+' || p_cmd[idx] == '-')) {
+        if (blockNum == -1) {
+            blockNum = curBlock;
         }
 
-        for (auto const &key : replaySeq) {
-            bool ret = handleKeyPressEvent(key.m_key, key.m_modifiers);
-            if (!ret) {
-                break;
-            }
+        bool plus = p_cmd[idx] == '+';
+        int end = ++idx;
+        while (end < p_cmd.size() && p_cmd[end].isDigit()) {
+            ++end;
         }
 
-        m_replayLeaderSequence = false;
-    } else {
-        resetState();
+        int offset = end > idx ? p_cmd.mid(idx, end - idx).toInt() : 1;
+        blockNum += plus ? offset : -offset;
+        idx = end;
     }
 
-    return validSequence;
-}
+    p_idx = idx;
+    if (blockNum == -1) {
+        return -1;
+    }
 
-VVim::LocationStack::LocationStack(int p_maximum)
-    : m_pointer(0), c_maximumLocations(p_maximum < 10 ? 10 : p_maximum)
-{
-}
+    if (blockNum < 0 || blockNum >= doc->blockCount()) {
+        return -2;
+    }
 
-bool VVim::LocationStack::hasPrevious() const
-{
-    return m_pointer > 0;
+    return blockNum;
 }
 
-bool VVim::LocationStack::hasNext() const
+bool VVim::executeRangeCommand(const QString &p_cmd, QString &p_msg)
 {
-    return m_pointer < m_locations.size() - 1;
-}
+    int blockCount = m_editor->document()->blockCount();
+    int idx = 0;
+    int first = -1, last = -1;
+    if (p_cmd.startsWith('%')) {
+        first = 0;
+        last = blockCount - 1;
+        idx = 1;
+    } else {
+        first = last = parseLineAddress(p_cmd, idx);
+        if (first > -1 && idx < p_cmd.size() && p_cmd[idx] == ',') {
+            ++idx;
+            last = parseLineAddress(p_cmd, idx);
+            if (last == -1) {
+                last = -2;
+            }
+        }
 
-void VVim::LocationStack::addLocation(const QTextCursor &p_cursor)
-{
-    int blockNumber = p_cursor.block().blockNumber();
-    int pib = p_cursor.positionInBlock();
+        if (first == -2 || last == -2) {
+            p_msg = tr("Invalid range");
+            return true;
+        }
 
-    // Remove older location with the same block number.
-    for (auto it = m_locations.begin(); it != m_locations.end();) {
-        if (it->m_blockNumber == blockNumber) {
-            it = m_locations.erase(it);
-            break;
-        } else {
-            ++it;
+        if (first > last) {
+            qSwap(first, last);
         }
     }
 
-    if (m_locations.size() >= c_maximumLocations) {
-        m_locations.removeFirst();
+    while (idx < p_cmd.size() && p_cmd[idx].isSpace()) {
+        ++idx;
     }
 
-    m_locations.append(Location(blockNumber, pib));
-
-    m_pointer = m_locations.size();
+    int nameEnd = idx;
+    while (nameEnd < p_cmd.size() && p_cmd[nameEnd].isLetter()) {
+        ++nameEnd;
+    }
 
-    qDebug() << QString("add location (%1,%2), pointer=%3")
-                       .arg(blockNumber).arg(pib).arg(m_pointer);
-}
+    QString name = p_cmd.mid(idx, nameEnd - idx);
+    QString args = p_cmd.mid(nameEnd);
+    if (name.isEmpty()) {
+        return false;
+    }
 
-const VVim::Location &VVim::LocationStack::previousLocation(const QTextCursor &p_cursor)
-{
-    V_ASSERT(hasPrevious());
-    if (m_pointer == m_locations.size()) {
-        // Add current location to the stack.
-        addLocation(p_cursor);
+    bool inverse = isCommandName(name, "vglobal", 1);
+    if (inverse || isCommandName(name, "global", 1)) {
+        // :global defaults to the whole document.
+        if (first == -1) {
+            first = 0;
+            last = blockCount - 1;
+        }
 
-        m_pointer = m_locations.size() - 1;
+        executeGlobalCommand(args, first, last, inverse, p_msg);
+        return true;
     }
 
-    // Jump to previous location.
-    if (m_pointer > 0) {
-        --m_pointer;
+    // Other commands default to current line.
+    if (first == -1) {
+        first = last = m_editor->textCursor().block().blockNumber();
     }
 
-    qDebug() << QString("previous location (%1,%2), pointer=%3, size=%4")
-                       .arg(m_locations.at(m_pointer).m_blockNumber)
-                       .arg(m_locations.at(m_pointer).m_positionInBlock)
-                       .arg(m_pointer).arg(m_locations.size());
+    QVector<int> blocks;
+    blocks.reserve(last - first + 1);
+    for (int i = first; i <= last; ++i) {
+        blocks.append(i);
+    }
 
-    return m_locations.at(m_pointer);
+    return executeLineCommand(name, args, blocks, p_msg);
 }
 
-const VVim::Location &VVim::LocationStack::nextLocation()
+void VVim::executeGlobalCommand(const QString &p_args, int p_first, int p_last,
+                                bool p_inverse, QString &p_msg)
 {
-    V_ASSERT(hasNext());
-    ++m_pointer;
+    int idx = 0;
+    if (p_args.startsWith('!')) {
+        p_inverse = !p_inverse;
+        ++idx;
+    }
 
-    qDebug() << QString("next location (%1,%2), pointer=%3, size=%4")
-                       .arg(m_locations.at(m_pointer).m_blockNumber)
-                       .arg(m_locations.at(m_pointer).m_positionInBlock)
-                       .arg(m_pointer).arg(m_locations.size());
+    if (idx >= p_args.size() || !isPatternDelimiter(p_args[idx])) {
+        p_msg = tr("Regular expression missing from :global");
+        return;
+    }
 
-    return m_locations.at(m_pointer);
-}
+    QChar delim = p_args[idx++];
+    QString pattern = readDelimitedText(p_args, idx, delim);
+    while (idx < p_args.size() && p_args[idx].isSpace()) {
+        ++idx;
+    }
+
+    QString cmd = p_args.mid(idx);
+
+    SearchItem item;
+    if (pattern.isEmpty()) {
+        if (m_searchHistory.isEmpty()) {
+            p_msg = tr("No previous regular expression");
+            return;
+        }
+
+        item = m_searchHistory.lastItem();
+    } else {
+        item = fetchSearchItem(CommandLineType::SearchForward, pattern);
+        if (!item.m_regExp.isValid()) {
+            p_msg = tr("Invalid pattern: %1").arg(item.m_regExp.errorString());
+            return;
+        }
+
+        m_searchHistory.addItem(item);
+        m_searchHistory.resetIndex();
+    }
+
+    // Mark the lines before executing the command on them.
+    QVector<int> blocks;
+    QTextBlock block = m_editor->document()->findBlockByNumber(p_first);
+    for (int i = p_first; i <= p_last && block.isValid(); ++i, block = block.next()) {
+        if (item.m_regExp.match(block.text()).hasMatch() != p_inverse) {
+            blocks.append(i);
+        }
+    }
+
+    if (blocks.isEmpty()) {
+        p_msg = tr("Pattern not found: %1").arg(item.m_rawStr);
+        return;
+    }
+
+    int nameEnd = 0;
+    while (nameEnd < cmd.size() && cmd[nameEnd].isLetter()) {
+        ++nameEnd;
+    }
+
+    QString name = cmd.left(nameEnd);
+    if (isCommandName(name, "global", 1) || isCommandName(name, "vglobal", 1)
+        || !executeLineCommand(name, cmd.mid(nameEnd), blocks, p_msg)) {
+        p_msg = tr("Not supported in :global: %1").arg(cmd);
+    }
+}
+
+bool VVim::executeLineCommand(const QString &p_name, const QString &p_args,
+                              const QVector<int> &p_blocks, QString &p_msg)
+{
+    if (isCommandName(p_name, "delete", 1)) {
+        if (!p_args.trimmed().isEmpty()) {
+            p_msg = tr("Trailing characters: %1").arg(p_args);
+        } else {
+            deleteLines(p_blocks, p_msg);
+        }
+    } else if (isCommandName(p_name, "substitute", 1)) {
+        substituteLines(p_args, p_blocks, p_msg);
+    } else if (isCommandName(p_name, "normal", 4)) {
+        // There is no mapping, so :normal! is the same.
+        int idx = p_args.startsWith('!') ? 1 : 0;
+        while (idx < p_args.size() && p_args[idx].isSpace()) {
+            ++idx;
+        }
+
+        executeNormalOnLines(p_args.mid(idx), p_blocks);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void VVim::deleteLines(const QVector<int> &p_blocks, QString &p_msg)
+{
+    QTextDocument *doc = m_editor->document();
+    QTextCursor cursor = m_editor->textCursor();
+    QString text;
+
+    cursor.beginEditBlock();
+
+    // Remove continuous blocks at once from the bottom up so that the block
+    // numbers above keep valid.
+    int i = p_blocks.size() - 1;
+    while (i >= 0) {
+        int lastNum = p_blocks[i];
+        int firstNum = lastNum;
+        while (i > 0 && p_blocks[i - 1] == firstNum - 1) {
+            firstNum = p_blocks[--i];
+        }
+
+        --i;
+
+        QTextBlock firstBlock = doc->findBlockByNumber(firstNum);
+        QTextBlock lastBlock = doc->findBlockByNumber(lastNum);
+        cursor.setPosition(firstBlock.position());
+        cursor.setPosition(lastBlock.position() + lastBlock.length() - 1,
+                           QTextCursor::KeepAnchor);
+        text.prepend(VEditUtils::selectedText(cursor) + "\n");
+
+        // Remove the line break too.
+        if (lastBlock.next().isValid()) {
+            cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+        } else if (firstBlock.previous().isValid()) {
+            int end = cursor.position();
+            cursor.setPosition(firstBlock.position() - 1);
+            cursor.setPosition(end, QTextCursor::KeepAnchor);
+        }
+
+        cursor.removeSelectedText();
+    }
+
+    cursor.endEditBlock();
+
+    saveToRegister(text);
+
+    VEditUtils::moveCursorFirstNonSpaceCharacter(cursor, QTextCursor::MoveAnchor);
+    m_editor->setTextCursor(cursor);
+
+    p_msg = tr("%1 fewer lines").arg(p_blocks.size());
+}
+
+// An edit of :substitute computed against the document before any change.
+struct SubstituteEdit
+{
+    int m_start;
+    int m_length;
+    QString m_text;
+};
+
+void VVim::substituteLines(const QString &p_args, const QVector<int> &p_blocks,
+                           QString &p_msg)
+{
+    if (p_args.isEmpty() || !isPatternDelimiter(p_args[0])) {
+        p_msg = tr("Invalid substitute command: %1").arg(p_args);
+        return;
+    }
+
+    QChar delim = p_args[0];
+    int idx = 1;
+    QString pattern = readDelimitedText(p_args, idx, delim);
+    QString replace = readDelimitedText(p_args, idx, delim);
+    QString flags = p_args.mid(idx).trimmed();
+
+    SearchItem item;
+    if (pattern.isEmpty()) {
+        if (m_searchHistory.isEmpty()) {
+            p_msg = tr("No previous regular expression");
+            return;
+        }
+
+        item = m_searchHistory.lastItem();
+    } else {
+        item = fetchSearchItem(CommandLineType::SearchForward, pattern);
+    }
+
+    bool global = false;
+    uint options = item.m_options;
+    for (auto const &ch : flags) {
+        if (ch == 'g') {
+            global = !global;
+        } else if (ch == 'i') {
+            options &= ~FindOption::CaseSensitive;
+        } else if (ch == 'I') {
+            options |= FindOption::CaseSensitive;
+        } else {
+            p_msg = tr("Invalid flags: %1").arg(flags);
+            return;
+        }
+    }
+
+    if (options != item.m_options) {
+        item.m_options = options;
+        item.compile();
+    }
+
+    if (!item.m_regExp.isValid()) {
+        p_msg = tr("Invalid pattern: %1").arg(item.m_regExp.errorString());
+        return;
+    }
+
+    if (!pattern.isEmpty()) {
+        m_searchHistory.addItem(item);
+        m_searchHistory.resetIndex();
+    }
+
+    // Compute all the edits first.
+    QTextDocument *doc = m_editor->document();
+    QVector<SubstituteEdit> edits;
+    int lineCount = 0;
+    int lastBlockNum = -1;
+    for (auto num : p_blocks) {
+        QTextBlock block = doc->findBlockByNumber(num);
+        int pos = block.position();
+        bool changed = false;
+        QRegularExpressionMatchIterator it = item.m_regExp.globalMatch(block.text());
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            SubstituteEdit edit;
+            edit.m_start = pos + match.capturedStart();
+            edit.m_length = match.capturedLength();
+            edit.m_text = expandReplacement(replace, match);
+            edits.append(edit);
+            changed = true;
+            if (!global) {
+                break;
+            }
+        }
+
+        if (changed) {
+            ++lineCount;
+            lastBlockNum = num;
+        }
+    }
+
+    if (edits.isEmpty()) {
+        p_msg = tr("Pattern not found: %1").arg(item.m_rawStr);
+        return;
+    }
+
+    // Follow the changes to locate the last substituted line.
+    QTextCursor lastCursor(doc->findBlockByNumber(lastBlockNum));
+
+    // Apply from the bottom up so that the positions above keep valid.
+    QTextCursor cursor = m_editor->textCursor();
+    cursor.beginEditBlock();
+    for (int i = edits.size() - 1; i >= 0; --i) {
+        const SubstituteEdit &edit = edits[i];
+        cursor.setPosition(edit.m_start);
+        cursor.setPosition(edit.m_start + edit.m_length, QTextCursor::KeepAnchor);
+        cursor.insertText(edit.m_text);
+    }
+
+    cursor.endEditBlock();
+
+    VEditUtils::moveCursorFirstNonSpaceCharacter(lastCursor, QTextCursor::MoveAnchor);
+    m_editor->setTextCursor(lastCursor);
+
+    p_msg = tr("%1 substitutions on %2 lines").arg(edits.size()).arg(lineCount);
+}
+
+void VVim::startRecordingMacro(QChar p_reg, bool p_append)
+{
+    m_macroRegister = p_reg;
+    if (p_append) {
+        m_macroEntries = macroEntries(p_reg);
+    } else {
+        m_macroEntries.clear();
+    }
+
+    message(tr("recording @%1").arg(p_reg));
+}
+
+void VVim::stopRecordingMacro()
+{
+    Q_ASSERT(!m_macroRegister.isNull());
+
+    // Drop the q stopping the recording.
+    if (!m_macroEntries.isEmpty() && !m_macroEntries.last().isCommandLine()) {
+        m_macroEntries.removeLast();
+    }
+
+    Macro &macro = m_macros[m_macroRegister];
+    macro.m_entries = m_macroEntries;
+    macro.m_text.clear();
+    for (auto const &entry : m_macroEntries) {
+        if (entry.isCommandLine()) {
+            macro.m_text.append(commandLinePrefix(entry.m_cmdType));
+            macro.m_text.append(entry.m_cmd);
+            macro.m_text.append('\n');
+        } else if (entry.isText()) {
+            macro.m_text.append(entry.m_text);
+        } else {
+            macro.m_text.append(keyToMacroText(entry.m_key.m_key,
+                                               entry.m_key.m_modifiers));
+        }
+    }
+
+    m_registers[m_macroRegister].m_value = macro.m_text;
+
+    m_macroRegister = QChar();
+    m_macroEntries.clear();
+
+    message("");
+}
+
+QList<VVim::MacroEntry> VVim::macroEntries(QChar p_reg)
+{
+    const QString &text = m_registers[p_reg].read();
+    auto it = m_macros.constFind(p_reg);
+    if (it != m_macros.constEnd() && it->m_text == text) {
+        return it->m_entries;
+    }
+
+    // The register is not a recorded macro, so replay its content. Command
+    // lines in it will be read from the keys after the triggering key.
+    QList<MacroEntry> entries;
+    for (auto const &ch : text) {
+        int key, modifiers;
+        if (charToKey(ch, key, modifiers)) {
+            entries.append(Key(key, modifiers));
+        }
+    }
+
+    return entries;
+}
+
+void VVim::replayMacroEntries(const QList<MacroEntry> &p_entries)
+{
+    QString cmd;
+    for (auto const &entry : p_entries) {
+        if (entry.isCommandLine()) {
+            processCommandLine(entry.m_cmdType, entry.m_cmd);
+            continue;
+        }
+
+        if (entry.isText()) {
+            if (m_mode == VimMode::Insert) {
+                QTextCursor cursor = m_editor->textCursor();
+                cursor.insertText(entry.m_text);
+                m_editor->setTextCursor(cursor);
+            }
+
+            continue;
+        }
+
+        if (m_pendingCommandLine == CommandLineType::Invalid) {
+            replayKey(entry.m_key);
+            continue;
+        }
+
+        // Read the text of the command line triggered.
+        CommandLineType type = m_pendingCommandLine;
+        switch (entry.m_key.m_key) {
+        case Qt::Key_Return:
+            // Fall through.
+        case Qt::Key_Enter:
+            m_pendingCommandLine = CommandLineType::Invalid;
+            processCommandLine(type, cmd);
+            cmd.clear();
+            break;
+
+        case Qt::Key_Escape:
+            m_pendingCommandLine = CommandLineType::Invalid;
+            processCommandLineCancelled();
+            cmd.clear();
+            break;
+
+        case Qt::Key_Backspace:
+            cmd.chop(1);
+            break;
+
+        default:
+        {
+            QChar ch = keyToChar(entry.m_key.m_key, entry.m_key.m_modifiers);
+            if (!ch.isNull()) {
+                cmd.append(ch);
+            }
+
+            break;
+        }
+        }
+    }
+
+    if (m_pendingCommandLine != CommandLineType::Invalid) {
+        // A command line without Return is not executed.
+        m_pendingCommandLine = CommandLineType::Invalid;
+        processCommandLineCancelled();
+    }
+}
+
+void VVim::replayMacro(QChar p_reg, int p_repeat)
+{
+    if (m_replayDepth >= c_maxReplayDepth) {
+        return;
+    }
+
+    QList<MacroEntry> entries = macroEntries(p_reg);
+    m_lastMacroRegister = p_reg;
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    bool outermost = m_replayDepth == 0;
+    VimMode mode = m_mode;
+    QTextCursor cursor = m_editor->textCursor();
+
+    ++m_replayDepth;
+
+    if (outermost) {
+        // Changes are signaled to the highlighter and previewer once at the
+        // end of the edit block, and there is no need to update status per key.
+        blockSignals(true);
+        cursor.beginEditBlock();
+    }
+
+    for (int i = 0; i < p_repeat; ++i) {
+        replayMacroEntries(entries);
+    }
+
+    if (outermost) {
+        cursor.endEditBlock();
+        blockSignals(false);
+
+        if (m_mode != mode) {
+            emit modeChanged(m_mode);
+        }
+
+        emit vimStatusUpdated(this);
+    }
+
+    --m_replayDepth;
+}
+
+void VVim::triggerCommandLine(CommandLineType p_type)
+{
+    if (m_replayDepth > 0) {
+        // No command line to show. Its text follows in the replayed keys.
+        m_pendingCommandLine = p_type;
+    } else {
+        emit commandLineTriggered(p_type);
+    }
+}
+
+void VVim::dropCommandLineTrigger()
+{
+    if (m_macroEntries.isEmpty() || m_macroEntries.last().isCommandLine()) {
+        return;
+    }
+
+    const Key &key = m_macroEntries.last().m_key;
+    if (key == Key(Qt::Key_Colon, Qt::ShiftModifier)
+        || key == Key(Qt::Key_Slash)
+        || key == Key(Qt::Key_Question, Qt::ShiftModifier)) {
+        m_macroEntries.removeLast();
+    }
+}
+
+void VVim::recordLastChange(const QList<Token> &p_tokens)
+{
+    if (m_repeatingChange || m_mode != VimMode::Normal) {
+        return;
+    }
+
+    switch (p_tokens.at(0).m_action) {
+    case Action::Delete:
+    case Action::Paste:
+    case Action::PasteBefore:
+    case Action::Change:
+    case Action::Indent:
+    case Action::UnIndent:
+    case Action::ToUpper:
+    case Action::ToLower:
+    case Action::ReverseCase:
+    case Action::Replace:
+    case Action::Join:
+    case Action::JoinNoModification:
+        m_lastChange = LastChange();
+        m_lastChange.m_tokens = p_tokens;
+        m_lastChange.m_register = m_regName;
+        m_changeRecorded = true;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void VVim::updateLastChange(VimMode p_modeBefore, const QList<Key> &p_keysBefore,
+                            const Key &p_key)
+{
+    if (m_repeatingChange) {
+        return;
+    }
+
+    if (p_modeBefore == VimMode::Insert) {
+        if (m_mode != VimMode::Insert && m_lastChange.m_capturing) {
+            m_lastChange.m_capturing = false;
+            m_lastChange.m_insertedText = m_insertedText;
+        }
+
+        return;
+    }
+
+    if (p_modeBefore != VimMode::Normal || m_mode != VimMode::Insert) {
+        return;
+    }
+
+    if (!m_changeRecorded) {
+        // Entered Insert mode by keys like i and o.
+        m_lastChange = LastChange();
+        for (auto const &key : p_keysBefore) {
+            if (!key.isDigit()) {
+                m_lastChange.m_keys.append(key);
+            }
+        }
+
+        m_lastChange.m_keys.append(p_key);
+    }
+
+    m_lastChange.m_insertedText.clear();
+    m_lastChange.m_capturing = true;
+}
+
+void VVim::updateInsertSession(VimMode p_modeBefore, const Key &p_key)
+{
+    if (p_modeBefore != VimMode::Insert && m_mode == VimMode::Insert) {
+        // Changes made by the key entering Insert mode are not included.
+        m_insertStart = m_insertEnd = m_editor->textCursor().position();
+        m_insertedText.clear();
+    } else if (p_modeBefore == VimMode::Insert && m_mode != VimMode::Insert) {
+        m_insertedText = insertSessionText();
+        m_insertStart = m_insertEnd = -1;
+
+        if (!m_macroRegister.isNull() && m_replayDepth == 0) {
+            if (!m_insertedText.isEmpty()) {
+                m_macroEntries.append(MacroEntry(m_insertedText));
+            }
+
+            // The key leaving Insert mode.
+            m_macroEntries.append(p_key);
+        }
+    }
+}
+
+QString VVim::insertSessionText() const
+{
+    QTextDocument *doc = m_editor->document();
+    int end = qMin(m_insertEnd, doc->characterCount() - 1);
+    if (m_insertStart < 0 || end <= m_insertStart) {
+        return QString();
+    }
+
+    QTextCursor cursor(doc);
+    cursor.setPosition(m_insertStart);
+    cursor.setPosition(end, QTextCursor::KeepAnchor);
+    QString text = cursor.selectedText();
+    text.replace(QChar::ParagraphSeparator, '\n');
+
+    // Previewed images are not part of the text.
+    text.remove(QChar::ObjectReplacementCharacter);
+    return text;
+}
+
+void VVim::handleContentsChange(int p_position, int p_charsRemoved, int p_charsAdded)
+{
+    // Changes of formats only, such as those by the highlighter, are reported
+    // with the same number of characters removed and added.
+    if (m_insertStart == -1 || p_charsRemoved == p_charsAdded) {
+        return;
+    }
+
+    int delta = p_charsAdded - p_charsRemoved;
+    int removedEnd = p_position + p_charsRemoved;
+    if (removedEnd < m_insertStart
+        || (removedEnd == m_insertStart && p_charsRemoved > 0)) {
+        // Before the session, such as Backspace beyond its start.
+        m_insertStart += delta;
+        m_insertEnd += delta;
+    } else if (p_position <= m_insertEnd) {
+        m_insertStart = qMin(m_insertStart, p_position);
+        m_insertEnd = qMax(m_insertEnd, removedEnd) + delta;
+    }
+}
+
+void VVim::repeatLastChange(int p_repeat)
+{
+    if (!m_lastChange.isValid()) {
+        return;
+    }
+
+    m_repeatingChange = true;
+    ++m_replayDepth;
+    blockSignals(true);
+
+    QTextCursor cursor = m_editor->textCursor();
+    cursor.beginEditBlock();
+
+    int insertRepeat = 1;
+    if (!m_lastChange.m_tokens.isEmpty()) {
+        // The count replaces the one of the command.
+        QList<Token> tokens = m_lastChange.m_tokens;
+        if (p_repeat > 0) {
+            bool found = false;
+            for (auto &token : tokens) {
+                if (token.isRepeat()) {
+                    token.m_repeat = p_repeat;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                tokens.insert(1, Token(p_repeat));
+            }
+        }
+
+        setRegister(m_lastChange.m_register);
+        processCommand(tokens);
+    } else {
+        // The count repeats the inserted text.
+        for (auto const &key : m_lastChange.m_keys) {
+            replayKey(key);
+        }
+
+        if (p_repeat > 0) {
+            insertRepeat = p_repeat;
+        }
+    }
+
+    if (m_mode == VimMode::Insert) {
+        if (!m_lastChange.m_insertedText.isEmpty()) {
+            QTextCursor insertCursor = m_editor->textCursor();
+            insertCursor.insertText(m_lastChange.m_insertedText.repeated(insertRepeat));
+            m_editor->setTextCursor(insertCursor);
+        }
+
+        // Leave Insert mode as the change did.
+        handleKeyPressEvent(Qt::Key_Escape, Qt::NoModifier);
+    }
+
+    cursor.endEditBlock();
+
+    blockSignals(false);
+    --m_replayDepth;
+    m_repeatingChange = false;
+}
+
+void VVim::replayKey(const Key &p_key)
+{
+    if (handleKeyPressEvent(p_key.m_key, p_key.m_modifiers)) {
+        return;
+    }
+
+    if (m_mode != VimMode::Insert) {
+        return;
+    }
+
+    QTextCursor cursor = m_editor->textCursor();
+    switch (p_key.m_key) {
+    case Qt::Key_Return:
+        // Fall through.
+    case Qt::Key_Enter:
+        cursor.removeSelectedText();
+        VEditUtils::insertBlockWithIndent(cursor);
+        break;
+
+    case Qt::Key_Tab:
+        cursor.insertText(m_editConfig->m_tabSpaces);
+        break;
+
+    case Qt::Key_Backspace:
+        cursor.deletePreviousChar();
+        break;
+
+    case Qt::Key_Delete:
+        cursor.deleteChar();
+        break;
+
+    default:
+    {
+        QChar ch = keyToChar(p_key.m_key, p_key.m_modifiers);
+        if (!ch.isNull() && !isControlModifier(p_key.m_modifiers)) {
+            cursor.insertText(ch);
+        }
+
+        break;
+    }
+    }
+
+    m_editor->setTextCursor(cursor);
+}
+
+void VVim::executeNormalOnLines(const QString &p_keys, const QVector<int> &p_blocks)
+{
+    if (p_keys.isEmpty()) {
+        return;
+    }
+
+    // Cursors of the lines follow the changes made on previous lines.
+    QTextDocument *doc = m_editor->document();
+    QVector<QTextCursor> lines;
+    lines.reserve(p_blocks.size());
+    for (auto num : p_blocks) {
+        lines.append(QTextCursor(doc->findBlockByNumber(num)));
+    }
+
+    // No need to update status or trigger command line per key.
+    blockSignals(true);
+    ++m_replayDepth;
+
+    QTextCursor cursor = m_editor->textCursor();
+    cursor.beginEditBlock();
+    for (auto &line : lines) {
+        line.movePosition(QTextCursor::StartOfBlock);
+        m_editor->setTextCursor(line);
+        executeNormalKeys(p_keys);
+    }
+
+    cursor.endEditBlock();
+
+    --m_replayDepth;
+    blockSignals(false);
+
+    emit vimStatusUpdated(this);
+}
+
+void VVim::executeNormalKeys(const QString &p_keys)
+{
+    for (int i = 0; i < p_keys.size(); ++i) {
+        if (m_mode == VimMode::Insert) {
+            // The rest keys are text to insert.
+            m_editor->insertPlainText(p_keys.mid(i));
+            break;
+        }
+
+        if (m_pendingCommandLine != CommandLineType::Invalid) {
+            // Keys up to a new line are the text of the command line.
+            CommandLineType type = m_pendingCommandLine;
+            m_pendingCommandLine = CommandLineType::Invalid;
+            int idx = p_keys.indexOf('\n', i);
+            if (idx == -1) {
+                // Like Vim, an incomplete command line is abandoned.
+                processCommandLineCancelled();
+                break;
+            }
+
+            processCommandLine(type, p_keys.mid(i, idx - i));
+            i = idx;
+            continue;
+        }
+
+        int key, modifiers;
+        if (charToKey(p_keys[i], key, modifiers)) {
+            handleKeyPressEvent(key, modifiers);
+        }
+    }
+
+    if (m_pendingCommandLine != CommandLineType::Invalid) {
+        m_pendingCommandLine = CommandLineType::Invalid;
+        processCommandLineCancelled();
+    }
+
+    if (m_mode == VimMode::Insert) {
+        handleKeyPressEvent(Qt::Key_Escape, Qt::NoModifier);
+    } else if (m_mode != VimMode::Normal) {
+        setMode(VimMode::Normal);
+    }
+
+    resetState();
+}
+
+bool VVim::hasNonDigitPendingKeys(const QList<Key> &p_keys)
+{
+    for (auto const &key : p_keys) {
+        if (!key.isDigit()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool VVim::hasNonDigitPendingKeys()
+{
+    return hasNonDigitPendingKeys(m_keys);
+}
+
+bool VVim::processLeaderSequence(const Key &p_key)
+{
+    // Different from Vim:
+    // If it is not a valid sequence, we just do nothing here.
+    V_ASSERT(checkPendingKey(Key(Qt::Key_Backslash)));
+    bool validSequence = true;
+    QList<Key> replaySeq;
+
+    if (p_key == Key(Qt::Key_Y)) {
+        // <leader>y, "+y
+        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_Y));
+    } else if (p_key == Key(Qt::Key_D)) {
+        // <leader>d, "+d
+        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_D));
+    } else if (p_key == Key(Qt::Key_P)) {
+        // <leader>p, "+p
+        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_P));
+    } else if (p_key == Key(Qt::Key_P, Qt::ShiftModifier)) {
+        // <leader>P, "+P
+        replaySeq.append(Key(Qt::Key_QuoteDbl, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_Plus, Qt::ShiftModifier));
+        replaySeq.append(Key(Qt::Key_P, Qt::ShiftModifier));
+    } else if (p_key == Key(Qt::Key_Space)) {
+        // <leader><space>, clear search highlight
+        clearSearchHighlight();
+    } else {
+        validSequence = false;
+    }
+
+    if (!replaySeq.isEmpty()) {
+        // Replay the sequence.
+        m_replayLeaderSequence = true;
+        m_keys.clear();
+        for (int i = 0; i < 2; ++i) {
+            m_pendingKeys.pop_back();
+        }
+
+        for (auto const &key : replaySeq) {
+            bool ret = handleKeyPressEvent(key.m_key, key.m_modifiers);
+            if (!ret) {
+                break;
+            }
+        }
+
+        m_replayLeaderSequence = false;
+    } else {
+        resetState();
+    }
+
+    return validSequence;
+}
+
+VVim::LocationStack::LocationStack(int p_maximum)
+    : m_pointer(0), c_maximumLocations(p_maximum < 10 ? 10 : p_maximum)
+{
+}
+
+bool VVim::LocationStack::hasPrevious() const
+{
+    return m_pointer > 0;
+}
+
+bool VVim::LocationStack::hasNext() const
+{
+    return m_pointer < m_locations.size() - 1;
+}
+
+void VVim::LocationStack::addLocation(const QTextCursor &p_cursor)
+{
+    int blockNumber = p_cursor.block().blockNumber();
+    int pib = p_cursor.positionInBlock();
+
+    // Remove older location with the same block number.
+    for (auto it = m_locations.begin(); it != m_locations.end();) {
+        if (it->m_blockNumber == blockNumber) {
+            it = m_locations.erase(it);
+            break;
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_locations.size() >= c_maximumLocations) {
+        m_locations.removeFirst();
+    }
+
+    m_locations.append(Location(blockNumber, pib));
+
+    m_pointer = m_locations.size();
+
+    qDebug() << QString("add location (%1,%2), pointer=%3")
+                       .arg(blockNumber).arg(pib).arg(m_pointer);
+}
+
+const VVim::Location &VVim::LocationStack::previousLocation(const QTextCursor &p_cursor)
+{
+    V_ASSERT(hasPrevious());
+    if (m_pointer == m_locations.size()) {
+        // Add current location to the stack.
+        addLocation(p_cursor);
+
+        m_pointer = m_locations.size() - 1;
+    }
+
+    // Jump to previous location.
+    if (m_pointer > 0) {
+        --m_pointer;
+    }
+
+    qDebug() << QString("previous location (%1,%2), pointer=%3, size=%4")
+                       .arg(m_locations.at(m_pointer).m_blockNumber)
+                       .arg(m_locations.at(m_pointer).m_positionInBlock)
+                       .arg(m_pointer).arg(m_locations.size());
+
+    return m_locations.at(m_pointer);
+}
+
+const VVim::Location &VVim::LocationStack::nextLocation()
+{
+    V_ASSERT(hasNext());
+    ++m_pointer;
+
+    qDebug() << QString("next location (%1,%2), pointer=%3, size=%4")
+                       .arg(m_locations.at(m_pointer).m_blockNumber)
+                       .arg(m_locations.at(m_pointer).m_positionInBlock)
+                       .arg(m_pointer).arg(m_locations.size());
+
+    return m_locations.at(m_pointer);
+}
 
 VVim::Marks::Marks()
 {
@@ -5522,6 +6733,11 @@ void VVim::processTitleJump(const QList<Token> &p_tokens, bool p_forward, int p_
     }
 }
 
+void VVim::SearchItem::compile()
+{
+    m_regExp = VTextMatcher::compile(m_text, m_options);
+}
+
 void VVim::SearchHistory::addItem(const SearchItem &p_item)
 {
     m_isLastItemForward = p_item.m_forward;
@@ -5,13 +5,17 @@
 #include <QString>
 #include <QTextCursor>
 #include <QMap>
+#include <QVector>
+#include <QRegularExpression>
 #include <QDebug>
 #include "vutils.h"
+#include "vtextsearcher.h"
 
 class VEdit;
 class QKeyEvent;
 class VEditConfig;
 class QKeyEvent;
+class QTextDocument;
 
 enum class VimMode {
     Normal = 0,
@@ -222,6 +226,9 @@ private slots:
     // Visual mode.
     void selectionToVisualMode(bool p_hasText);
 
+    // Track the range of the text changed in current Insert mode session.
+    void handleContentsChange(int p_position, int p_charsRemoved, int p_charsAdded);
+
 private:
     // Struct for a key press.
     struct Key
@@ -277,11 +284,65 @@ private:
         }
     };
 
+    // A key, a command line or the text of an Insert mode session recorded
+    // into a macro.
+    struct MacroEntry
+    {
+        MacroEntry(const Key &p_key = Key())
+            : m_key(p_key), m_cmdType(CommandLineType::Invalid)
+        {
+        }
+
+        MacroEntry(CommandLineType p_type, const QString &p_cmd)
+            : m_cmdType(p_type), m_cmd(p_cmd)
+        {
+        }
+
+        explicit MacroEntry(const QString &p_text)
+            : m_cmdType(CommandLineType::Invalid), m_text(p_text)
+        {
+        }
+
+        bool isCommandLine() const
+        {
+            return m_cmdType != CommandLineType::Invalid;
+        }
+
+        bool isText() const
+        {
+            return !isCommandLine() && !m_text.isEmpty();
+        }
+
+        Key m_key;
+
+        // Type of the command line entered, or Invalid if it is a key.
+        CommandLineType m_cmdType;
+
+        // Text entered in the command line.
+        QString m_cmd;
+
+        // Text inserted in Insert mode.
+        QString m_text;
+    };
+
+    // A macro recorded into a register.
+    struct Macro
+    {
+        QList<MacroEntry> m_entries;
+
+        // Text of m_entries saved in the register. If the register is changed
+        // afterwards, the register content will be replayed instead.
+        QString m_text;
+    };
+
     // Search item including the searched text and options.
     struct SearchItem
     {
         SearchItem() : m_options(0), m_forward(true) {}
 
+        // Compile m_text with m_options into m_regExp.
+        void compile();
+
         // The user raw input.
         QString m_rawStr;
 
@@ -290,6 +351,9 @@ private:
 
         uint m_options;
         bool m_forward;
+
+        // Compiled pattern of m_text. Copies of the item share it.
+        QRegularExpression m_regExp;
     };
 
     class SearchHistory
@@ -542,6 +606,33 @@ private:
         Key m_key;
     };
 
+    // The last change to repeat by ".".
+    struct LastChange
+    {
+        LastChange() : m_capturing(false) {}
+
+        bool isValid() const
+        {
+            return !m_tokens.isEmpty() || !m_keys.isEmpty();
+        }
+
+        // Tokens of the command making the change.
+        QList<Token> m_tokens;
+
+        // Register used by the command.
+        QChar m_register;
+
+        // Keys entering Insert mode if the change is not made by a command,
+        // such as i, A and o. Count is excluded.
+        QList<Key> m_keys;
+
+        // Text inserted in Insert mode following the change.
+        QString m_insertedText;
+
+        // Whether we are capturing the text inserted in Insert mode.
+        bool m_capturing;
+    };
+
     // Stack for all the jump locations.
     // When we execute a jump action, we push current location to the stack and
     // remove older location with the same block number.
@@ -676,6 +767,64 @@ private:
     // Check m_keys to see if we are expecting a mark name as the target.
     bool expectingMarkTarget() const;
 
+    // Check m_keys to see if we are expecting a register name to record a
+    // macro into.
+    bool expectingMacroRegister() const;
+
+    // Check m_keys to see if we are expecting a register name of the macro
+    // to replay.
+    bool expectingMacroToReplay() const;
+
+    // Start recording keys into register @p_reg.
+    // @p_append: whether append to the macro in @p_reg.
+    void startRecordingMacro(QChar p_reg, bool p_append);
+
+    // Stop recording and save the macro to the register.
+    void stopRecordingMacro();
+
+    // Return the entries of the macro in register @p_reg.
+    QList<MacroEntry> macroEntries(QChar p_reg);
+
+    // Replay @p_entries of a macro once.
+    void replayMacroEntries(const QList<MacroEntry> &p_entries);
+
+    // Open the command line of type @p_type, or read it from the replayed
+    // keys if we are replaying.
+    void triggerCommandLine(CommandLineType p_type);
+
+    // Remove the key triggering the command line from current macro, since
+    // the command line will be recorded as a whole.
+    void dropCommandLineTrigger();
+
+    // Replay the macro in register @p_reg @p_repeat times as one undo step.
+    void replayMacro(QChar p_reg, int p_repeat);
+
+    // Record @p_tokens as the last change if it is a change in Normal mode.
+    void recordLastChange(const QList<Token> &p_tokens);
+
+    // Start or finish an Insert mode session after handling key @p_key.
+    // @p_modeBefore is the mode before handling it.
+    // The text of a finished session is recorded into current macro.
+    void updateInsertSession(VimMode p_modeBefore, const Key &p_key);
+
+    // Text within the range of current Insert mode session.
+    QString insertSessionText() const;
+
+    // Update the last change after handling key @p_key.
+    // @p_modeBefore and @p_keysBefore are the mode and m_keys before handling it.
+    void updateLastChange(VimMode p_modeBefore, const QList<Key> &p_keysBefore,
+                          const Key &p_key);
+
+    // Repeat the last change as one undo step.
+    // @p_repeat: the count to replace the original one, or -1.
+    void repeatLastChange(int p_repeat);
+
+    // Replay @p_key as it is typed.
+    // Keys typed in Insert mode which are not handled by Vim will be applied
+    // to the editor directly, without the Markdown operations such as list
+    // continuation. Recorded macros replay the inserted text instead.
+    void replayKey(const Key &p_key);
+
     // Return the corresponding register name of @p_key.
     // If @p_key is not a valid register name, return a NULL QChar.
     QChar keyToRegisterName(const Key &p_key) const;
@@ -764,9 +913,53 @@ private:
     // @p_cmd does not contain the leading colon.
     // Returns true if it is a valid command.
     // Following commands are supported:
-    // w, wq, q, q!, x, <nums>
+    // w, wq, q, q!, x, <nums>, and those of executeRangeCommand().
     bool executeCommand(const QString &p_cmd);
 
+    // Execute command @p_cmd with an optional line range in front.
+    // Following commands are supported:
+    // [range]d[elete]
+    // [range]s[ubstitute]/{pattern}/{string}/[g][i][I]
+    // [range]norm[al] {commands}
+    // [range]g[lobal][!]/{pattern}/{cmd}, [range]v[global]/{pattern}/{cmd},
+    // where {cmd} is one of the above.
+    // The edits of a command are applied as one undo step.
+    // Returns false if @p_cmd is not such a command. @p_msg is set to the
+    // message to show.
+    bool executeRangeCommand(const QString &p_cmd, QString &p_msg);
+
+    // Parse the line address at @p_idx of @p_cmd and move @p_idx after it.
+    // Supports {number}, ., $, 'x and following +{number} and -{number}.
+    // Returns the block number, -1 if there is no address, or -2 if the
+    // address is invalid.
+    int parseLineAddress(const QString &p_cmd, int &p_idx);
+
+    // Execute :global on blocks [@p_first, @p_last].
+    // @p_args: the arguments following the command name.
+    // @p_inverse: whether execute on the blocks not matching.
+    void executeGlobalCommand(const QString &p_args, int p_first, int p_last,
+                              bool p_inverse, QString &p_msg);
+
+    // Execute command @p_name with arguments @p_args on blocks @p_blocks,
+    // which is sorted in ascending order.
+    // Returns false if @p_name is not a supported command.
+    bool executeLineCommand(const QString &p_name, const QString &p_args,
+                            const QVector<int> &p_blocks, QString &p_msg);
+
+    // :delete.
+    void deleteLines(const QVector<int> &p_blocks, QString &p_msg);
+
+    // :substitute.
+    void substituteLines(const QString &p_args, const QVector<int> &p_blocks,
+                         QString &p_msg);
+
+    // :normal.
+    void executeNormalOnLines(const QString &p_keys, const QVector<int> &p_blocks);
+
+    // Feed @p_keys as typed in Normal mode. Incomplete command will be
+    // aborted and Insert mode will be ended at the end.
+    void executeNormalKeys(const QString &p_keys);
+
     // Check if m_keys has non-digit key.
     bool hasNonDigitPendingKeys();
 
@@ -792,6 +985,12 @@ private:
     // Regular-expression by default.
     VVim::SearchItem fetchSearchItem(VVim::CommandLineType p_type, const QString &p_cmd);
 
+    // Find @p_item @p_repeat times from @p_cursor or current cursor if it is NULL.
+    // Returns true if found.
+    bool findSearchItem(const SearchItem &p_item, bool p_forward, int p_repeat,
+                        QTextCursor *p_cursor = NULL,
+                        QTextCursor::MoveMode p_moveMode = QTextCursor::MoveAnchor);
+
     // Clear search highlight.
     void clearSearchHighlight();
 
@@ -838,6 +1037,46 @@ private:
     // Whether we are expecting to read a register to insert.
     bool m_registerPending;
 
+    // Register we are recording a macro into. NULL QChar if not recording.
+    QChar m_macroRegister;
+
+    // Entries recorded of current macro.
+    QList<MacroEntry> m_macroEntries;
+
+    // Register name -> macro recorded.
+    QMap<QChar, Macro> m_macros;
+
+    // Register of the macro replayed last time, used by @@.
+    QChar m_lastMacroRegister;
+
+    // Depth of replaying keys of macros or :normal.
+    // Replayed keys will not be recorded.
+    int m_replayDepth;
+
+    // Maximum depth of macros replaying macros.
+    static const int c_maxReplayDepth;
+
+    LastChange m_lastChange;
+
+    // Whether a change command is recorded during current key press.
+    bool m_changeRecorded;
+
+    // Whether we are repeating the last change.
+    bool m_repeatingChange;
+
+    // Type of the command line triggered by replayed keys. The following
+    // replayed keys are its text until a Return.
+    CommandLineType m_pendingCommandLine;
+
+    // Range of the text changed in current Insert mode session entered by
+    // keys, or -1 if there is no such session. The text is taken from the
+    // document, so text from input methods and paste is included.
+    int m_insertStart;
+    int m_insertEnd;
+
+    // Text inserted in the last finished Insert mode session.
+    QString m_insertedText;
+
     static const QChar c_unnamedRegister;
     static const QChar c_blackHoleRegister;
     static const QChar c_selectionRegister;
@@ -0,0 +1,446 @@
+#include "vbatchexporter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QTemporaryDir>
+#include <QCoreApplication>
+#include <QWebChannel>
+#include <QVariant>
+#include <QDebug>
+
+#include "utils/vutils.h"
+#include "vfile.h"
+#include "vdirectory.h"
+#include "vwebview.h"
+#include "vpreviewpage.h"
+#include "vdocument.h"
+#include "vmarkdownconverter.h"
+#include "vhtmlexporter.h"
+#include "utils/vpdfmerger.h"
+
+extern VConfigManager *g_config;
+
+// Time to wait after the web side is ready to ensure it is really ready.
+static const int c_readyWaitTime = 200;
+
+// Max time in ms to export one note. A note which is not output by then is
+// marked as failed, since nothing could cancel the export in command line.
+static const int c_noteTimeout = 60 * 1000;
+
+// Interval to poll the states of the web pages.
+static const int c_pollInterval = 50;
+
+// Max number of web pages by default.
+static const int c_maxDefaultWorkerCount = 4;
+
+VBatchExporter::VBatchExporter(MarkdownConverterType p_mdType, QObject *p_parent)
+    : QObject(p_parent), m_mdType(p_mdType), m_type(ExportType::PDF),
+      m_pageLayout(QPageLayout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF(0.0, 0.0, 0.0, 0.0))),
+      m_workerCount(defaultWorkerCount()), m_skipUpToDate(false), m_cancelled(false),
+      m_htmlExporter(NULL), m_skippedCount(0)
+{
+    m_htmlTemplate = VUtils::generateHtmlTemplate(m_mdType, true);
+}
+
+VBatchExporter::~VBatchExporter()
+{
+    for (auto &worker : m_workers) {
+        finishTask(worker);
+    }
+
+    delete m_htmlExporter;
+}
+
+int VBatchExporter::defaultWorkerCount()
+{
+    int count = QThread::idealThreadCount();
+    if (count < 1) {
+        count = 1;
+    }
+
+    return qMin(count, c_maxDefaultWorkerCount);
+}
+
+QVector<VExportTask> VBatchExporter::generateTasks(VDirectory *p_dir,
+                                                   ExportType p_type,
+                                                   const QString &p_outputDir)
+{
+    QVector<VExportTask> tasks;
+    QString suffix = p_type == ExportType::PDF ? "pdf" : "html";
+    generateTasks(p_dir, suffix, p_outputDir, tasks);
+    return tasks;
+}
+
+void VBatchExporter::generateTasks(VDirectory *p_dir,
+                                   const QString &p_suffix,
+                                   const QString &p_outputDir,
+                                   QVector<VExportTask> &p_tasks)
+{
+    if (!p_dir->open()) {
+        qWarning() << "fail to open directory" << p_dir->retrivePath();
+        return;
+    }
+
+    QDir outputDir(p_outputDir);
+    const QVector<VFile *> &files = p_dir->getFiles();
+    for (auto const &file : files) {
+        if (file->getDocType() != DocType::Markdown) {
+            continue;
+        }
+
+        QString name = QFileInfo(file->getName()).completeBaseName() + "." + p_suffix;
+        p_tasks.append(VExportTask(file, outputDir.filePath(name)));
+    }
+
+    const QVector<VDirectory *> &subDirs = p_dir->getSubDirs();
+    for (auto const &dir : subDirs) {
+        generateTasks(dir, p_suffix, outputDir.filePath(dir->getName()), p_tasks);
+    }
+}
+
+int VBatchExporter::exportNotes(const QVector<VExportTask> &p_tasks, ExportType p_type)
+{
+    m_type = p_type;
+    if (m_type == ExportType::HTML && !m_htmlExporter) {
+        m_htmlExporter = new VHtmlExporter();
+    }
+
+    m_tasks = p_tasks;
+    m_cancelled = false;
+    m_skippedCount = 0;
+    m_failedNotes.clear();
+
+    int total = m_tasks.size();
+    int next = 0;
+    int done = 0;
+    int exportedNum = 0;
+
+    m_workers.clear();
+    m_workers.resize(qMin(m_workerCount, total));
+
+    while (done < total && !m_cancelled) {
+        for (int i = 0; i < m_workers.size(); ++i) {
+            Worker &worker = m_workers[i];
+            if (worker.m_taskIdx == -1) {
+                // Feed a new task to this idle worker.
+                while (next < total) {
+                    int idx = next++;
+                    if (startTask(i, idx)) {
+                        break;
+                    }
+
+                    ++done;
+                    emit progressChanged(done, total, m_tasks[idx].m_file->getName());
+                }
+
+                continue;
+            }
+
+            const VExportTask &task = m_tasks[worker.m_taskIdx];
+            if (!(worker.m_state & (NoteState::Failed | NoteState::Finished))
+                && worker.m_taskTimer.hasExpired(c_noteTimeout)) {
+                qWarning() << "timeout to export note" << task.m_file->retrivePath();
+                worker.m_state |= NoteState::Failed;
+            }
+
+            if (worker.m_state & NoteState::Failed) {
+                qWarning() << "fail to export note" << task.m_file->retrivePath();
+                m_failedNotes.append(task.m_file->retrivePath());
+            } else if (worker.m_state & NoteState::Finished) {
+                ++exportedNum;
+            } else {
+                if (worker.m_state == NoteState::Ready) {
+                    if (!worker.m_readyTimer.isValid()) {
+                        worker.m_readyTimer.start();
+                    } else if (worker.m_readyTimer.elapsed() >= c_readyWaitTime) {
+                        outputNote(i);
+                    }
+                }
+
+                continue;
+            }
+
+            ++done;
+            emit progressChanged(done, total, task.m_file->getName());
+            finishTask(worker);
+        }
+
+        if (done < total) {
+            VUtils::sleepWait(c_pollInterval);
+        }
+    }
+
+    for (auto &worker : m_workers) {
+        finishTask(worker);
+    }
+
+    m_workers.clear();
+    m_tasks.clear();
+
+    return exportedNum;
+}
+
+int VBatchExporter::exportToOnePdf(VDirectory *p_dir, const QString &p_filePath)
+{
+    // Each note is rendered into its own PDF with the same page layout, so the
+    // memory usage of the web pages does not grow with the number of notes.
+    QTemporaryDir tmpDir;
+    if (!tmpDir.isValid()) {
+        qWarning() << "fail to create temporary directory";
+        return 0;
+    }
+
+    QVector<VExportTask> tasks = generateTasks(p_dir, ExportType::PDF, tmpDir.path());
+    if (tasks.isEmpty()) {
+        return 0;
+    }
+
+    bool skipUpToDate = m_skipUpToDate;
+    m_skipUpToDate = false;
+    exportNotes(tasks, ExportType::PDF);
+    m_skipUpToDate = skipUpToDate;
+
+    if (m_cancelled) {
+        return 0;
+    }
+
+    if (!VUtils::makePath(VUtils::basePathFromPath(p_filePath))) {
+        qWarning() << "fail to create directory for" << p_filePath;
+        return 0;
+    }
+
+    QString tmpPath = p_filePath + ".part";
+    VPdfMerger merger;
+    if (!merger.begin(tmpPath)) {
+        return 0;
+    }
+
+    QDir dir(tmpDir.path());
+    int mergedNum = 0;
+    for (int i = 0; i < tasks.size(); ++i) {
+        const VExportTask &task = tasks[i];
+        if (!QFileInfo::exists(task.m_filePath)) {
+            // Failed to export.
+            continue;
+        }
+
+        // Outline path follows the folder structure, ending with the note name.
+        QStringList titlePath = dir.relativeFilePath(task.m_filePath).split('/');
+        titlePath.last() = QFileInfo(task.m_file->getName()).completeBaseName();
+
+        if (merger.addFile(task.m_filePath, titlePath)) {
+            ++mergedNum;
+        } else {
+            qWarning() << "fail to merge PDF of note" << task.m_file->retrivePath();
+            m_failedNotes.append(task.m_file->retrivePath());
+        }
+
+        QFile::remove(task.m_filePath);
+
+        emit mergeProgressChanged(i + 1, tasks.size());
+        QCoreApplication::processEvents();
+        if (m_cancelled) {
+            merger.end();
+            QFile::remove(tmpPath);
+            return 0;
+        }
+    }
+
+    if (!merger.end() || mergedNum == 0) {
+        qWarning() << "fail to write merged PDF file" << p_filePath;
+        QFile::remove(tmpPath);
+        return 0;
+    }
+
+    if (QFileInfo::exists(p_filePath) && !QFile::remove(p_filePath)) {
+        qWarning() << "fail to remove old file" << p_filePath;
+        QFile::remove(tmpPath);
+        return 0;
+    }
+
+    if (!QFile::rename(tmpPath, p_filePath)) {
+        qWarning() << "fail to rename" << tmpPath << "to" << p_filePath;
+        return 0;
+    }
+
+    return mergedNum;
+}
+
+bool VBatchExporter::startTask(int p_workerIdx, int p_idx)
+{
+    Worker &worker = m_workers[p_workerIdx];
+    V_ASSERT(worker.m_taskIdx == -1);
+
+    const VExportTask &task = m_tasks[p_idx];
+    if (m_skipUpToDate && isUpToDate(task)) {
+        ++m_skippedCount;
+        return false;
+    }
+
+    if (!VUtils::makePath(VUtils::basePathFromPath(task.m_filePath))) {
+        qWarning() << "fail to create directory for" << task.m_filePath;
+        m_failedNotes.append(task.m_file->retrivePath());
+        return false;
+    }
+
+    worker.m_isOpened = task.m_file->isOpened();
+    if (!worker.m_isOpened && !task.m_file->open()) {
+        m_failedNotes.append(task.m_file->retrivePath());
+        return false;
+    }
+
+    worker.m_taskIdx = p_idx;
+    worker.m_state = NoteState::NotReady;
+    worker.m_readyTimer.invalidate();
+    worker.m_taskTimer.start();
+
+    initWebViewer(p_workerIdx, task.m_file);
+    return true;
+}
+
+void VBatchExporter::finishTask(Worker &p_worker)
+{
+    if (p_worker.m_webViewer) {
+        delete p_worker.m_webViewer;
+        p_worker.m_webViewer = NULL;
+    }
+
+    if (p_worker.m_taskIdx != -1) {
+        VFile *file = m_tasks[p_worker.m_taskIdx].m_file;
+        if (!p_worker.m_isOpened) {
+            file->close();
+        }
+
+        p_worker.m_taskIdx = -1;
+    }
+
+    p_worker.m_state = NoteState::NotReady;
+}
+
+void VBatchExporter::initWebViewer(int p_workerIdx, VFile *p_file)
+{
+    Worker &worker = m_workers[p_workerIdx];
+    V_ASSERT(!worker.m_webViewer);
+
+    // Off-screen web view without parent.
+    worker.m_webViewer = new VWebView(p_file);
+    worker.m_webViewer->hide();
+    VPreviewPage *page = new VPreviewPage(worker.m_webViewer);
+    worker.m_webViewer->setPage(page);
+
+    connect(page, &VPreviewPage::loadFinished,
+            this, [this, p_workerIdx](bool p_ok) {
+                Worker &worker = m_workers[p_workerIdx];
+                worker.m_state |= NoteState::WebLoadFinished;
+                if (!p_ok) {
+                    worker.m_state |= NoteState::Failed;
+                }
+            });
+
+    VDocument *document = new VDocument(p_file, worker.m_webViewer);
+    connect(document, &VDocument::logicsFinished,
+            this, [this, p_workerIdx]() {
+                m_workers[p_workerIdx].m_state |= NoteState::WebLogicsReady;
+            });
+
+    QWebChannel *channel = new QWebChannel(worker.m_webViewer);
+    channel->registerObject(QStringLiteral("content"), document);
+    page->setWebChannel(channel);
+
+    // Need to generate HTML using Hoedown.
+    if (m_mdType == MarkdownConverterType::Hoedown) {
+        VMarkdownConverter mdConverter;
+        QString toc;
+        QString html = mdConverter.generateHtml(p_file->getContent(),
+                                                g_config->getMarkdownExtensions(),
+                                                toc);
+        document->setHtml(html);
+    }
+
+    worker.m_webViewer->setHtml(m_htmlTemplate, p_file->getBaseUrl());
+}
+
+void VBatchExporter::outputNote(int p_workerIdx)
+{
+    Worker &worker = m_workers[p_workerIdx];
+    worker.m_state |= NoteState::Outputing;
+
+    int taskIdx = worker.m_taskIdx;
+    QString filePath = m_tasks[taskIdx].m_filePath;
+
+    // Callback may be called after the task is finished or cancelled.
+    auto outputFunc = [this, p_workerIdx, taskIdx, filePath](const QByteArray &p_data) {
+        if (m_cancelled
+            || p_workerIdx >= m_workers.size()
+            || m_workers[p_workerIdx].m_taskIdx != taskIdx) {
+            return;
+        }
+
+        Worker &worker = m_workers[p_workerIdx];
+        if (!p_data.isEmpty() && writeTargetFile(filePath, p_data)) {
+            worker.m_state |= NoteState::Finished;
+        } else {
+            worker.m_state |= NoteState::Failed;
+        }
+    };
+
+    QWebEnginePage *page = worker.m_webViewer->page();
+    if (m_type == ExportType::PDF) {
+        page->printToPdf(outputFunc, m_pageLayout);
+    } else {
+        // Take only the rendered content and wrap it into a standalone page.
+        VFile *file = m_tasks[taskIdx].m_file;
+        QString basePath = file->retriveBasePath();
+        QString title = QFileInfo(file->getName()).completeBaseName();
+        page->runJavaScript("document.getElementById('placeholder').innerHTML",
+                            [this, outputFunc, basePath, title, filePath](const QVariant &p_result) {
+                                if (m_cancelled) {
+                                    return;
+                                }
+
+                                QString body = p_result.toString();
+                                VHtmlExporter::copyLocalImages(body, basePath, filePath);
+                                outputFunc(m_htmlExporter->generateHtml(body, title).toUtf8());
+                            });
+    }
+}
+
+bool VBatchExporter::isUpToDate(const VExportTask &p_task)
+{
+    QFileInfo targetInfo(p_task.m_filePath);
+    if (!targetInfo.exists()) {
+        return false;
+    }
+
+    QFileInfo noteInfo(p_task.m_file->retrivePath());
+    return targetInfo.lastModified() >= noteInfo.lastModified();
+}
+
+bool VBatchExporter::writeTargetFile(const QString &p_filePath, const QByteArray &p_data)
+{
+    QString tmpPath = p_filePath + ".part";
+    QFile file(tmpPath);
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning() << "fail to open file" << tmpPath;
+        return false;
+    }
+
+    if (file.write(p_data) != p_data.size()) {
+        qWarning() << "fail to write file" << tmpPath;
+        file.close();
+        file.remove();
+        return false;
+    }
+
+    file.close();
+
+    if (QFileInfo::exists(p_filePath) && !QFile::remove(p_filePath)) {
+        qWarning() << "fail to remove old file" << p_filePath;
+        QFile::remove(tmpPath);
+        return false;
+    }
+
+    return QFile::rename(tmpPath, p_filePath);
+}
@@ -0,0 +1,198 @@
+#ifndef VBATCHEXPORTER_H
+#define VBATCHEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPageLayout>
+#include <QElapsedTimer>
+#include "vconfigmanager.h"
+#include "vconstants.h"
+
+class VFile;
+class VDirectory;
+class VWebView;
+class VHtmlExporter;
+
+// A note to export and the path of the target file.
+struct VExportTask
+{
+    VExportTask() : m_file(NULL)
+    {
+    }
+
+    VExportTask(VFile *p_file, const QString &p_filePath)
+        : m_file(p_file), m_filePath(p_filePath)
+    {
+    }
+
+    VFile *m_file;
+    QString m_filePath;
+};
+
+// Export a batch of notes using a pool of off-screen web pages in parallel.
+class VBatchExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VBatchExporter(MarkdownConverterType p_mdType, QObject *p_parent = 0);
+
+    ~VBatchExporter();
+
+    // Generate tasks for all the Markdown notes in @p_dir and its sub-directories.
+    // Target files will keep the folder structure relative to @p_dir within
+    // @p_outputDir.
+    // Will open the directories which are not opened yet.
+    static QVector<VExportTask> generateTasks(VDirectory *p_dir,
+                                              ExportType p_type,
+                                              const QString &p_outputDir);
+
+    // Export @p_tasks as @p_type.
+    // Will return until all the tasks are finished or cancelled.
+    // Returns the number of notes exported.
+    int exportNotes(const QVector<VExportTask> &p_tasks, ExportType p_type);
+
+    // Export all the Markdown notes in @p_dir as PDF files into a temporary
+    // folder and merge them into one PDF file @p_filePath, with an outline
+    // following the folder structure.
+    // Returns the number of notes merged.
+    int exportToOnePdf(VDirectory *p_dir, const QString &p_filePath);
+
+    void setWorkerCount(int p_count);
+
+    void setPageLayout(const QPageLayout &p_layout);
+
+    // Skip notes whose target file is newer than the note itself.
+    // This is used to resume an interrupted export.
+    void setSkipUpToDate(bool p_skip);
+
+    // Number of notes skipped in last export.
+    int getSkippedCount() const;
+
+    // Paths of notes failed to export in last export.
+    const QStringList &getFailedNotes() const;
+
+    // Default number of the web pages.
+    static int defaultWorkerCount();
+
+    // Whether the target file of @p_task is newer than the note.
+    static bool isUpToDate(const VExportTask &p_task);
+
+    // Write @p_data to @p_filePath via a temporary file, so an interrupted
+    // export will not leave a broken target file.
+    static bool writeTargetFile(const QString &p_filePath, const QByteArray &p_data);
+
+public slots:
+    void cancel();
+
+signals:
+    // @p_done: number of tasks finished, including skipped and failed ones.
+    void progressChanged(int p_done, int p_total, const QString &p_name);
+
+    // Emitted when merging PDF files in exportToOnePdf().
+    void mergeProgressChanged(int p_done, int p_total);
+
+private:
+    enum NoteState
+    {
+        NotReady = 0,
+        WebLogicsReady = 0x1,
+        WebLoadFinished = 0x2,
+        Ready = 0x3,
+        Failed = 0x4,
+        Outputing = 0x8,
+        Finished = 0x10
+    };
+
+    struct Worker
+    {
+        Worker()
+            : m_webViewer(NULL), m_taskIdx(-1), m_isOpened(false),
+              m_state(NoteState::NotReady)
+        {
+        }
+
+        VWebView *m_webViewer;
+
+        // Index of the task in process. -1 indicates idle.
+        int m_taskIdx;
+
+        // Whether the note is opened before the export.
+        bool m_isOpened;
+
+        int m_state;
+
+        // Started once the web side is ready.
+        QElapsedTimer m_readyTimer;
+
+        // Started with the task to give up a note which never gets ready.
+        QElapsedTimer m_taskTimer;
+    };
+
+    static void generateTasks(VDirectory *p_dir,
+                              const QString &p_suffix,
+                              const QString &p_outputDir,
+                              QVector<VExportTask> &p_tasks);
+
+    // Start to process task @p_idx in @p_worker.
+    // Returns false if the task is skipped or failed.
+    bool startTask(int p_workerIdx, int p_idx);
+
+    // Finish the task in process in @p_worker and make it idle.
+    void finishTask(Worker &p_worker);
+
+    void initWebViewer(int p_workerIdx, VFile *p_file);
+
+    // Output the loaded note of @p_workerIdx to the target file asynchronously.
+    void outputNote(int p_workerIdx);
+
+    MarkdownConverterType m_mdType;
+    QString m_htmlTemplate;
+    ExportType m_type;
+    QPageLayout m_pageLayout;
+    int m_workerCount;
+    bool m_skipUpToDate;
+    bool m_cancelled;
+
+    QVector<VExportTask> m_tasks;
+    QVector<Worker> m_workers;
+
+    // Used to generate standalone HTML files.
+    VHtmlExporter *m_htmlExporter;
+
+    int m_skippedCount;
+    QStringList m_failedNotes;
+};
+
+inline void VBatchExporter::setWorkerCount(int p_count)
+{
+    m_workerCount = qMax(1, p_count);
+}
+
+inline void VBatchExporter::setPageLayout(const QPageLayout &p_layout)
+{
+    m_pageLayout = p_layout;
+}
+
+inline void VBatchExporter::setSkipUpToDate(bool p_skip)
+{
+    m_skipUpToDate = p_skip;
+}
+
+inline int VBatchExporter::getSkippedCount() const
+{
+    return m_skippedCount;
+}
+
+inline const QStringList &VBatchExporter::getFailedNotes() const
+{
+    return m_failedNotes;
+}
+
+inline void VBatchExporter::cancel()
+{
+    m_cancelled = true;
+}
+
+#endif // VBATCHEXPORTER_H
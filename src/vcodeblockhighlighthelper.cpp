@@ -2,6 +2,7 @@
 
 #include <QDebug>
 #include <QStringList>
+#include <QJsonObject>
 #include "vdocument.h"
 #include "utils/vutils.h"
 
@@ -15,6 +16,8 @@ VCodeBlockHighlightHelper::VCodeBlockHighlightHelper(HGMarkdownHighlighter *p_hi
             this, &VCodeBlockHighlightHelper::handleCodeBlocksUpdated);
     connect(m_vdocument, &VDocument::textHighlighted,
             this, &VCodeBlockHighlightHelper::handleTextHighlightResult);
+    connect(m_vdocument, &VDocument::textsHighlighted,
+            this, &VCodeBlockHighlightHelper::handleTextsHighlightResult);
     connect(m_vdocument, &VDocument::readyToHighlightText,
             m_highlighter, &HGMarkdownHighlighter::updateHighlight);
 }
@@ -56,10 +59,21 @@ void VCodeBlockHighlightHelper::handleCodeBlocksUpdated(const QList<VCodeBlock>
 {
     int curStamp = m_timeStamp.fetchAndAddRelaxed(1) + 1;
     m_codeBlocks = p_codeBlocks;
+    if (m_codeBlocks.isEmpty()) {
+        return;
+    }
+
+    // Send all the code blocks in one message. The index of each code block
+    // is used as its id.
+    QJsonArray texts;
     for (int i = 0; i < m_codeBlocks.size(); ++i) {
-        QString unindentedText = unindentCodeBlock(m_codeBlocks[i].m_text);
-        m_vdocument->highlightTextAsync(unindentedText, i, curStamp);
+        QJsonObject item;
+        item["id"] = i;
+        item["text"] = unindentCodeBlock(m_codeBlocks[i].m_text);
+        texts.append(item);
     }
+
+    m_vdocument->highlightTextsAsync(texts, curStamp);
 }
 
 void VCodeBlockHighlightHelper::handleTextHighlightResult(const QString &p_html,
@@ -74,6 +88,28 @@ void VCodeBlockHighlightHelper::handleTextHighlightResult(const QString &p_html,
     parseHighlightResult(p_timeStamp, p_id, p_html);
 }
 
+void VCodeBlockHighlightHelper::handleTextsHighlightResult(const QJsonArray &p_results,
+                                                           int p_timeStamp)
+{
+    for (auto const &val : p_results) {
+        // Abandon obsolete results.
+        if (m_timeStamp.load() != p_timeStamp) {
+            return;
+        }
+
+        QJsonObject item = val.toObject();
+        int id = item["id"].toInt(-1);
+        if (id < 0 || id >= m_codeBlocks.size()) {
+            qWarning() << "invalid id of highlighted result" << id;
+            // Still need to notify the highlighter to trigger the rehighlight.
+            m_highlighter->setCodeBlockHighlights(QList<HLUnitPos>());
+            continue;
+        }
+
+        parseHighlightResult(p_timeStamp, id, item["html"].toString());
+    }
+}
+
 static void revertEscapedHtml(QString &p_html)
 {
     p_html.replace("&gt;", ">").replace("&lt;", "<").replace("&amp;", "&");
@@ -5,6 +5,7 @@
 #include <QList>
 #include <QAtomicInteger>
 #include <QXmlStreamReader>
+#include <QJsonArray>
 #include "vconfigmanager.h"
 
 class VDocument;
@@ -22,6 +23,9 @@ private slots:
     void handleCodeBlocksUpdated(const QList<VCodeBlock> &p_codeBlocks);
     void handleTextHighlightResult(const QString &p_html, int p_id, int p_timeStamp);
 
+    // Handle the results of all the code blocks in one batch.
+    void handleTextsHighlightResult(const QJsonArray &p_results, int p_timeStamp);
+
 private:
     void parseHighlightResult(int p_timeStamp, int p_idx, const QString &p_html);
 
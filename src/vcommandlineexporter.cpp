@@ -0,0 +1,308 @@
+#include "vcommandlineexporter.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+
+#include "utils/vutils.h"
+#include "vconfigmanager.h"
+#include "vnote.h"
+#include "vnotebook.h"
+#include "vdirectory.h"
+#include "vbatchexporter.h"
+#include "vhtmlexporter.h"
+
+extern VConfigManager *g_config;
+extern VNote *g_vnote;
+
+const QString VCommandLineExporter::c_exportOption = "--export";
+
+const QString VCommandLineExporter::c_exportHtmlOption = "--export-html";
+
+bool VCommandLineExporter::isExportRequested(int p_argc, char *p_argv[])
+{
+    for (int i = 1; i < p_argc; ++i) {
+        if (c_exportOption == p_argv[i] || c_exportHtmlOption == p_argv[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void VCommandLineExporter::printMessage(const QString &p_msg)
+{
+    QTextStream err(stderr);
+    err << p_msg << endl;
+}
+
+void VCommandLineExporter::printUsage()
+{
+    printMessage(QString("Usage: VNote %1 <notebook name, notebook or folder path> "
+                         "--output <output folder> [--format pdf|html] "
+                         "[--jobs <number>] [--skip-exported] [--merge]").arg(c_exportOption));
+    printMessage(QString("       VNote %1 <notebook or folder path> <output folder>")
+                   .arg(c_exportHtmlOption));
+}
+
+bool VCommandLineExporter::parseArguments(const QStringList &p_args, ExportOptions &p_options)
+{
+    int idx = p_args.indexOf(c_exportHtmlOption);
+    if (idx != -1) {
+        if (idx + 2 >= p_args.size()) {
+            return false;
+        }
+
+        p_options.m_source = p_args[idx + 1];
+        p_options.m_output = p_args[idx + 2];
+        p_options.m_type = ExportType::HTML;
+        p_options.m_headless = true;
+        return true;
+    }
+
+    for (int i = 1; i < p_args.size(); ++i) {
+        const QString &arg = p_args[i];
+        bool hasValue = i + 1 < p_args.size();
+        if (arg == c_exportOption && hasValue) {
+            p_options.m_source = p_args[++i];
+        } else if (arg == "--output" && hasValue) {
+            p_options.m_output = p_args[++i];
+        } else if (arg == "--format" && hasValue) {
+            QString format = p_args[++i].toLower();
+            if (format == "pdf") {
+                p_options.m_type = ExportType::PDF;
+            } else if (format == "html") {
+                p_options.m_type = ExportType::HTML;
+            } else {
+                printMessage(QString("unknown format %1").arg(format));
+                return false;
+            }
+        } else if (arg == "--jobs" && hasValue) {
+            bool ok;
+            p_options.m_jobs = p_args[++i].toInt(&ok);
+            if (!ok || p_options.m_jobs < 1) {
+                printMessage(QString("invalid number of jobs %1").arg(p_args[i]));
+                return false;
+            }
+        } else if (arg == "--skip-exported") {
+            p_options.m_skipExported = true;
+        } else if (arg == "--merge") {
+            p_options.m_merge = true;
+        } else {
+            printMessage(QString("unknown argument %1").arg(arg));
+            return false;
+        }
+    }
+
+    if (p_options.m_merge && p_options.m_type != ExportType::PDF) {
+        printMessage("--merge is only supported for PDF");
+        return false;
+    }
+
+    // Hoedown could generate HTML natively.
+    if (p_options.m_type == ExportType::HTML
+        && g_config->getMdConverterType() == MarkdownConverterType::Hoedown) {
+        p_options.m_headless = true;
+    }
+
+    return !p_options.m_source.isEmpty() && !p_options.m_output.isEmpty();
+}
+
+int VCommandLineExporter::run(const QStringList &p_args)
+{
+    ExportOptions options;
+    if (!parseArguments(p_args, options)) {
+        printUsage();
+        return 1;
+    }
+
+    // VNote will init the HTML templates.
+    VNote vnote;
+    g_vnote = &vnote;
+
+    int ret = exportNotes(&vnote, options);
+
+    g_vnote = NULL;
+    return ret;
+}
+
+int VCommandLineExporter::exportNotes(VNote *p_vnote, const ExportOptions &p_options)
+{
+    QString source = p_options.m_source;
+    if (!QFileInfo::exists(source)) {
+        // Try the name of a notebook.
+        const QVector<VNotebook *> &notebooks = p_vnote->getNotebooks();
+        for (auto const &nb : notebooks) {
+            if (nb->getName() == source) {
+                source = nb->getPath();
+                break;
+            }
+        }
+    }
+
+    source = QDir::cleanPath(QFileInfo(source).absoluteFilePath());
+    QString output = QDir::cleanPath(QFileInfo(p_options.m_output).absoluteFilePath());
+
+    VNotebook *notebook = NULL;
+    VDirectory *dir = openDirectory(source, notebook);
+    if (!dir) {
+        printMessage(QString("%1 is not a folder of a notebook").arg(source));
+        delete notebook;
+        return 1;
+    }
+
+    QVector<VExportTask> tasks = VBatchExporter::generateTasks(dir, p_options.m_type, output);
+    if (p_options.m_merge) {
+        int ret = mergeNotes(dir, tasks.size(), output, p_options);
+        delete notebook;
+        return ret;
+    }
+
+    printMessage(QString("exporting %1 notes in %2 to %3 as %4")
+                   .arg(tasks.size())
+                   .arg(source)
+                   .arg(output)
+                   .arg(p_options.m_type == ExportType::PDF ? "PDF" : "HTML"));
+
+    int exportedNum = 0;
+    int skippedNum = 0;
+    QStringList failedNotes;
+    if (p_options.m_headless) {
+        VHtmlExporter exporter;
+        if (p_options.m_jobs > 0) {
+            exporter.setWorkerCount(p_options.m_jobs);
+        }
+
+        QObject::connect(&exporter, &VHtmlExporter::progressChanged,
+                         [](int p_done, int p_total, const QString &p_name) {
+                             printMessage(QString("[%1/%2] %3").arg(p_done)
+                                                               .arg(p_total)
+                                                               .arg(p_name));
+                         });
+
+        exportedNum = exporter.exportNotes(tasks, p_options.m_skipExported);
+        skippedNum = exporter.getSkippedCount();
+        failedNotes = exporter.getFailedNotes();
+    } else {
+        VBatchExporter exporter(g_config->getMdConverterType());
+        if (p_options.m_jobs > 0) {
+            exporter.setWorkerCount(p_options.m_jobs);
+        }
+
+        exporter.setSkipUpToDate(p_options.m_skipExported);
+        QObject::connect(&exporter, &VBatchExporter::progressChanged,
+                         [](int p_done, int p_total, const QString &p_name) {
+                             printMessage(QString("[%1/%2] %3").arg(p_done)
+                                                               .arg(p_total)
+                                                               .arg(p_name));
+                         });
+
+        exportedNum = exporter.exportNotes(tasks, p_options.m_type);
+        skippedNum = exporter.getSkippedCount();
+        failedNotes = exporter.getFailedNotes();
+    }
+
+    for (auto const &note : failedNotes) {
+        printMessage(QString("fail to export %1").arg(note));
+    }
+
+    printMessage(QString("%1 notes exported, %2 skipped, %3 failed").arg(exportedNum)
+                                                                    .arg(skippedNum)
+                                                                    .arg(failedNotes.size()));
+
+    delete notebook;
+
+    // Notes neither exported nor skipped are failed.
+    if (!failedNotes.isEmpty() || exportedNum + skippedNum != tasks.size()) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int VCommandLineExporter::mergeNotes(VDirectory *p_dir,
+                                     int p_total,
+                                     const QString &p_output,
+                                     const ExportOptions &p_options)
+{
+    printMessage(QString("merging %1 notes in %2 into %3").arg(p_total)
+                                                          .arg(p_dir->retrivePath())
+                                                          .arg(p_output));
+
+    VBatchExporter exporter(g_config->getMdConverterType());
+    if (p_options.m_jobs > 0) {
+        exporter.setWorkerCount(p_options.m_jobs);
+    }
+
+    QObject::connect(&exporter, &VBatchExporter::progressChanged,
+                     [](int p_done, int p_total, const QString &p_name) {
+                         printMessage(QString("[%1/%2] %3").arg(p_done)
+                                                           .arg(p_total)
+                                                           .arg(p_name));
+                     });
+
+    int mergedNum = exporter.exportToOnePdf(p_dir, p_output);
+    const QStringList &failedNotes = exporter.getFailedNotes();
+    for (auto const &note : failedNotes) {
+        printMessage(QString("fail to export %1").arg(note));
+    }
+
+    printMessage(QString("%1 notes merged, %2 failed").arg(mergedNum).arg(failedNotes.size()));
+
+    if (mergedNum == 0 || mergedNum != p_total) {
+        return 1;
+    }
+
+    return 0;
+}
+
+VDirectory *VCommandLineExporter::openDirectory(const QString &p_path, VNotebook *&p_notebook)
+{
+    p_notebook = NULL;
+    if (!QFileInfo(p_path).isDir() || !VConfigManager::directoryConfigExist(p_path)) {
+        return NULL;
+    }
+
+    // The root of the notebook is the top-most directory with a config file.
+    QDir rootDir(p_path);
+    while (true) {
+        QDir parentDir(rootDir);
+        if (!parentDir.cdUp() || !VConfigManager::directoryConfigExist(parentDir.absolutePath())) {
+            break;
+        }
+
+        rootDir = parentDir;
+    }
+
+    QString rootPath = QDir::cleanPath(rootDir.absolutePath());
+    p_notebook = new VNotebook(VUtils::directoryNameFromPath(rootPath), rootPath);
+    if (!p_notebook->readConfig() || !p_notebook->open()) {
+        return NULL;
+    }
+
+    QStringList parts;
+    if (!VUtils::splitPathInBasePath(rootPath, p_path, parts)) {
+        return NULL;
+    }
+
+#if defined(Q_OS_WIN)
+    bool caseSensitive = false;
+#else
+    bool caseSensitive = true;
+#endif
+
+    VDirectory *dir = p_notebook->getRootDir();
+    for (auto const &part : parts) {
+        if (!dir->open()) {
+            return NULL;
+        }
+
+        dir = dir->findSubDirectory(part, caseSensitive);
+        if (!dir) {
+            return NULL;
+        }
+    }
+
+    return dir;
+}
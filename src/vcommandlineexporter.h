@@ -0,0 +1,89 @@
+#ifndef VCOMMANDLINEEXPORTER_H
+#define VCOMMANDLINEEXPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include "vconstants.h"
+
+class VNote;
+class VNotebook;
+class VDirectory;
+
+// Export notes from the command line without the main window.
+// Usage:
+//     VNote --export <notebook name, notebook or folder path>
+//           --output <output folder>
+//           [--format pdf|html] [--jobs <number>] [--skip-exported]
+//           [--merge]
+//     VNote --export-html <notebook or folder path> <output folder>
+// --export-html exports HTML natively via Hoedown without web pages.
+// --merge merges all the notes into one PDF file specified by --output.
+class VCommandLineExporter
+{
+public:
+    // Whether the command line arguments request an export.
+    // Should be called before QApplication is created.
+    static bool isExportRequested(int p_argc, char *p_argv[]);
+
+    // Run the export given the command line arguments.
+    // Returns the exit code of the application.
+    static int run(const QStringList &p_args);
+
+private:
+    VCommandLineExporter();
+
+    struct ExportOptions
+    {
+        ExportOptions()
+            : m_type(ExportType::PDF), m_headless(false), m_jobs(0),
+              m_skipExported(false), m_merge(false)
+        {
+        }
+
+        QString m_source;
+        QString m_output;
+        ExportType m_type;
+
+        // Convert HTML natively via Hoedown without web pages.
+        bool m_headless;
+
+        // Number of web pages, or threads if headless, used in parallel.
+        // 0 to use the default.
+        int m_jobs;
+
+        bool m_skipExported;
+
+        // Merge all the notes into one PDF file.
+        bool m_merge;
+    };
+
+    // Parse @p_args into @p_options.
+    // Returns false if the arguments are invalid.
+    static bool parseArguments(const QStringList &p_args, ExportOptions &p_options);
+
+    // Returns the exit code of the application.
+    static int exportNotes(VNote *p_vnote, const ExportOptions &p_options);
+
+    // Merge all the notes in @p_dir into one PDF file @p_output.
+    // @p_total: number of notes to merge.
+    // Returns the exit code of the application.
+    static int mergeNotes(VDirectory *p_dir,
+                          int p_total,
+                          const QString &p_output,
+                          const ExportOptions &p_options);
+
+    // Open the directory @p_path in a notebook.
+    // The notebook containing @p_path will be created as @p_notebook,
+    // which should be deleted by the caller.
+    // Returns NULL if @p_path is not a directory of a notebook.
+    static VDirectory *openDirectory(const QString &p_path, VNotebook *&p_notebook);
+
+    static void printMessage(const QString &p_msg);
+
+    static void printUsage();
+
+    static const QString c_exportOption;
+    static const QString c_exportHtmlOption;
+};
+
+#endif // VCOMMANDLINEEXPORTER_H
@@ -43,6 +43,10 @@ public:
     static bool directoryConfigExist(const QString &path);
     static bool deleteDirectoryConfig(const QString &path);
 
+    // See if the old c_obsoleteDirConfigFile exists. If so, rename it to
+    // the new one; if not, use the c_dirConfigFile.
+    static QString fetchDirConfigFilePath(const QString &p_path);
+
     static QString getLogFilePath();
 
     // Get the path of the folder used to store default notebook.
@@ -267,9 +271,6 @@ private:
     bool outputDefaultCssStyle() const;
     bool outputDefaultEditorStyle() const;
 
-    // See if the old c_obsoleteDirConfigFile exists. If so, rename it to
-    // the new one; if not, use the c_dirConfigFile.
-    static QString fetchDirConfigFilePath(const QString &p_path);
 
     // Read the [shortcuts] section in settings to init m_shortcuts.
     // Will remove invalid config items.
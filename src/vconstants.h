@@ -42,6 +42,12 @@ enum class TextDecoration { None,
                             Strikethrough,
                             InlineCode };
 
+enum class ExportType
+{
+    PDF = 0,
+    HTML
+};
+
 enum FindOption
 {
     CaseSensitive = 0x1U,
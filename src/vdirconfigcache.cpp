@@ -0,0 +1,263 @@
+#include "vdirconfigcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QVariantMap>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#include "vconfigmanager.h"
+
+extern VConfigManager *g_config;
+
+static const QString c_cacheFolderName = "notebook_cache";
+
+static const QString c_cacheSuffix = ".cache";
+
+static const quint32 c_cacheMagic = 0x564e4443;
+
+static const quint32 c_cacheVersion = 2;
+
+// An entry cached within this interval in msecs after its config file is
+// modified is not trusted, since the file may be modified again without
+// changing the modification time.
+static const qint64 c_racyInterval = 1000;
+
+VDirConfigCache::VDirConfigCache(const QString &p_notebookPath)
+    : m_notebookPath(QDir::cleanPath(p_notebookPath)), m_loaded(false), m_dirty(false)
+{
+    // CLI export may run without the config manager.
+    if (g_config) {
+        QByteArray hash = QCryptographicHash::hash(m_notebookPath.toUtf8(),
+                                                   QCryptographicHash::Md5);
+        QDir dir(g_config->getConfigFolder() + QDir::separator() + c_cacheFolderName);
+        m_cacheFilePath = dir.filePath(QString(hash.toHex()) + c_cacheSuffix);
+    }
+}
+
+VDirConfigCache::~VDirConfigCache()
+{
+    save();
+}
+
+QString VDirConfigCache::entryKey(const QString &p_path) const
+{
+    return QDir(m_notebookPath).relativeFilePath(QDir::cleanPath(p_path));
+}
+
+QJsonObject VDirConfigCache::readDirectoryConfig(const QString &p_path)
+{
+    if (m_cacheFilePath.isEmpty()) {
+        return VConfigManager::readDirectoryConfig(p_path);
+    }
+
+    load();
+
+    QString key = entryKey(p_path);
+    QFileInfo fi(VConfigManager::fetchDirConfigFilePath(p_path));
+    if (!fi.exists()) {
+        if (m_entries.remove(key) > 0) {
+            m_dirty = true;
+        }
+
+        return VConfigManager::readDirectoryConfig(p_path);
+    }
+
+    m_visited.insert(key);
+
+    qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+    qint64 size = fi.size();
+    auto it = m_entries.constFind(key);
+    if (it != m_entries.constEnd() && isEntryValid(*it, modified, size)) {
+        return it->m_json;
+    }
+
+    // If the file is changed after the stat, the entry will just be stale
+    // next time.
+    qint64 cached = QDateTime::currentMSecsSinceEpoch();
+    QJsonObject json = VConfigManager::readDirectoryConfig(p_path);
+    if (!json.isEmpty()) {
+        Entry entry;
+        entry.m_modified = modified;
+        entry.m_size = size;
+        entry.m_cached = cached;
+        entry.m_json = json;
+        m_entries.insert(key, entry);
+        m_dirty = true;
+    }
+
+    return json;
+}
+
+bool VDirConfigCache::isEntryValid(const Entry &p_entry, qint64 p_modified, qint64 p_size)
+{
+    return p_entry.m_modified == p_modified
+           && p_entry.m_size == p_size
+           && p_entry.m_cached - p_entry.m_modified > c_racyInterval;
+}
+
+bool VDirConfigCache::writeDirectoryConfig(const QString &p_path, const QJsonObject &p_json)
+{
+    if (!VConfigManager::writeDirectoryConfig(p_path, p_json)) {
+        return false;
+    }
+
+    if (!m_cacheFilePath.isEmpty()) {
+        updateEntry(p_path, p_json);
+    }
+
+    return true;
+}
+
+bool VDirConfigCache::deleteDirectoryConfig(const QString &p_path)
+{
+    if (m_loaded && m_entries.remove(entryKey(p_path)) > 0) {
+        m_dirty = true;
+    }
+
+    return VConfigManager::deleteDirectoryConfig(p_path);
+}
+
+void VDirConfigCache::updateEntry(const QString &p_path, const QJsonObject &p_json)
+{
+    load();
+
+    QString key = entryKey(p_path);
+    QFileInfo fi(VConfigManager::fetchDirConfigFilePath(p_path));
+    Entry entry;
+    entry.m_modified = fi.lastModified().toMSecsSinceEpoch();
+    entry.m_size = fi.size();
+    entry.m_cached = QDateTime::currentMSecsSinceEpoch();
+    entry.m_json = p_json;
+    m_entries.insert(key, entry);
+    m_visited.insert(key);
+    m_dirty = true;
+}
+
+void VDirConfigCache::load()
+{
+    if (m_loaded) {
+        return;
+    }
+
+    m_loaded = true;
+
+    QFile file(m_cacheFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    QString notebookPath;
+    qint32 count = 0;
+    in >> magic >> version >> notebookPath >> count;
+    if (magic != c_cacheMagic
+        || version != c_cacheVersion
+        || notebookPath != m_notebookPath
+        || in.status() != QDataStream::Ok) {
+        qWarning() << "ignore invalid notebook cache" << m_cacheFilePath;
+        return;
+    }
+
+    m_entries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString key;
+        Entry entry;
+        QVariantMap data;
+        in >> key >> entry.m_modified >> entry.m_size >> entry.m_cached >> data;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "notebook cache is truncated" << m_cacheFilePath;
+            m_entries.clear();
+            return;
+        }
+
+        entry.m_json = QJsonObject::fromVariantMap(data);
+        m_entries.insert(key, entry);
+    }
+
+    qDebug() << "load notebook cache" << m_cacheFilePath << m_entries.size();
+}
+
+void VDirConfigCache::prune()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (m_visited.contains(it.key())) {
+            ++it;
+            continue;
+        }
+
+        QString dirPath = QDir(m_notebookPath).filePath(it.key());
+        if (QFileInfo::exists(VConfigManager::fetchDirConfigFilePath(dirPath))) {
+            ++it;
+        } else {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        }
+    }
+
+    // Entries left are checked.
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        m_visited.insert(it.key());
+    }
+}
+
+void VDirConfigCache::save()
+{
+    if (m_cacheFilePath.isEmpty() || !m_loaded) {
+        return;
+    }
+
+    prune();
+    if (!m_dirty) {
+        return;
+    }
+
+    QDir dir;
+    if (!dir.mkpath(QFileInfo(m_cacheFilePath).path())) {
+        qWarning() << "fail to create notebook cache folder" << m_cacheFilePath;
+        return;
+    }
+
+    QSaveFile file(m_cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "fail to open notebook cache" << m_cacheFilePath << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << c_cacheMagic << c_cacheVersion << m_notebookPath << qint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key()
+            << it->m_modified
+            << it->m_size
+            << it->m_cached
+            << it->m_json.toVariantMap();
+    }
+
+    if (!file.commit()) {
+        qWarning() << "fail to write notebook cache" << m_cacheFilePath << file.errorString();
+        return;
+    }
+
+    m_dirty = false;
+}
+
+void VDirConfigCache::clear()
+{
+    m_entries.clear();
+    m_visited.clear();
+    m_loaded = true;
+    m_dirty = false;
+
+    if (!m_cacheFilePath.isEmpty() && QFile::exists(m_cacheFilePath)) {
+        QFile::remove(m_cacheFilePath);
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef VDIRCONFIGCACHE_H
+#define VDIRCONFIGCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QJsonObject>
+
+// Cache of the directory configurations of one notebook.
+// All the configurations are kept in one binary file in the config folder, so
+// opening the folders of a notebook reads one file instead of parsing the
+// config file of each folder. An entry is used only if the modification time
+// and size of its config file are unchanged, and the file was not modified
+// around the time the entry was cached, in case it is changed again within the
+// resolution of the modification time. The config files in the notebook are
+// still the source of truth.
+class VDirConfigCache
+{
+public:
+    explicit VDirConfigCache(const QString &p_notebookPath);
+
+    // Save the cache if changed.
+    ~VDirConfigCache();
+
+    // Read the config of directory @p_path.
+    // The config file is read and parsed only if the cached one is stale.
+    QJsonObject readDirectoryConfig(const QString &p_path);
+
+    // Write @p_json to the config file of directory @p_path and update the
+    // cached one.
+    bool writeDirectoryConfig(const QString &p_path, const QJsonObject &p_json);
+
+    // Delete the config file of directory @p_path and drop the cached one.
+    bool deleteDirectoryConfig(const QString &p_path);
+
+    // Write the cache to disk if it is changed.
+    // Entries not read in this session are dropped if their config files do
+    // not exist any more.
+    void save();
+
+    // Drop all the entries and remove the cache file.
+    void clear();
+
+private:
+    struct Entry
+    {
+        // Modification time of the config file in msecs since epoch.
+        qint64 m_modified;
+
+        qint64 m_size;
+
+        // Time when the config file is read in msecs since epoch.
+        qint64 m_cached;
+
+        QJsonObject m_json;
+    };
+
+    // Whether @p_entry could be used for a config file modified at @p_modified
+    // with size @p_size.
+    static bool isEntryValid(const Entry &p_entry, qint64 p_modified, qint64 p_size);
+
+    // Drop the entries whose config files are gone.
+    void prune();
+
+    // Load the cache file if not loaded yet.
+    void load();
+
+    // Key of directory @p_path in m_entries.
+    QString entryKey(const QString &p_path) const;
+
+    // Update the entry of directory @p_path after its config file is written.
+    void updateEntry(const QString &p_path, const QJsonObject &p_json);
+
+    QString m_notebookPath;
+
+    QString m_cacheFilePath;
+
+    // Relative path of directory -> entry.
+    QHash<QString, Entry> m_entries;
+
+    // Keys of the entries read or written in this session.
+    QSet<QString> m_visited;
+
+    bool m_loaded;
+
+    // Whether m_entries differs from the cache file.
+    bool m_dirty;
+};
+
+#endif // VDIRCONFIGCACHE_H
@@ -6,13 +6,17 @@
 #include "vconfigmanager.h"
 #include "vfile.h"
 #include "utils/vutils.h"
+#include "vnote.h"
 
 extern VConfigManager *g_config;
+extern VNote *g_vnote;
+
+int VDirectory::s_pathRevision = 0;
 
 VDirectory::VDirectory(VNotebook *p_notebook,
                        const QString &p_name, QObject *p_parent)
-    : QObject(p_parent), m_notebook(p_notebook), m_name(p_name), m_opened(false),
-      m_expanded(false)
+    : QObject(p_parent), m_notebook(p_notebook), m_name(p_name), m_filesLoaded(false),
+      m_opened(false), m_expanded(false), m_pathRevision(-1)
 {
 }
 
@@ -22,10 +26,10 @@ bool VDirectory::open()
         return true;
     }
 
-    V_ASSERT(m_subDirs.isEmpty() && m_files.isEmpty());
+    V_ASSERT(m_subDirs.isEmpty() && m_files.isEmpty() && m_fileNames.isEmpty());
 
     QString path = retrivePath();
-    QJsonObject configJson = VConfigManager::readDirectoryConfig(path);
+    QJsonObject configJson = m_notebook->readDirectoryConfig(path);
     if (configJson.isEmpty()) {
         qWarning() << "invalid directory configuration in path" << path;
         return false;
@@ -41,12 +45,13 @@ bool VDirectory::open()
 
     // [files] section
     QJsonArray fileJson = configJson[DirConfig::c_files].toArray();
+    m_fileNames.reserve(fileJson.size());
     for (int i = 0; i < fileJson.size(); ++i) {
         QJsonObject fileItem = fileJson[i].toObject();
-        VFile *file = new VFile(fileItem[DirConfig::c_name].toString(), this);
-        m_files.append(file);
+        m_fileNames.append(fileItem[DirConfig::c_name].toString());
     }
 
+    m_filesLoaded = false;
     m_opened = true;
     return true;
 }
@@ -70,41 +75,69 @@ void VDirectory::close()
         delete file;
     }
     m_files.clear();
+    m_fileNames.clear();
+    m_filesLoaded = false;
 
     m_opened = false;
 }
 
-QString VDirectory::retriveBasePath() const
+void VDirectory::loadFiles() const
 {
-    return VUtils::basePathFromPath(retrivePath());
+    if (m_filesLoaded || !m_opened) {
+        return;
+    }
+
+    V_ASSERT(m_files.isEmpty());
+    m_files.reserve(m_fileNames.size());
+    for (auto const &name : m_fileNames) {
+        VFile *file = new VFile(name, const_cast<VDirectory *>(this));
+        m_files.append(file);
+        if (g_vnote) {
+            g_vnote->indexInternalFile(file);
+        }
+    }
+
+    m_fileNames.clear();
+    m_filesLoaded = true;
 }
 
-QString VDirectory::retrivePath(const VDirectory *p_dir) const
+QStringList VDirectory::getFileNames() const
 {
-    if (!p_dir) {
-        return "";
+    if (!m_filesLoaded) {
+        return m_fileNames;
     }
-    VDirectory *parentDir = (VDirectory *)p_dir->parent();
-    if (parentDir) {
-        // Not the root directory
-        return QDir(retrivePath(parentDir)).filePath(p_dir->getName());
-    } else {
-        return m_notebook->getPath();
+
+    QStringList names;
+    names.reserve(m_files.size());
+    for (auto const &file : m_files) {
+        names.append(file->getName());
     }
+
+    return names;
 }
 
-QString VDirectory::retriveRelativePath(const VDirectory *p_dir) const
+QString VDirectory::retriveBasePath() const
 {
-    if (!p_dir) {
-        return "";
+    return VUtils::basePathFromPath(retrivePath());
+}
+
+void VDirectory::updatePaths() const
+{
+    if (m_pathRevision == s_pathRevision) {
+        return;
     }
-    VDirectory *parentDir = (VDirectory *)p_dir->parent();
+
+    const VDirectory *parentDir = getParentDirectory();
     if (parentDir) {
         // Not the root directory
-        return QDir(retriveRelativePath(parentDir)).filePath(p_dir->getName());
+        m_path = QDir(parentDir->retrivePath()).filePath(m_name);
+        m_relativePath = QDir(parentDir->retriveRelativePath()).filePath(m_name);
     } else {
-        return "";
+        m_path = m_notebook->getPath();
+        m_relativePath = "";
     }
+
+    m_pathRevision = s_pathRevision;
 }
 
 QJsonObject VDirectory::toConfigJson() const
@@ -122,9 +155,10 @@ QJsonObject VDirectory::toConfigJson() const
     dirJson[DirConfig::c_subDirectories] = subDirs;
 
     QJsonArray files;
-    for (int i = 0; i < m_files.size(); ++i) {
+    QStringList fileNames = getFileNames();
+    for (int i = 0; i < fileNames.size(); ++i) {
         QJsonObject item;
-        item[DirConfig::c_name] = m_files[i]->getName();
+        item[DirConfig::c_name] = fileNames[i];
 
         files.append(item);
     }
@@ -153,7 +187,7 @@ bool VDirectory::writeToConfig() const
 
 bool VDirectory::writeToConfig(const QJsonObject &p_json) const
 {
-    return VConfigManager::writeDirectoryConfig(retrivePath(), p_json);
+    return m_notebook->writeDirectoryConfig(retrivePath(), p_json);
 }
 
 void VDirectory::addNotebookConfig(QJsonObject &p_json) const
@@ -195,7 +229,7 @@ VDirectory *VDirectory::createSubDirectory(const QString &p_name)
 
     m_subDirs.append(ret);
     if (!writeToConfig()) {
-        VConfigManager::deleteDirectoryConfig(QDir(path).filePath(p_name));
+        m_notebook->deleteDirectoryConfig(QDir(path).filePath(p_name));
         dir.rmdir(p_name);
         delete ret;
         m_subDirs.removeLast();
@@ -229,6 +263,17 @@ VFile *VDirectory::findFile(const QString &p_name, bool p_caseSensitive)
     }
 
     QString name = p_caseSensitive ? p_name : p_name.toLower();
+
+    // Do not create the VFile objects if there is no such file.
+    if (!m_filesLoaded) {
+        Qt::CaseSensitivity cs = p_caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        if (!m_fileNames.contains(p_name, cs)) {
+            return NULL;
+        }
+
+        loadFiles();
+    }
+
     for (int i = 0; i < m_files.size(); ++i) {
         if (name == (p_caseSensitive ? m_files[i]->getName() : m_files[i]->getName().toLower())) {
             return m_files[i];
@@ -272,6 +317,7 @@ VFile *VDirectory::createFile(const QString &p_name)
 
     file.close();
 
+    loadFiles();
     VFile *ret = new VFile(p_name, this);
     m_files.append(ret);
     if (!writeToConfig()) {
@@ -281,6 +327,10 @@ VFile *VDirectory::createFile(const QString &p_name)
         return NULL;
     }
 
+    if (g_vnote) {
+        g_vnote->indexInternalFile(ret);
+    }
+
     qDebug() << "note" << p_name << "created in folder" << m_name;
 
     return ret;
@@ -292,6 +342,7 @@ bool VDirectory::addFile(VFile *p_file, int p_index)
         return false;
     }
 
+    loadFiles();
     if (p_index == -1) {
         m_files.append(p_file);
     } else {
@@ -309,6 +360,10 @@ bool VDirectory::addFile(VFile *p_file, int p_index)
     }
 
     p_file->setParent(this);
+    invalidatePaths();
+    if (g_vnote) {
+        g_vnote->indexInternalFile(p_file);
+    }
 
     qDebug() << "note" << p_file->getName() << "added to folder" << m_name;
 
@@ -357,6 +412,7 @@ bool VDirectory::addSubDirectory(VDirectory *p_dir, int p_index)
     }
 
     p_dir->setParent(this);
+    invalidatePaths();
 
     qDebug() << "folder" << p_dir->getName() << "added to folder" << m_name;
 
@@ -468,10 +524,12 @@ bool VDirectory::rename(const QString &p_name)
     }
 
     m_name = p_name;
+    invalidatePaths();
 
     // Update parent's config file
     if (!parentDir->writeToConfig()) {
         m_name = oldName;
+        invalidatePaths();
         dir.rename(p_name, m_name);
         return false;
     }
@@ -654,6 +712,7 @@ void VDirectory::setExpanded(bool p_expanded)
 void VDirectory::reorderFiles(int p_first, int p_last, int p_destStart)
 {
     V_ASSERT(m_opened);
+    loadFiles();
     V_ASSERT(p_first <= p_last);
     V_ASSERT(p_last < m_files.size());
     V_ASSERT(p_destStart < p_first || p_destStart > p_last);
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QPointer>
 #include <QJsonObject>
@@ -62,13 +63,20 @@ public:
 
     const QVector<VDirectory *> &getSubDirs() const;
     const QString &getName() const;
+
+    // Invalidate the cached paths.
     void setName(const QString &p_name);
     bool isOpened() const;
     VDirectory *getParentDirectory();
     const VDirectory *getParentDirectory() const;
     VNotebook *getNotebook();
     const VNotebook *getNotebook() const;
+    // VFile objects are created on first call.
     const QVector<VFile *> &getFiles() const;
+
+    // Names of the files, without creating VFile objects.
+    QStringList getFileNames() const;
+
     QString retrivePath() const;
     QString retriveBasePath() const;
     QString retriveRelativePath() const;
@@ -93,11 +101,16 @@ public:
     // Try to load file given relative path @p_filePath.
     VFile *tryLoadFile(QStringList &p_filePath);
 
+    // Invalidate the cached paths of all the folders and notes.
+    // Should be called when a folder or note is renamed or moved.
+    static void invalidatePaths();
+
+    // Paths cached with a different revision are out of date.
+    static int getPathRevision();
+
 private:
-    // Get the path of @p_dir recursively
-    QString retrivePath(const VDirectory *p_dir) const;
-    // Get teh relative path of @p_dir recursively related to the notebook path
-    QString retriveRelativePath(const VDirectory *p_dir) const;
+    // Compute the path and relative path if the cached ones are out of date.
+    void updatePaths() const;
 
     // Write @p_json to config.
     bool writeToConfig(const QJsonObject &p_json) const;
@@ -120,11 +133,31 @@ private:
     QString m_name;
     // Owner of the sub-directories
     QVector<VDirectory *> m_subDirs;
-    // Owner of the files
-    QVector<VFile *> m_files;
+    // Create VFile objects of the files if not created yet.
+    void loadFiles() const;
+
+    // Owner of the files.
+    // Created lazily since a folder may hold a lot of notes, while most
+    // folders are opened just to list their sub-directories.
+    mutable QVector<VFile *> m_files;
+
+    // Names of the files before m_files is created.
+    mutable QStringList m_fileNames;
+
+    mutable bool m_filesLoaded;
+
     bool m_opened;
     // Whether expanded in the directory tree.
     bool m_expanded;
+
+    // Cached path and relative path related to the notebook path.
+    mutable QString m_path;
+    mutable QString m_relativePath;
+
+    // Revision of the paths when cached.
+    mutable int m_pathRevision;
+
+    static int s_pathRevision;
 };
 
 inline const QVector<VDirectory *> &VDirectory::getSubDirs() const
@@ -140,6 +173,7 @@ inline const QString &VDirectory::getName() const
 inline void VDirectory::setName(const QString &p_name)
 {
     m_name = p_name;
+    invalidatePaths();
 }
 
 inline bool VDirectory::isOpened() const
@@ -159,6 +193,7 @@ inline const VDirectory *VDirectory::getParentDirectory() const
 
 inline const QVector<VFile *> &VDirectory::getFiles() const
 {
+    loadFiles();
     return m_files;
 }
 
@@ -179,12 +214,24 @@ inline const VNotebook *VDirectory::getNotebook() const
 
 inline QString VDirectory::retrivePath() const
 {
-    return retrivePath(this);
+    updatePaths();
+    return m_path;
 }
 
 inline QString VDirectory::retriveRelativePath() const
 {
-    return retriveRelativePath(this);
+    updatePaths();
+    return m_relativePath;
+}
+
+inline void VDirectory::invalidatePaths()
+{
+    ++s_pathRevision;
+}
+
+inline int VDirectory::getPathRevision()
+{
+    return s_pathRevision;
 }
 
 inline bool VDirectory::isExpanded() const
@@ -8,6 +8,7 @@
 #include "utils/vutils.h"
 #include "veditarea.h"
 #include "vconfigmanager.h"
+#include "vexporter.h"
 
 extern VConfigManager *g_config;
 extern VNote *g_vnote;
@@ -78,6 +79,20 @@ void VDirectoryTree::initActions()
     m_openLocationAct->setToolTip(tr("Open the folder containing this folder in operating system"));
     connect(m_openLocationAct, &QAction::triggered,
             this, &VDirectoryTree::openDirectoryLocation);
+
+    m_exportAsPDFAct = new QAction(tr("Export As &PDF"), this);
+    m_exportAsPDFAct->setToolTip(tr("Export all the notes in this folder as PDF files"));
+    connect(m_exportAsPDFAct, &QAction::triggered,
+            this, [this]() {
+                exportDirectory(ExportType::PDF);
+            });
+
+    m_exportAsHTMLAct = new QAction(tr("Export As &HTML"), this);
+    m_exportAsHTMLAct->setToolTip(tr("Export all the notes in this folder as HTML files"));
+    connect(m_exportAsHTMLAct, &QAction::triggered,
+            this, [this]() {
+                exportDirectory(ExportType::HTML);
+            });
 }
 
 void VDirectoryTree::setNotebook(VNotebook *p_notebook)
@@ -319,6 +334,9 @@ void VDirectoryTree::contextMenuRequested(QPoint pos)
     }
 
     if (item) {
+        menu.addSeparator();
+        menu.addAction(m_exportAsPDFAct);
+        menu.addAction(m_exportAsHTMLAct);
         menu.addSeparator();
         menu.addAction(m_openLocationAct);
         menu.addAction(dirInfoAct);
@@ -495,6 +513,18 @@ void VDirectoryTree::openDirectoryLocation() const
     QDesktopServices::openUrl(url);
 }
 
+void VDirectoryTree::exportDirectory(ExportType p_type)
+{
+    QTreeWidgetItem *curItem = currentItem();
+    if (!curItem) {
+        return;
+    }
+
+    VExporter exporter(g_config->getMdConverterType(), this);
+    exporter.exportDirectory(getVDirectory(curItem), p_type);
+    exporter.exec();
+}
+
 void VDirectoryTree::copySelectedDirectories(bool p_cut)
 {
     QList<QTreeWidgetItem *> items = selectedItems();
@@ -11,6 +11,7 @@
 #include "vdirectory.h"
 #include "vnotebook.h"
 #include "vnavigationmode.h"
+#include "vconstants.h"
 
 class VNote;
 class VEditArea;
@@ -56,6 +57,9 @@ private slots:
     void pasteDirectoriesInCurDir();
     void openDirectoryLocation() const;
 
+    // Export all the notes in current directory.
+    void exportDirectory(ExportType p_type);
+
 protected:
     void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void keyPressEvent(QKeyEvent *event) Q_DECL_OVERRIDE;
@@ -119,6 +123,8 @@ private:
     QAction *cutAct;
     QAction *pasteAct;
     QAction *m_openLocationAct;
+    QAction *m_exportAsPDFAct;
+    QAction *m_exportAsHTMLAct;
 
     // Navigation Mode.
     // Map second key to QTreeWidgetItem.
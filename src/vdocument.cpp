@@ -75,6 +75,16 @@ void VDocument::highlightTextCB(const QString &p_html, int p_id, int p_timeStamp
     emit textHighlighted(p_html, p_id, p_timeStamp);
 }
 
+void VDocument::highlightTextsAsync(const QJsonArray &p_texts, int p_timeStamp)
+{
+    emit requestHighlightTexts(p_texts, p_timeStamp);
+}
+
+void VDocument::highlightTextsCB(const QJsonArray &p_results, int p_timeStamp)
+{
+    emit textsHighlighted(p_results, p_timeStamp);
+}
+
 void VDocument::noticeReadyToHighlightText()
 {
     emit readyToHighlightText();
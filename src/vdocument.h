@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QJsonArray>
 
 class VFile;
 
@@ -23,6 +24,11 @@ public:
     // Use p_id to identify the result.
     void highlightTextAsync(const QString &p_text, int p_id, int p_timeStamp);
 
+    // Request to highlight a batch of segment texts in one message.
+    // @p_texts: array of objects with "id" and "text".
+    // Results will be sent back in one textsHighlighted() signal.
+    void highlightTextsAsync(const QJsonArray &p_texts, int p_timeStamp);
+
     void setFile(const VFile *p_file);
 
 public slots:
@@ -41,6 +47,9 @@ public slots:
     void keyPressEvent(int p_key, bool p_ctrl, bool p_shift);
     void updateText();
     void highlightTextCB(const QString &p_html, int p_id, int p_timeStamp);
+
+    // @p_results: array of objects with "id" and "html".
+    void highlightTextsCB(const QJsonArray &p_results, int p_timeStamp);
     void noticeReadyToHighlightText();
 
     // Web-side handle logics (MathJax etc.) is finished.
@@ -57,6 +66,8 @@ signals:
     void keyPressed(int p_key, bool p_ctrl, bool p_shift);
     void requestHighlightText(const QString &p_text, int p_id, int p_timeStamp);
     void textHighlighted(const QString &p_html, int p_id, int p_timeStamp);
+    void requestHighlightTexts(const QJsonArray &p_texts, int p_timeStamp);
+    void textsHighlighted(const QJsonArray &p_results, int p_timeStamp);
     void readyToHighlightText();
     void logicsFinished();
 
@@ -1,6 +1,7 @@
 #include <QtWidgets>
 #include <QVector>
 #include <QDebug>
+#include <algorithm>
 #include "vedit.h"
 #include "vnote.h"
 #include "vconfigmanager.h"
@@ -13,6 +14,9 @@
 extern VConfigManager *g_config;
 extern VNote *g_vnote;
 
+// Max number of compiled matchers kept by VEdit.
+static const int c_maxTextMatchers = 8;
+
 void VEditConfig::init(const QFontMetrics &p_metric)
 {
     update(p_metric);
@@ -43,10 +47,17 @@ void VEditConfig::update(const QFontMetrics &p_metric)
 
 VEdit::VEdit(VFile *p_file, QWidget *p_parent)
     : QTextEdit(p_parent), m_file(p_file),
-      m_editOps(NULL), m_enableInputMethod(true)
+      m_editOps(NULL), m_highlightFirstBlock(-1), m_highlightLastBlock(-1),
+      m_trailingSpacesValid(false), m_countSearchId(0), m_countRevision(-1),
+      m_matchesOptions(0), m_matchesRevision(-1), m_matchPosition(-1),
+      m_blockGeometriesToEnd(false), m_tokenIndexRevision(-1),
+      m_tokenIndexFirstBlock(-1), m_tokenIndexLastBlock(-1),
+      m_enableInputMethod(true)
 {
     const int labelTimerInterval = 500;
     const int extraSelectionHighlightTimer = 500;
+    const int viewportHighlightTimer = 50;
+    const int selectedWordTimer = 150;
     const int labelSize = 64;
 
     m_selectedWordColor = QColor(g_config->getEditorSelectedWordBg());
@@ -75,6 +86,24 @@ VEdit::VEdit(VFile *p_file, QWidget *p_parent)
             (VFile *)m_file, &VFile::setModified);
 
     m_extraSelections.resize((int)SelectionId::MaxSelection);
+    m_textHighlights.resize((int)SelectionId::MaxSelection);
+
+    m_viewportHighlightTimer = new QTimer(this);
+    m_viewportHighlightTimer->setSingleShot(true);
+    m_viewportHighlightTimer->setInterval(viewportHighlightTimer);
+    connect(m_viewportHighlightTimer, &QTimer::timeout,
+            this, &VEdit::updateViewportHighlight);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged,
+            this, [this]() {
+                m_viewportHighlightTimer->start();
+            });
+
+    connect(document(), &QTextDocument::contentsChange,
+            this, &VEdit::updateTrailingSpaces);
+
+    m_textSearcher = new VTextSearcher(this);
+    connect(m_textSearcher, &VTextSearcher::finished,
+            this, &VEdit::handleMatchesCounted);
 
     updateFontAndPalette();
 
@@ -84,10 +113,28 @@ VEdit::VEdit(VFile *p_file, QWidget *p_parent)
     connect(this, &VEdit::cursorPositionChanged,
             this, &VEdit::handleCursorPositionChanged);
 
-    connect(this, &VEdit::selectionChanged,
+    m_selectedWordTimer = new QTimer(this);
+    m_selectedWordTimer->setSingleShot(true);
+    m_selectedWordTimer->setInterval(selectedWordTimer);
+    connect(m_selectedWordTimer, &QTimer::timeout,
             this, &VEdit::highlightSelectedWord);
 
+    connect(this, &VEdit::selectionChanged,
+            this, &VEdit::handleSelectionChanged);
+
     m_lineNumberArea = new LineNumberArea(this);
+    connect(document(), &QTextDocument::contentsChange,
+            this, [this]() {
+                m_blockGeometries.clear();
+            });
+    connect(document()->documentLayout(), &QAbstractTextDocumentLayout::documentSizeChanged,
+            this, [this]() {
+                m_blockGeometries.clear();
+            });
+    connect(document()->documentLayout(), &QAbstractTextDocumentLayout::updateBlock,
+            this, [this]() {
+                m_blockGeometries.clear();
+            });
     connect(document(), &QTextDocument::blockCountChanged,
             this, &VEdit::updateLineNumberAreaMargin);
     connect(this, &QTextEdit::textChanged,
@@ -125,6 +172,8 @@ void VEdit::beginEdit()
 
     setReadOnly(false);
     setModified(false);
+
+    m_file->releaseContent();
 }
 
 void VEdit::endEdit()
@@ -183,6 +232,7 @@ bool VEdit::peekText(const QString &p_text, uint p_options, bool p_forward)
     if (p_text.isEmpty()) {
         makeBlockVisible(document()->findBlock(textCursor().selectionStart()));
         highlightIncrementalSearchedWord(QTextCursor());
+        cancelCountMatches(-1);
         return false;
     }
 
@@ -195,135 +245,127 @@ bool VEdit::peekText(const QString &p_text, uint p_options, bool p_forward)
     if (found) {
         makeBlockVisible(document()->findBlock(retCursor.selectionStart()));
         highlightIncrementalSearchedWord(retCursor);
+        countMatches(p_text, p_options, retCursor.selectionStart());
+    } else {
+        cancelCountMatches(0);
     }
 
     return found;
 }
 
-// Use QTextEdit::find() instead of QTextDocument::find() because the later has
-// bugs in searching backward.
 bool VEdit::findTextHelper(const QString &p_text, uint p_options,
                            bool p_forward, int p_start,
                            bool &p_wrapped, QTextCursor &p_cursor)
 {
-    p_wrapped = false;
-    bool found = false;
-
-    // Options
-    QTextDocument::FindFlags findFlags;
-    bool caseSensitive = false;
-    if (p_options & FindOption::CaseSensitive) {
-        findFlags |= QTextDocument::FindCaseSensitively;
-        caseSensitive = true;
-    }
-
-    if (p_options & FindOption::WholeWordOnly) {
-        findFlags |= QTextDocument::FindWholeWords;
+    VTextMatch match;
+    if (!findMatch(p_text, p_options, p_forward, p_start, p_wrapped, match)) {
+        return false;
     }
 
-    if (!p_forward) {
-        findFlags |= QTextDocument::FindBackward;
-    }
+    p_cursor = QTextCursor(document());
+    p_cursor.setPosition(match.m_start);
+    p_cursor.setPosition(match.m_start + match.m_length, QTextCursor::KeepAnchor);
+    return true;
+}
 
-    // Use regular expression
-    bool useRegExp = false;
-    QRegExp exp;
-    if (p_options & FindOption::RegularExpression) {
-        useRegExp = true;
-        exp = QRegExp(p_text,
-                      caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-    }
+bool VEdit::findMatch(const QString &p_text, uint p_options, bool p_forward,
+                      int p_start, bool &p_wrapped, VTextMatch &p_match)
+{
+    p_wrapped = false;
 
-    // Store current state of the cursor.
-    QTextCursor cursor = textCursor();
-    if (cursor.position() != p_start) {
-        if (p_start < 0) {
-            p_start = 0;
-        } else if (p_start > document()->characterCount()) {
-            p_start = document()->characterCount();
+    QTextDocument *doc = document();
+    uint options = p_options & ~FindOption::IncrementalSearch;
+    if (m_matchesRevision == doc->revision()
+        && m_matchesText == p_text
+        && m_matchesOptions == options) {
+        if (m_matches.isEmpty()) {
+            return false;
         }
 
-        QTextCursor startCursor = cursor;
-        startCursor.setPosition(p_start);
-        setTextCursor(startCursor);
-    }
-
-    while (!found) {
-        if (useRegExp) {
-            found = find(exp, findFlags);
+        auto it = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), p_start,
+                                   [](const VTextMatch &p_match, int p_pos) {
+                                       return p_match.m_start < p_pos;
+                                   });
+        if (p_forward) {
+            if (it == m_matches.constEnd()) {
+                p_wrapped = true;
+                it = m_matches.constBegin();
+            }
         } else {
-            found = find(p_text, findFlags);
-        }
-
-        if (p_wrapped) {
-            break;
-        }
-
-        if (!found) {
-            // Wrap to the other end of the document to search again.
-            p_wrapped = true;
-            QTextCursor wrapCursor = textCursor();
-            if (p_forward) {
-                wrapCursor.movePosition(QTextCursor::Start, QTextCursor::MoveAnchor);
-            } else {
-                wrapCursor.movePosition(QTextCursor::End, QTextCursor::MoveAnchor);
+            if (it == m_matches.constBegin()) {
+                p_wrapped = true;
+                it = m_matches.constEnd();
             }
 
-            setTextCursor(wrapCursor);
+            --it;
         }
+
+        p_match = *it;
+        return true;
     }
 
-    if (found) {
-        p_cursor = textCursor();
+    VTextMatcher matcher = textMatcher(p_text, options);
+    if (!matcher.isValid()) {
+        return false;
     }
 
-    // Restore the original cursor.
-    setTextCursor(cursor);
+    // Matches are not counted yet, so search block by block from @p_start
+    // and stop at the first hit.
+    QTextBlock startBlock = doc->findBlock(qBound(0, p_start, doc->characterCount() - 1));
+    QVector<VTextMatch> matches;
+    if (p_forward) {
+        for (QTextBlock block = startBlock; block.isValid(); block = block.next()) {
+            matches.clear();
+            matcher.match(block.text(), block.position(), matches);
+            for (auto const &match : matches) {
+                if (match.m_start >= p_start) {
+                    p_match = match;
+                    return true;
+                }
+            }
+        }
 
-    return found;
-}
+        p_wrapped = true;
+        for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+            matches.clear();
+            matcher.match(block.text(), block.position(), matches);
+            if (!matches.isEmpty()) {
+                p_match = matches.first();
+                return true;
+            }
 
-QList<QTextCursor> VEdit::findTextAll(const QString &p_text, uint p_options)
-{
-    QList<QTextCursor> results;
-    if (p_text.isEmpty()) {
-        return results;
-    }
-    // Options
-    QTextDocument::FindFlags findFlags;
-    bool caseSensitive = false;
-    if (p_options & FindOption::CaseSensitive) {
-        findFlags |= QTextDocument::FindCaseSensitively;
-        caseSensitive = true;
-    }
-    if (p_options & FindOption::WholeWordOnly) {
-        findFlags |= QTextDocument::FindWholeWords;
-    }
-    // Use regular expression
-    bool useRegExp = false;
-    QRegExp exp;
-    if (p_options & FindOption::RegularExpression) {
-        useRegExp = true;
-        exp = QRegExp(p_text,
-                      caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-    }
-    int startPos = 0;
-    QTextCursor cursor;
-    QTextDocument *doc = document();
-    while (true) {
-        if (useRegExp) {
-            cursor = doc->find(exp, startPos, findFlags);
-        } else {
-            cursor = doc->find(p_text, startPos, findFlags);
+            if (block == startBlock) {
+                break;
+            }
         }
-        if (cursor.isNull()) {
-            break;
-        } else {
-            results.append(cursor);
-            startPos = cursor.selectionEnd();
+    } else {
+        for (QTextBlock block = startBlock; block.isValid(); block = block.previous()) {
+            matches.clear();
+            matcher.match(block.text(), block.position(), matches);
+            for (int i = matches.size() - 1; i >= 0; --i) {
+                if (matches[i].m_start < p_start) {
+                    p_match = matches[i];
+                    return true;
+                }
+            }
+        }
+
+        p_wrapped = true;
+        for (QTextBlock block = doc->lastBlock(); block.isValid(); block = block.previous()) {
+            matches.clear();
+            matcher.match(block.text(), block.position(), matches);
+            if (!matches.isEmpty()) {
+                p_match = matches.last();
+                return true;
+            }
+
+            if (block == startBlock) {
+                break;
+            }
         }
     }
-    return results;
+
+    return false;
 }
 
 bool VEdit::findText(const QString &p_text, uint p_options, bool p_forward,
@@ -333,13 +375,13 @@ bool VEdit::findText(const QString &p_text, uint p_options, bool p_forward,
 
     if (p_text.isEmpty()) {
         clearSearchedWordHighlight();
+        cancelCountMatches(-1);
         return false;
     }
 
     QTextCursor cursor = textCursor();
     bool wrapped = false;
     QTextCursor retCursor;
-    int matches = 0;
     int start = p_forward ? cursor.position() + 1 : cursor.position();
     if (p_cursor) {
         start = p_forward ? p_cursor->position() + 1 : p_cursor->position();
@@ -349,32 +391,128 @@ bool VEdit::findText(const QString &p_text, uint p_options, bool p_forward,
                                 wrapped, retCursor);
     if (found) {
         Q_ASSERT(!retCursor.isNull());
-        if (wrapped) {
-            showWrapLabel();
-        }
-
-        if (p_cursor) {
-            p_cursor->setPosition(retCursor.selectionStart(), p_moveMode);
-        } else {
-            cursor.setPosition(retCursor.selectionStart(), p_moveMode);
-            setTextCursor(cursor);
-        }
-
-        highlightSearchedWord(p_text, p_options);
-        highlightSearchedWordUnderCursor(retCursor);
-        matches = m_extraSelections[(int)SelectionId::SearchedKeyword].size();
+        jumpToMatch(p_text, p_options, retCursor.selectionStart(),
+                    retCursor.selectionEnd(), wrapped, p_cursor, p_moveMode);
     } else {
         clearSearchedWordHighlight();
+        cancelCountMatches(0);
+        statusMessage(tr("Found no match"));
     }
 
-    if (matches == 0) {
-        statusMessage(tr("Found no match"));
+    return found;
+}
+
+void VEdit::jumpToMatch(const QString &p_text, uint p_options,
+                        int p_start, int p_end, bool p_wrapped,
+                        QTextCursor *p_cursor, QTextCursor::MoveMode p_moveMode)
+{
+    clearIncrementalSearchedWordHighlight();
+
+    if (p_wrapped) {
+        showWrapLabel();
+    }
+
+    if (p_cursor) {
+        p_cursor->setPosition(p_start, p_moveMode);
     } else {
-        statusMessage(tr("Found %1 %2").arg(matches)
-                                       .arg(matches > 1 ? tr("matches") : tr("match")));
+        QTextCursor cursor = textCursor();
+        cursor.setPosition(p_start, p_moveMode);
+        setTextCursor(cursor);
     }
 
-    return found;
+    QTextCursor matchCursor(document());
+    matchCursor.setPosition(p_start);
+    matchCursor.setPosition(p_end, QTextCursor::KeepAnchor);
+
+    highlightSearchedWord(p_text, p_options);
+    highlightSearchedWordUnderCursor(matchCursor);
+
+    // Only the viewport is highlighted, so count the matches in background.
+    countMatches(p_text, p_options, p_start);
+}
+
+VTextMatcher VEdit::textMatcher(const QString &p_text, uint p_options)
+{
+    uint options = p_options & ~FindOption::IncrementalSearch;
+    QString key = QString::number(options) + ":" + p_text;
+    auto it = m_textMatchers.constFind(key);
+    if (it != m_textMatchers.constEnd()) {
+        return it.value();
+    }
+
+    if (m_textMatchers.size() >= c_maxTextMatchers) {
+        m_textMatchers.clear();
+    }
+
+    VTextMatcher matcher(p_text, options);
+    m_textMatchers.insert(key, matcher);
+    return matcher;
+}
+
+void VEdit::countMatches(const QString &p_text, uint p_options, int p_position)
+{
+    m_matchPosition = p_position;
+
+    // Incremental search does not affect the matches.
+    uint options = p_options & ~FindOption::IncrementalSearch;
+    int revision = document()->revision();
+    if (m_matchesRevision == revision
+        && m_matchesText == p_text
+        && m_matchesOptions == options) {
+        reportMatchIndex();
+        return;
+    }
+
+    m_matches.clear();
+    m_matchesRevision = -1;
+    m_matchesText = p_text;
+    m_matchesOptions = options;
+    m_countRevision = revision;
+    m_countSearchId = m_textSearcher->start(document()->toPlainText(),
+                                            textMatcher(p_text, options));
+}
+
+void VEdit::cancelCountMatches(int p_count)
+{
+    m_textSearcher->cancel();
+    m_countSearchId = 0;
+
+    emit matchCountUpdated(0, p_count);
+}
+
+void VEdit::handleMatchesCounted(int p_id, const QVector<VTextMatch> &p_matches)
+{
+    if (p_id != m_countSearchId) {
+        return;
+    }
+
+    m_countSearchId = 0;
+    m_matches = p_matches;
+    m_matchesRevision = m_countRevision;
+
+    reportMatchIndex();
+}
+
+void VEdit::reportMatchIndex()
+{
+    int count = m_matches.size();
+    auto it = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), m_matchPosition,
+                               [](const VTextMatch &p_match, int p_pos) {
+                                   return p_match.m_start < p_pos;
+                               });
+    int current = 0;
+    if (it != m_matches.constEnd() && it->m_start == m_matchPosition) {
+        current = it - m_matches.constBegin() + 1;
+    }
+
+    emit matchCountUpdated(current, count);
+
+    if (current > 0) {
+        emit statusMessage(tr("Match %1 of %2").arg(current).arg(count));
+    } else {
+        emit statusMessage(tr("Found %1 %2").arg(count)
+                                            .arg(count > 1 ? tr("matches") : tr("match")));
+    }
 }
 
 void VEdit::replaceText(const QString &p_text, uint p_options,
@@ -403,36 +541,38 @@ void VEdit::replaceText(const QString &p_text, uint p_options,
 void VEdit::replaceTextAll(const QString &p_text, uint p_options,
                            const QString &p_replaceText)
 {
-    // Replace from the start to the end and restore the cursor.
-    QTextCursor cursor = textCursor();
-    int nrReplaces = 0;
-    QTextCursor tmpCursor = cursor;
-    tmpCursor.setPosition(0);
-    setTextCursor(tmpCursor);
-    int start = tmpCursor.position();
-    while (true) {
-        bool wrapped = false;
-        QTextCursor retCursor;
-        bool found = findTextHelper(p_text, p_options, true,
-                                    start, wrapped, retCursor);
-        if (!found) {
-            break;
-        } else {
-            if (wrapped) {
-                // Wrap back.
-                break;
-            }
+    VTextMatcher matcher = textMatcher(p_text, p_options);
+    if (!matcher.isValid()) {
+        return;
+    }
 
-            nrReplaces++;
-            retCursor.beginEditBlock();
-            retCursor.insertText(p_replaceText);
-            retCursor.endEditBlock();
-            setTextCursor(retCursor);
-            start = retCursor.position();
+    // Find all the matches first so the replacements will not be matched again.
+    QVector<VTextMatch> matches;
+    QTextDocument *doc = document();
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        matcher.match(block.text(), block.position(), matches);
+    }
+
+    // Replace from the end in one edit block, so the positions of the
+    // remaining matches are not changed and the document emits the change
+    // signals only once. The highlighter and the image previewer will be
+    // triggered once after all the replacements.
+    int nrReplaces = matches.size();
+    if (nrReplaces > 0) {
+        QTextCursor cursor(doc);
+        cursor.beginEditBlock();
+        for (int i = nrReplaces - 1; i >= 0; --i) {
+            const VTextMatch &match = matches[i];
+            cursor.setPosition(match.m_start);
+            cursor.setPosition(match.m_start + match.m_length, QTextCursor::KeepAnchor);
+            cursor.insertText(p_replaceText);
         }
+
+        cursor.endEditBlock();
     }
 
-    // Restore cursor position.
+    // Current cursor has been adjusted by the document.
+    QTextCursor cursor = textCursor();
     cursor.clearSelection();
     setTextCursor(cursor);
     qDebug() << "replace all" << nrReplaces << "occurences";
@@ -542,67 +682,175 @@ void VEdit::setReadOnly(bool p_ro)
     highlightCurrentLine();
 }
 
+void VEdit::handleSelectionChanged()
+{
+    // Clearing is cheap and should not lag behind.
+    if (!textCursor().hasSelection()) {
+        m_selectedWordTimer->stop();
+        highlightSelectedWord();
+        return;
+    }
+
+    m_selectedWordTimer->start();
+}
+
+// Whether @p_text is a word which consists of letters and numbers.
+static bool isToken(const QString &p_text)
+{
+    if (p_text.isEmpty()) {
+        return false;
+    }
+
+    for (int i = 0; i < p_text.size(); ++i) {
+        if (!p_text[i].isLetterOrNumber()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void VEdit::highlightSelectedWord()
 {
-    QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)SelectionId::SelectedWord];
     if (!g_config->getHighlightSelectedWord()) {
-        if (!selects.isEmpty()) {
-            selects.clear();
+        if (clearTextHighlight(SelectionId::SelectedWord)) {
             highlightExtraSelections(true);
         }
 
         return;
     }
 
-    QString text = textCursor().selectedText().trimmed();
+    QTextCursor cursor = textCursor();
+    QString selectedText = cursor.selectedText();
+    QString text = selectedText.trimmed();
     if (text.isEmpty() || wordInSearchedSelection(text)) {
-        selects.clear();
+        clearTextHighlight(SelectionId::SelectedWord);
         highlightExtraSelections(true);
         return;
     }
 
+    // If a whole word is selected, highlight only the whole words which can
+    // be looked up in the token index.
+    uint options = FindOption::CaseSensitive;
+    QTextDocument *doc = document();
+    if (text == selectedText
+        && isToken(text)
+        && !doc->characterAt(cursor.selectionStart() - 1).isLetterOrNumber()
+        && !doc->characterAt(cursor.selectionEnd()).isLetterOrNumber()) {
+        options |= FindOption::WholeWordOnly;
+    }
+
     QTextCharFormat format;
     format.setBackground(m_selectedWordColor);
-    highlightTextAll(text, FindOption::CaseSensitive, SelectionId::SelectedWord,
-                     format);
+    highlightTextAll(text, options, SelectionId::SelectedWord, format);
 }
 
-// Do not highlight trailing spaces with current cursor right behind.
-static void trailingSpaceFilter(VEdit *p_editor, QList<QTextEdit::ExtraSelection> &p_result)
+void VEdit::highlightTrailingSpace()
 {
-    QTextCursor cursor = p_editor->textCursor();
-    if (!cursor.atBlockEnd()) {
+    QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)SelectionId::TrailingSapce];
+    if (!g_config->getEnableTrailingSpaceHighlight()) {
+        m_trailingSpaces.clear();
+        m_trailingSpacesValid = false;
+        if (!selects.isEmpty()) {
+            selects.clear();
+            highlightExtraSelections(true);
+        }
         return;
     }
 
-    int cursorPos = cursor.position();
-    for (auto it = p_result.begin(); it != p_result.end(); ++it) {
-        if (it->cursor.selectionEnd() == cursorPos) {
-            p_result.erase(it);
+    if (!m_trailingSpacesValid) {
+        if (m_highlightFirstBlock == -1) {
+            updateHighlightRange();
+        }
 
-            // There will be only one.
-            return;
+        findTrailingSpacesInRange();
+    }
+
+    // Do not highlight trailing spaces with current cursor right behind.
+    QTextCursor cursor = textCursor();
+    int cursorPos = cursor.atBlockEnd() ? cursor.position() : -1;
+
+    selects.clear();
+    QTextEdit::ExtraSelection select;
+    select.format.setBackground(m_trailingSpaceColor);
+    for (auto const &space : m_trailingSpaces) {
+        if (space.hasSelection() && space.selectionEnd() != cursorPos) {
+            select.cursor = space;
+            selects.append(select);
         }
     }
+
+    highlightExtraSelections();
 }
 
-void VEdit::highlightTrailingSpace()
+void VEdit::findTrailingSpace(const QTextBlock &p_block)
 {
-    if (!g_config->getEnableTrailingSpaceHighlight()) {
-        QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)SelectionId::TrailingSapce];
-        if (!selects.isEmpty()) {
-            selects.clear();
-            highlightExtraSelections(true);
-        }
+    QString text = p_block.text();
+    int idx = text.size();
+    while (idx > 0 && text[idx - 1].isSpace()) {
+        --idx;
+    }
+
+    if (idx < text.size()) {
+        QTextCursor cursor(p_block);
+        cursor.setPosition(p_block.position() + idx);
+        cursor.setPosition(p_block.position() + text.size(), QTextCursor::KeepAnchor);
+        m_trailingSpaces.append(cursor);
+    }
+}
+
+void VEdit::findTrailingSpacesInRange()
+{
+    m_trailingSpaces.clear();
+
+    QTextBlock block = document()->findBlockByNumber(m_highlightFirstBlock);
+    for (int i = m_highlightFirstBlock; block.isValid() && i <= m_highlightLastBlock; ++i) {
+        findTrailingSpace(block);
+        block = block.next();
+    }
+
+    m_trailingSpacesValid = true;
+}
+
+void VEdit::updateTrailingSpaces(int p_position, int p_charsRemoved, int p_charsAdded)
+{
+    Q_UNUSED(p_charsRemoved);
+
+    if (!m_trailingSpacesValid) {
         return;
     }
 
-    QTextCharFormat format;
-    format.setBackground(m_trailingSpaceColor);
-    QString text("\\s+$");
-    highlightTextAll(text, FindOption::RegularExpression,
-                     SelectionId::TrailingSapce, format,
-                     trailingSpaceFilter);
+    QTextDocument *doc = document();
+    QTextBlock first = doc->findBlock(p_position);
+    QTextBlock last = doc->findBlock(p_position + p_charsAdded);
+    if (!first.isValid()) {
+        first = doc->lastBlock();
+    }
+
+    if (!last.isValid()) {
+        last = doc->lastBlock();
+    }
+
+    // The cursors of untouched blocks have been adjusted by the document.
+    int start = first.position();
+    int end = last.position() + last.length();
+    for (int i = m_trailingSpaces.size() - 1; i >= 0; --i) {
+        const QTextCursor &space = m_trailingSpaces[i];
+        if (!space.hasSelection()
+            || (space.selectionEnd() >= start && space.selectionStart() < end)) {
+            m_trailingSpaces.remove(i);
+        }
+    }
+
+    int firstNumber = qMax(first.blockNumber(), m_highlightFirstBlock);
+    int lastNumber = qMin(last.blockNumber(), m_highlightLastBlock);
+    QTextBlock block = doc->findBlockByNumber(firstNumber);
+    for (int i = firstNumber; block.isValid() && i <= lastNumber; ++i) {
+        findTrailingSpace(block);
+        block = block.next();
+    }
+
+    highlightTrailingSpace();
 }
 
 bool VEdit::wordInSearchedSelection(const QString &p_text)
@@ -622,37 +870,173 @@ void VEdit::highlightTextAll(const QString &p_text, uint p_options,
                              SelectionId p_id, QTextCharFormat p_format,
                              void (*p_filter)(VEdit *, QList<QTextEdit::ExtraSelection> &))
 {
+    if (p_text.isEmpty()) {
+        if (!clearTextHighlight(p_id)) {
+            return;
+        }
+    } else {
+        TextHighlight &hl = m_textHighlights[(int)p_id];
+        hl.m_text = p_text;
+        hl.m_options = p_options;
+        hl.m_format = p_format;
+        hl.m_filter = p_filter;
+
+        if (updateHighlightRange()) {
+            highlightAllInRange();
+        } else {
+            highlightTextInRange(p_id);
+        }
+    }
+
+    highlightExtraSelections();
+}
+
+bool VEdit::clearTextHighlight(SelectionId p_id)
+{
+    m_textHighlights[(int)p_id].m_text.clear();
+
     QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)p_id];
-    if (!p_text.isEmpty()) {
-        selects.clear();
+    if (selects.isEmpty()) {
+        return false;
+    }
 
-        QList<QTextCursor> occurs = findTextAll(p_text, p_options);
-        for (int i = 0; i < occurs.size(); ++i) {
-            QTextEdit::ExtraSelection select;
-            select.format = p_format;
-            select.cursor = occurs[i];
-            selects.append(select);
+    selects.clear();
+    return true;
+}
+
+void VEdit::visibleBlockRange(int &p_first, int &p_last)
+{
+    p_first = qMax(0, firstVisibleBlock().blockNumber());
+    p_last = qMax(p_first, cursorForPosition(QPoint(0, viewport()->height() - 1)).blockNumber());
+}
+
+bool VEdit::updateHighlightRange()
+{
+    int first, last;
+    visibleBlockRange(first, last);
+    if (m_highlightFirstBlock != -1
+        && first >= m_highlightFirstBlock
+        && last <= m_highlightLastBlock) {
+        return false;
+    }
+
+    int page = last - first + 1;
+    m_highlightFirstBlock = qMax(0, first - page);
+    m_highlightLastBlock = last + page;
+    m_trailingSpacesValid = false;
+    return true;
+}
+
+void VEdit::highlightTextInRange(SelectionId p_id)
+{
+    const TextHighlight &hl = m_textHighlights[(int)p_id];
+    QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)p_id];
+    selects.clear();
+
+    VTextMatcher matcher = textMatcher(hl.m_text, hl.m_options);
+    if (!matcher.isValid()) {
+        return;
+    }
+
+    QVector<VTextMatch> matches;
+    if ((hl.m_options & FindOption::WholeWordOnly)
+        && (hl.m_options & FindOption::CaseSensitive)
+        && !(hl.m_options & FindOption::RegularExpression)
+        && isToken(hl.m_text)) {
+        // Occurences of a whole word are looked up in the token index.
+        updateTokenIndex();
+        const QVector<int> positions = m_tokenIndex.value(hl.m_text);
+        matches.reserve(positions.size());
+        for (auto pos : positions) {
+            matches.append(VTextMatch(pos, hl.m_text.size()));
         }
     } else {
-        if (selects.isEmpty()) {
-            return;
+        QTextBlock block = document()->findBlockByNumber(m_highlightFirstBlock);
+        for (int i = m_highlightFirstBlock; block.isValid() && i <= m_highlightLastBlock; ++i) {
+            matcher.match(block.text(), block.position(), matches);
+            block = block.next();
         }
-        selects.clear();
     }
 
-    if (p_filter) {
-        p_filter(this, selects);
+    QTextCursor cursor(document());
+    for (auto const &match : matches) {
+        cursor.setPosition(match.m_start);
+        cursor.setPosition(match.m_start + match.m_length, QTextCursor::KeepAnchor);
+
+        QTextEdit::ExtraSelection select;
+        select.format = hl.m_format;
+        select.cursor = cursor;
+        selects.append(select);
     }
 
-    highlightExtraSelections();
+    if (hl.m_filter) {
+        hl.m_filter(this, selects);
+    }
+}
+
+void VEdit::updateTokenIndex()
+{
+    int revision = document()->revision();
+    if (m_tokenIndexRevision == revision
+        && m_tokenIndexFirstBlock == m_highlightFirstBlock
+        && m_tokenIndexLastBlock == m_highlightLastBlock) {
+        return;
+    }
+
+    m_tokenIndex.clear();
+
+    QTextBlock block = document()->findBlockByNumber(m_highlightFirstBlock);
+    for (int i = m_highlightFirstBlock; block.isValid() && i <= m_highlightLastBlock; ++i) {
+        QString text = block.text();
+        int pos = block.position();
+        int idx = 0;
+        while (idx < text.size()) {
+            if (!text[idx].isLetterOrNumber()) {
+                ++idx;
+                continue;
+            }
+
+            int start = idx;
+            while (idx < text.size() && text[idx].isLetterOrNumber()) {
+                ++idx;
+            }
+
+            m_tokenIndex[text.mid(start, idx - start)].append(pos + start);
+        }
+
+        block = block.next();
+    }
+
+    m_tokenIndexRevision = revision;
+    m_tokenIndexFirstBlock = m_highlightFirstBlock;
+    m_tokenIndexLastBlock = m_highlightLastBlock;
+}
+
+void VEdit::updateViewportHighlight()
+{
+    if (updateHighlightRange()) {
+        highlightAllInRange();
+        highlightExtraSelections(true);
+    }
+}
+
+void VEdit::highlightAllInRange()
+{
+    for (int i = 0; i < m_textHighlights.size(); ++i) {
+        if (!m_textHighlights[i].m_text.isEmpty()) {
+            highlightTextInRange((SelectionId)i);
+        }
+    }
+
+    if (g_config->getEnableTrailingSpaceHighlight()) {
+        highlightTrailingSpace();
+    }
 }
 
 void VEdit::highlightSearchedWord(const QString &p_text, uint p_options)
 {
-    QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)SelectionId::SearchedKeyword];
     if (!g_config->getHighlightSearchedWord() || p_text.isEmpty()) {
-        if (!selects.isEmpty()) {
-            selects.clear();
+        if (clearTextHighlight(SelectionId::SearchedKeyword)) {
             highlightExtraSelections(true);
         }
 
@@ -711,12 +1095,10 @@ void VEdit::clearSearchedWordHighlight()
     clearIncrementalSearchedWordHighlight(false);
     clearSearchedWordUnderCursorHighlight(false);
 
-    QList<QTextEdit::ExtraSelection> &selects = m_extraSelections[(int)SelectionId::SearchedKeyword];
-    if (selects.isEmpty()) {
+    if (!clearTextHighlight(SelectionId::SearchedKeyword)) {
         return;
     }
 
-    selects.clear();
     highlightExtraSelections(true);
 }
 
@@ -988,6 +1370,9 @@ void VEdit::resizeEvent(QResizeEvent *p_event)
 {
     QTextEdit::resizeEvent(p_event);
 
+    m_viewportHighlightTimer->start();
+    m_blockGeometries.clear();
+
     if (g_config->getEditorLineNumber()) {
         QRect rect = contentsRect();
         m_lineNumberArea->setGeometry(QRect(rect.left(),
@@ -1008,66 +1393,91 @@ void VEdit::lineNumberAreaPaintEvent(QPaintEvent *p_event)
     QPainter painter(m_lineNumberArea);
     painter.fillRect(p_event->rect(), g_config->getEditorLineNumberBg());
 
-    QTextDocument *doc = document();
-    QAbstractTextDocumentLayout *layout = doc->documentLayout();
-
-    QTextBlock block = firstVisibleBlock();
-    int blockNumber = block.blockNumber();
     int offsetY = contentOffsetY();
-    QRectF rect = layout->blockBoundingRect(block);
-    int top = offsetY + (int)rect.y();
-    int bottom = top + (int)rect.height();
     int eventTop = p_event->rect().top();
     int eventBtm = p_event->rect().bottom();
-    const int digitHeight = m_lineNumberArea->getDigitHeight();
+    if (!blockGeometriesCover(eventTop - offsetY, eventBtm - offsetY)) {
+        updateBlockGeometries(eventTop - offsetY, eventBtm - offsetY);
+    }
+
     const int curBlockNumber = textCursor().block().blockNumber();
     const bool relative = g_config->getEditorLineNumber() == 2;
-    const QString &fg = g_config->getEditorLineNumberFg();
-    painter.setPen(fg);
-
-    while (block.isValid() && top <= eventBtm) {
-        if (block.isVisible() && bottom >= eventTop) {
-            bool currentLine = false;
-            int number = blockNumber + 1;
-            if (relative) {
-                number = blockNumber - curBlockNumber;
-                if (number == 0) {
-                    currentLine = true;
-                    number = blockNumber + 1;
-                } else if (number < 0) {
-                    number = -number;
-                }
-            } else if (blockNumber == curBlockNumber) {
+    const int width = m_lineNumberArea->width();
+    m_lineNumberArea->prepareDigits(QColor(g_config->getEditorLineNumberFg()));
+
+    for (auto const &geo : m_blockGeometries) {
+        int top = offsetY + geo.m_top;
+        if (top > eventBtm) {
+            break;
+        }
+
+        if (!geo.m_visible || top + geo.m_height < eventTop) {
+            continue;
+        }
+
+        bool currentLine = false;
+        int number = geo.m_number + 1;
+        if (relative) {
+            number = geo.m_number - curBlockNumber;
+            if (number == 0) {
                 currentLine = true;
+                number = geo.m_number + 1;
+            } else if (number < 0) {
+                number = -number;
             }
+        } else if (geo.m_number == curBlockNumber) {
+            currentLine = true;
+        }
 
-            QString numberStr = QString::number(number);
+        m_lineNumberArea->drawNumber(painter, width, top + 2, number, currentLine);
+    }
+}
 
-            if (currentLine) {
-                QFont font = painter.font();
-                font.setBold(true);
-                painter.setFont(font);
-            }
+bool VEdit::blockGeometriesCover(int p_top, int p_bottom) const
+{
+    if (m_blockGeometries.isEmpty()) {
+        return false;
+    }
 
-            painter.drawText(0,
-                             top + 2,
-                             m_lineNumberArea->width(),
-                             digitHeight,
-                             Qt::AlignRight,
-                             numberStr);
-
-            if (currentLine) {
-                QFont font = painter.font();
-                font.setBold(false);
-                painter.setFont(font);
-            }
+    const BlockGeometry &first = m_blockGeometries.first();
+    const BlockGeometry &last = m_blockGeometries.last();
+    return (first.m_number == 0 || first.m_top <= p_top)
+           && (m_blockGeometriesToEnd || last.m_top + last.m_height > p_bottom);
+}
+
+void VEdit::updateBlockGeometries(int p_top, int p_bottom)
+{
+    m_blockGeometries.clear();
+
+    QAbstractTextDocumentLayout *layout = document()->documentLayout();
+    int page = viewport()->height();
+
+    // Step back one page.
+    QTextBlock block = firstVisibleBlock();
+    while (block.previous().isValid()
+           && layout->blockBoundingRect(block).y() > p_top - page) {
+        block = block.previous();
+    }
+
+    int number = block.blockNumber();
+    while (block.isValid()) {
+        QRectF rect = layout->blockBoundingRect(block);
+        BlockGeometry geo;
+        geo.m_number = number;
+        geo.m_top = (int)rect.y();
+        geo.m_height = (int)rect.height();
+        geo.m_visible = block.isVisible();
+        m_blockGeometries.append(geo);
+
+        if (geo.m_top > p_bottom + page) {
+            break;
         }
 
         block = block.next();
-        top = bottom;
-        bottom = top + (int)layout->blockBoundingRect(block).height();
-        ++blockNumber;
+        ++number;
     }
+
+    m_blockGeometriesToEnd = !block.isValid();
 }
 
 int VEdit::contentOffsetY()
@@ -1128,6 +1538,65 @@ QTextBlock VEdit::firstVisibleBlock()
     return doc->begin();
 }
 
+void LineNumberArea::renderDigits(DigitStrip &p_strip, const QFont &p_font)
+{
+    QFontMetrics metrics(p_font);
+    p_strip.m_offsets[0] = 0;
+    for (int i = 0; i < 10; ++i) {
+        p_strip.m_offsets[i + 1] = p_strip.m_offsets[i] + metrics.width(QChar('0' + i));
+    }
+
+    int ratio = devicePixelRatio();
+    QPixmap pixmap(p_strip.m_offsets[10] * ratio, metrics.height() * ratio);
+    pixmap.setDevicePixelRatio(ratio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setFont(p_font);
+    painter.setPen(m_digitsColor);
+    for (int i = 0; i < 10; ++i) {
+        painter.drawText(p_strip.m_offsets[i], metrics.ascent(), QString(QChar('0' + i)));
+    }
+
+    p_strip.m_pixmap = pixmap;
+}
+
+void LineNumberArea::prepareDigits(const QColor &p_color)
+{
+    if (m_digitsFont == font()
+        && m_digitsColor == p_color
+        && !m_digitStrips[0].m_pixmap.isNull()) {
+        return;
+    }
+
+    m_digitsFont = font();
+    m_digitsColor = p_color;
+
+    renderDigits(m_digitStrips[0], m_digitsFont);
+
+    QFont boldFont = m_digitsFont;
+    boldFont.setBold(true);
+    renderDigits(m_digitStrips[1], boldFont);
+}
+
+void LineNumberArea::drawNumber(QPainter &p_painter, int p_right, int p_top,
+                                int p_number, bool p_bold) const
+{
+    const DigitStrip &strip = m_digitStrips[p_bold ? 1 : 0];
+    int ratio = strip.m_pixmap.devicePixelRatio();
+    int height = strip.m_pixmap.height() / ratio;
+    int x = p_right;
+    do {
+        int digit = p_number % 10;
+        int width = strip.m_offsets[digit + 1] - strip.m_offsets[digit];
+        x -= width;
+        p_painter.drawPixmap(QRect(x, p_top, width, height),
+                             strip.m_pixmap,
+                             QRect(strip.m_offsets[digit] * ratio, 0, width * ratio, height * ratio));
+        p_number /= 10;
+    } while (p_number > 0);
+}
+
 int LineNumberArea::calculateWidth() const
 {
     int bc = m_document->blockCount();
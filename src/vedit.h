@@ -9,15 +9,20 @@
 #include <QColor>
 #include <QRect>
 #include <QFontMetrics>
+#include <QFont>
+#include <QPixmap>
+#include <QHash>
 #include "vconstants.h"
 #include "vtoc.h"
 #include "vfile.h"
+#include "vtextsearcher.h"
 
 class VEditOperations;
 class QLabel;
 class QTimer;
 class VVim;
 class QPaintEvent;
+class QPainter;
 class QResizeEvent;
 class QSize;
 class QWidget;
@@ -91,6 +96,22 @@ public:
                   QTextCursor *p_cursor = NULL,
                   QTextCursor::MoveMode p_moveMode = QTextCursor::MoveAnchor);
 
+    // Jump to the match [@p_start, @p_end) of @p_text found by the caller and
+    // highlight it as findText() does.
+    // @p_wrapped: whether the search wrapped around the document.
+    void jumpToMatch(const QString &p_text, uint p_options,
+                     int p_start, int p_end, bool p_wrapped,
+                     QTextCursor *p_cursor = NULL,
+                     QTextCursor::MoveMode p_moveMode = QTextCursor::MoveAnchor);
+
+    // Find the first match of @p_text starting at or after @p_start if
+    // @p_forward, or the last match starting before @p_start otherwise,
+    // wrapping around the document.
+    // Use the counted matches if they are up to date.
+    // @p_wrapped: whether the search wrapped around the document.
+    bool findMatch(const QString &p_text, uint p_options, bool p_forward,
+                   int p_start, bool &p_wrapped, VTextMatch &p_match);
+
     void replaceText(const QString &p_text, uint p_options,
                      const QString &p_replaceText, bool p_findNext);
     void replaceTextAll(const QString &p_text, uint p_options,
@@ -159,6 +180,11 @@ signals:
     // Request the edit tab to close find and replace dialog.
     void requestCloseFindReplaceDialog();
 
+    // Emit when the matches of the searched text are counted.
+    // @p_current: the index of current match based on 1, or 0 if unknown.
+    // @p_count: the number of matches, or -1 if nothing is searched.
+    void matchCountUpdated(int p_current, int p_count);
+
 public slots:
     virtual void highlightCurrentLine();
 
@@ -173,6 +199,9 @@ public slots:
 private slots:
     void labelTimerTimeout();
     void highlightSelectedWord();
+
+    // Schedule to highlight the selected word once the selection is idle.
+    void handleSelectionChanged();
     void handleSaveExitAct();
     void handleDiscardExitAct();
     void handleEditAct();
@@ -184,6 +213,16 @@ private slots:
 
     void updateLineNumberArea();
 
+    // Highlight the occurences of texts in the new viewport if it is out of
+    // the range highlighted.
+    void updateViewportHighlight();
+
+    // Update the trailing spaces of the blocks touched by a change.
+    void updateTrailingSpaces(int p_position, int p_charsRemoved, int p_charsAdded);
+
+    // Handle the matches of the searched text counted in background.
+    void handleMatchesCounted(int p_id, const QVector<VTextMatch> &p_matches);
+
 protected:
     QPointer<VFile> m_file;
     VEditOperations *m_editOps;
@@ -220,6 +259,87 @@ private:
     // Timer for extra selections highlight.
     QTimer *m_highlightTimer;
 
+    // Text to highlight all its occurences.
+    struct TextHighlight
+    {
+        TextHighlight() : m_options(0), m_filter(NULL)
+        {
+        }
+
+        QString m_text;
+        uint m_options;
+        QTextCharFormat m_format;
+        void (*m_filter)(VEdit *, QList<QTextEdit::ExtraSelection> &);
+    };
+
+    // Occurences of these texts are highlighted only within
+    // [m_highlightFirstBlock, m_highlightLastBlock], which covers the viewport.
+    // Indexed by SelectionId.
+    QVector<TextHighlight> m_textHighlights;
+
+    int m_highlightFirstBlock;
+    int m_highlightLastBlock;
+
+    // Trailing spaces within the highlight range, which are updated
+    // incrementally as the document changes.
+    QVector<QTextCursor> m_trailingSpaces;
+
+    // Whether m_trailingSpaces is up to date with the highlight range.
+    bool m_trailingSpacesValid;
+
+    // Timer to update the highlight after scrolling.
+    QTimer *m_viewportHighlightTimer;
+
+    // Count the matches of the searched text.
+    VTextSearcher *m_textSearcher;
+
+    // Compiled matchers of recent searches and highlights.
+    // Key is the options and the text.
+    QHash<QString, VTextMatcher> m_textMatchers;
+
+    // Id of the counting search in progress.
+    int m_countSearchId;
+
+    // Document revision of the counting search in progress.
+    int m_countRevision;
+
+    // Matches of m_matchesText at document revision m_matchesRevision,
+    // sorted by the start.
+    QVector<VTextMatch> m_matches;
+    QString m_matchesText;
+    uint m_matchesOptions;
+    int m_matchesRevision;
+
+    // Start of current match.
+    int m_matchPosition;
+
+    // Geometry of a block in document coordinates.
+    struct BlockGeometry
+    {
+        int m_number;
+        int m_top;
+        int m_height;
+        bool m_visible;
+    };
+
+    // Geometry of the blocks around the viewport cached for the line number
+    // area. Cleared when the layout changes.
+    QVector<BlockGeometry> m_blockGeometries;
+
+    // Whether m_blockGeometries reaches the last block.
+    bool m_blockGeometriesToEnd;
+
+    // Timer to highlight the selected word after the selection is idle.
+    QTimer *m_selectedWordTimer;
+
+    // Positions of the words within the highlight range.
+    QHash<QString, QVector<int> > m_tokenIndex;
+
+    // Document revision and highlight range m_tokenIndex is built at.
+    int m_tokenIndexRevision;
+    int m_tokenIndexFirstBlock;
+    int m_tokenIndexLastBlock;
+
     bool m_readyToScroll;
     bool m_mouseMoveScrolled;
     int m_oriMouseX;
@@ -239,16 +359,55 @@ private:
     // Do the real work to highlight extra selections.
     void doHighlightExtraSelections();
 
-    // Find all the occurences of @p_text.
-    QList<QTextCursor> findTextAll(const QString &p_text, uint p_options);
-
+    // Highlight all the occurences of @p_text within the viewport.
     // @p_fileter: a function to filter out highlight results.
     void highlightTextAll(const QString &p_text, uint p_options,
                           SelectionId p_id, QTextCharFormat p_format,
                           void (*p_filter)(VEdit *, QList<QTextEdit::ExtraSelection> &) = NULL);
 
+    // Stop highlighting all the occurences of the text of @p_id.
+    // Returns true if there are selections cleared.
+    bool clearTextHighlight(SelectionId p_id);
+
+    // Get the range of the blocks in the viewport.
+    void visibleBlockRange(int &p_first, int &p_last);
+
+    // Move the highlight range to the viewport plus one page above and below
+    // if the viewport is out of it.
+    // Returns true if the range is moved.
+    bool updateHighlightRange();
+
+    // Find the occurences of the text of @p_id within the highlight range.
+    void highlightTextInRange(SelectionId p_id);
+
+    // Build m_tokenIndex if the document or the highlight range has changed.
+    void updateTokenIndex();
+
+    // Find the occurences of all the texts and the trailing spaces within the
+    // highlight range.
+    void highlightAllInRange();
+
+    // Append the trailing space of @p_block to m_trailingSpaces if there is any.
+    void findTrailingSpace(const QTextBlock &p_block);
+
+    void findTrailingSpacesInRange();
+
     void highlightSearchedWord(const QString &p_text, uint p_options);
 
+    // Get the matcher of @p_text with @p_options, which is compiled once and
+    // reused by the following searches and highlights.
+    VTextMatcher textMatcher(const QString &p_text, uint p_options);
+
+    // Report the index of the match at @p_position among all the matches of
+    // @p_text, which are counted in background if not cached.
+    void countMatches(const QString &p_text, uint p_options, int p_position);
+
+    // Stop counting and report @p_count matches.
+    void cancelCountMatches(int p_count);
+
+    // Emit the index of m_matchPosition in m_matches.
+    void reportMatchIndex();
+
     // Highlight @p_cursor as the searched keyword under cursor.
     void highlightSearchedWordUnderCursor(const QTextCursor &p_cursor);
 
@@ -260,6 +419,14 @@ private:
     // Return the first visible block.
     QTextBlock firstVisibleBlock();
 
+    // Whether m_blockGeometries covers [@p_top, @p_bottom] in document
+    // coordinates.
+    bool blockGeometriesCover(int p_top, int p_bottom) const;
+
+    // Cache the geometry of the blocks covering [@p_top, @p_bottom] in document
+    // coordinates, plus one page above and below.
+    void updateBlockGeometries(int p_top, int p_bottom);
+
     // Return the y offset of the content.
     int contentOffsetY();
 
@@ -296,6 +463,13 @@ public:
         return m_digitHeight;
     }
 
+    // Draw @p_number right aligned to @p_right with the pre-rendered digits.
+    void drawNumber(QPainter &p_painter, int p_right, int p_top,
+                    int p_number, bool p_bold) const;
+
+    // Render the digits again if the font or @p_color changes.
+    void prepareDigits(const QColor &p_color);
+
 protected:
     void paintEvent(QPaintEvent *p_event) Q_DECL_OVERRIDE
     {
@@ -309,6 +483,23 @@ private:
     int m_blockCount;
     int m_digitWidth;
     int m_digitHeight;
+
+    // Digits 0-9 rendered in one pixmap.
+    struct DigitStrip
+    {
+        QPixmap m_pixmap;
+
+        // Digit i is within [m_offsets[i], m_offsets[i + 1]).
+        int m_offsets[11];
+    };
+
+    void renderDigits(DigitStrip &p_strip, const QFont &p_font);
+
+    // Normal and bold digits.
+    DigitStrip m_digitStrips[2];
+
+    QFont m_digitsFont;
+    QColor m_digitsColor;
 };
 
 #endif // VEDIT_H
@@ -83,6 +83,8 @@ void VEditArea::insertSplitWindow(int idx)
             this, &VEditArea::handleWindowStatusMessage);
     connect(win, &VEditWindow::vimStatusUpdated,
             this, &VEditArea::handleWindowVimStatusUpdated);
+    connect(win, &VEditWindow::matchCountUpdated,
+            this, &VEditArea::handleWindowMatchCountUpdated);
 }
 
 void VEditArea::handleWindowTabStatusUpdated(const VEditTabInfo &p_info)
@@ -92,6 +94,13 @@ void VEditArea::handleWindowTabStatusUpdated(const VEditTabInfo &p_info)
     }
 }
 
+void VEditArea::handleWindowMatchCountUpdated(int p_current, int p_count)
+{
+    if (splitter->widget(curWindowIndex) == sender()) {
+        m_findReplace->updateMatchCount(p_current, p_count);
+    }
+}
+
 void VEditArea::handleWindowStatusMessage(const QString &p_msg)
 {
     if (splitter->widget(curWindowIndex) == sender()) {
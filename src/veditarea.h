@@ -113,6 +113,9 @@ private slots:
     // Handle the vimStatusUpdated signal of VEditWindow.
     void handleWindowVimStatusUpdated(const VVim *p_vim);
 
+    // Handle the matchCountUpdated signal of VEditWindow.
+    void handleWindowMatchCountUpdated(int p_current, int p_count);
+
 private:
     void setupUI();
     QVector<QPair<int, int> > findTabsByFile(const VFile *p_file);
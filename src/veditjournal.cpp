@@ -0,0 +1,264 @@
+#include "veditjournal.h"
+
+#include <QDir>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QCryptographicHash>
+#include <QTimer>
+#include <QDebug>
+
+#include "vconfigmanager.h"
+
+extern VConfigManager *g_config;
+
+static const QString c_journalFolderName = "journal";
+
+static const QString c_journalSuffix = ".journal";
+
+static const quint32 c_journalMagic = 0x564e4a4c;
+
+static const quint32 c_journalVersion = 1;
+
+// Record types.
+static const quint8 c_checkpointRecord = 0;
+static const quint8 c_deltaRecord = 1;
+
+// Compact the journal into a new checkpoint after so many deltas.
+static const int c_maxDeltaCount = 2000;
+
+// Interval to flush the deltas to disk.
+static const int c_flushInterval = 1000;
+
+// Each tab has its own journal even if the same note is opened in several tabs.
+static int s_journalId = 0;
+
+VEditJournal::VEditJournal(const QString &p_notePath, QTextDocument *p_doc, QObject *p_parent)
+    : QObject(p_parent), m_notePath(p_notePath), m_doc(p_doc), m_enabled(false),
+      m_deltaCount(0), m_revision(-1)
+{
+    QByteArray hash = QCryptographicHash::hash(p_notePath.toUtf8(), QCryptographicHash::Md5);
+    QString name = QString("%1_%2%3").arg(QString(hash.toHex()))
+                                     .arg(++s_journalId)
+                                     .arg(c_journalSuffix);
+    m_journalPath = QDir(journalFolder()).filePath(name);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(c_flushInterval);
+    connect(m_flushTimer, &QTimer::timeout,
+            this, &VEditJournal::flush);
+
+    connect(m_doc, &QTextDocument::contentsChange,
+            this, &VEditJournal::handleContentsChange);
+}
+
+VEditJournal::~VEditJournal()
+{
+    // Closing a tab will prompt to save or discard the changes.
+    stop();
+}
+
+void VEditJournal::start()
+{
+    m_enabled = true;
+    m_revision = m_doc->revision();
+}
+
+void VEditJournal::stop()
+{
+    m_enabled = false;
+    removeJournalFile();
+}
+
+void VEditJournal::discard()
+{
+    removeJournalFile();
+}
+
+void VEditJournal::handleContentsChange(int p_position, int p_charsRemoved, int p_charsAdded)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    // Changes of formats, such as those from the highlighter, do not change
+    // the revision.
+    int revision = m_doc->revision();
+    if (p_charsRemoved == p_charsAdded && revision == m_revision) {
+        return;
+    }
+
+    m_revision = revision;
+
+    if (!m_doc->isModified()) {
+        // Same as the note on disk.
+        removeJournalFile();
+        return;
+    }
+
+    if (!m_file.isOpen() || m_deltaCount >= c_maxDeltaCount) {
+        checkpoint();
+        return;
+    }
+
+    // The last character of the document is a paragraph separator which is
+    // not part of the text.
+    int end = qMin(p_position + p_charsAdded, m_doc->characterCount() - 1);
+    QString added;
+    if (end > p_position) {
+        QTextCursor cursor(m_doc);
+        cursor.setPosition(p_position);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        added = cursor.selectedText();
+        added.replace(QChar::ParagraphSeparator, '\n');
+    }
+
+    QDataStream out(&m_file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << c_deltaRecord << qint32(p_position) << qint32(p_charsRemoved) << added;
+    if (out.status() != QDataStream::Ok) {
+        qWarning() << "fail to write journal" << m_journalPath;
+        removeJournalFile();
+        return;
+    }
+
+    ++m_deltaCount;
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void VEditJournal::flush()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+}
+
+bool VEditJournal::checkpoint()
+{
+    m_flushTimer->stop();
+    m_file.close();
+    m_deltaCount = 0;
+
+    QDir dir;
+    if (!dir.mkpath(journalFolder())) {
+        qWarning() << "fail to create journal folder" << journalFolder();
+        return false;
+    }
+
+    // Write the checkpoint to a new journal so a crash meanwhile will not
+    // lose the old one.
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "fail to open journal" << m_journalPath << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << c_journalMagic << c_journalVersion << m_notePath;
+    out << c_checkpointRecord << m_doc->toPlainText();
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "fail to write journal" << m_journalPath;
+        return false;
+    }
+
+    m_file.setFileName(m_journalPath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "fail to open journal" << m_journalPath << m_file.errorString();
+        return false;
+    }
+
+    qDebug() << "checkpoint journal" << m_journalPath << "of" << m_notePath;
+    return true;
+}
+
+void VEditJournal::removeJournalFile()
+{
+    m_flushTimer->stop();
+    m_file.close();
+    m_deltaCount = 0;
+
+    if (QFile::exists(m_journalPath) && !QFile::remove(m_journalPath)) {
+        qWarning() << "fail to remove journal" << m_journalPath;
+    }
+}
+
+QString VEditJournal::journalFolder()
+{
+    return g_config->getConfigFolder() + QDir::separator() + c_journalFolderName;
+}
+
+QStringList VEditJournal::listJournals()
+{
+    QDir dir(journalFolder());
+    QStringList journals;
+    QStringList names = dir.entryList(QStringList() << ("*" + c_journalSuffix), QDir::Files);
+    for (auto const &name : names) {
+        journals.append(dir.filePath(name));
+    }
+
+    return journals;
+}
+
+// Remove the lines of image previews, which VMdEdit inserts as a new line
+// holding an object replacement character.
+static void removeImagePreviews(QString &p_text)
+{
+    int idx = p_text.indexOf(QChar::ObjectReplacementCharacter);
+    while (idx != -1) {
+        int lineStart = p_text.lastIndexOf('\n', idx);
+        if (lineStart == -1) {
+            lineStart = 0;
+        }
+
+        p_text.remove(lineStart, idx - lineStart + 1);
+        idx = p_text.indexOf(QChar::ObjectReplacementCharacter, lineStart);
+    }
+}
+
+bool VEditJournal::readJournal(const QString &p_journalPath, QString &p_notePath, QString &p_text)
+{
+    QFile file(p_journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "fail to open journal" << p_journalPath;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    quint8 type = 0;
+    in >> magic >> version >> p_notePath >> type >> p_text;
+    if (in.status() != QDataStream::Ok
+        || magic != c_journalMagic
+        || version != c_journalVersion
+        || type != c_checkpointRecord) {
+        qWarning() << "invalid journal" << p_journalPath;
+        return false;
+    }
+
+    // A delta partially written when crashed is dropped.
+    while (!in.atEnd()) {
+        qint32 position = 0, removed = 0;
+        QString added;
+        in >> type >> position >> removed >> added;
+        if (in.status() != QDataStream::Ok || type != c_deltaRecord) {
+            qWarning() << "journal" << p_journalPath << "is truncated";
+            break;
+        }
+
+        if (position < 0 || position > p_text.size() || removed < 0) {
+            qWarning() << "invalid delta in journal" << p_journalPath;
+            break;
+        }
+
+        p_text.replace(position, qMin(int(removed), p_text.size() - position), added);
+    }
+
+    removeImagePreviews(p_text);
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef VEDITJOURNAL_H
+#define VEDITJOURNAL_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+
+class QTextDocument;
+class QTimer;
+
+// Write-ahead journal of the unsaved changes of a note being edited, so they
+// could be recovered after a crash.
+// A journal starts with a checkpoint of the whole text followed by the deltas
+// from QTextDocument::contentsChange. Deltas are appended and flushed to disk
+// in batches, and the journal is compacted into a new checkpoint after a number
+// of deltas. The journal is removed once the text equals the note on disk.
+// Journals are kept in the journal folder within the config folder.
+class VEditJournal : public QObject
+{
+    Q_OBJECT
+public:
+    VEditJournal(const QString &p_notePath, QTextDocument *p_doc, QObject *p_parent = 0);
+
+    ~VEditJournal();
+
+    // Start journaling changes of the document.
+    void start();
+
+    // Stop journaling and remove the journal.
+    void stop();
+
+    // Remove the journal since the text has been saved.
+    // Following changes will start a new journal.
+    void discard();
+
+    // Paths of all the journals left in the journal folder.
+    static QStringList listJournals();
+
+    // Replay journal @p_journalPath.
+    // @p_notePath: will be set to the path of the note of the journal.
+    // @p_text: will be set to the text of the note recorded by the journal.
+    // Returns false if the journal is broken.
+    static bool readJournal(const QString &p_journalPath, QString &p_notePath, QString &p_text);
+
+private slots:
+    void handleContentsChange(int p_position, int p_charsRemoved, int p_charsAdded);
+
+    // Flush the deltas written to disk.
+    void flush();
+
+private:
+    // Write a new journal with the whole text of the document.
+    bool checkpoint();
+
+    // Close and remove the journal file.
+    void removeJournalFile();
+
+    static QString journalFolder();
+
+    QString m_notePath;
+
+    QTextDocument *m_doc;
+
+    // Path of the journal file.
+    QString m_journalPath;
+
+    QFile m_file;
+
+    bool m_enabled;
+
+    // Number of deltas since last checkpoint.
+    int m_deltaCount;
+
+    // Revision of the document when last change is handled.
+    int m_revision;
+
+    // Flush the deltas in batches.
+    QTimer *m_flushTimer;
+};
+
+#endif // VEDITJOURNAL_H
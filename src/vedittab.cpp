@@ -1,6 +1,13 @@
 #include "vedittab.h"
 #include <QApplication>
 #include <QWheelEvent>
+#include <QMessageBox>
+#include "vnote.h"
+#include "vfilesaver.h"
+#include "vsearchindex.h"
+#include "utils/vutils.h"
+
+extern VNote *g_vnote;
 
 VEditTab::VEditTab(VFile *p_file, VEditArea *p_editArea, QWidget *p_parent)
     : QWidget(p_parent), m_file(p_file), m_isEditMode(false),
@@ -11,6 +18,8 @@ VEditTab::VEditTab(VFile *p_file, VEditArea *p_editArea, QWidget *p_parent)
 
     connect(qApp, &QApplication::focusChanged,
             this, &VEditTab::handleFocusChanged);
+    connect(g_vnote->getFileSaver(), &VFileSaver::fileSaved,
+            this, &VEditTab::handleSaverFileSaved);
 }
 
 VEditTab::~VEditTab()
@@ -92,3 +101,37 @@ VEditTabInfo VEditTab::createEditTabInfo()
 
     return info;
 }
+
+void VEditTab::handleSaverFileSaved(const QString &p_path, bool p_succeed)
+{
+    if (!m_file || p_path != m_file->retrivePath()) {
+        return;
+    }
+
+    handleFileSaved(p_succeed);
+}
+
+void VEditTab::handleFileSaved(bool p_succeed)
+{
+    if (!p_succeed) {
+        VUtils::showMessage(QMessageBox::Warning, tr("Warning"), tr("Fail to save note."),
+                            tr("Fail to write to disk when saving a note. Please try it again."),
+                            QMessageBox::Ok, QMessageBox::Ok, this);
+        return;
+    }
+
+    // Wait for the last one if saves are queued.
+    QString path = m_file->retrivePath();
+    if (g_vnote->getFileSaver()->isPending(path)) {
+        return;
+    }
+
+    if (m_file->getType() == FileType::Normal) {
+        g_vnote->getSearchIndex()->updateNote(path, m_file->getNotebookName(), m_file->getContent());
+    }
+
+    // The editor holds the text while editing.
+    if (m_isEditMode) {
+        m_file->releaseContent();
+    }
+}
@@ -90,6 +90,9 @@ protected:
     // Create a filled VEditTabInfo.
     virtual VEditTabInfo createEditTabInfo();
 
+    // Called when the content of the file of this tab has been written to disk.
+    virtual void handleFileSaved(bool p_succeed);
+
     // File related to this tab.
     QPointer<VFile> m_file;
     bool m_isEditMode;
@@ -113,9 +116,15 @@ signals:
 
     void vimStatusUpdated(const VVim *p_vim);
 
+    // Emit when the matches of the searched text are counted.
+    void matchCountUpdated(int p_current, int p_count);
+
 private slots:
     // Called when app focus changed.
     void handleFocusChanged(QWidget *p_old, QWidget *p_now);
+
+    // Called when VFileSaver finishes writing @p_path.
+    void handleSaverFileSaved(const QString &p_path, bool p_succeed);
 };
 
 #endif // VEDITTAB_H
@@ -696,6 +696,14 @@ void VEditWindow::handleTabStatusMessage(const QString &p_msg)
     }
 }
 
+void VEditWindow::handleTabMatchCountUpdated(int p_current, int p_count)
+{
+    int idx = indexOf(dynamic_cast<QWidget *>(sender()));
+    if (idx == currentIndex()) {
+        emit matchCountUpdated(p_current, p_count);
+    }
+}
+
 void VEditWindow::handleTabVimStatusUpdated(const VVim *p_vim)
 {
     int idx = indexOf(dynamic_cast<QWidget *>(sender()));
@@ -863,6 +871,8 @@ void VEditWindow::connectEditTab(const VEditTab *p_tab)
             this, &VEditWindow::handleTabStatusMessage);
     connect(p_tab, &VEditTab::vimStatusUpdated,
             this, &VEditWindow::handleTabVimStatusUpdated);
+    connect(p_tab, &VEditTab::matchCountUpdated,
+            this, &VEditWindow::handleTabMatchCountUpdated);
 }
 
 void VEditWindow::setCurrentWindow(bool p_current)
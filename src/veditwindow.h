@@ -88,6 +88,9 @@ signals:
     // Emit when Vim mode status changed.
     void vimStatusUpdated(const VVim *p_vim);
 
+    // Emit when the matches of the searched text in current tab are counted.
+    void matchCountUpdated(int p_current, int p_count);
+
 private slots:
     // Close tab @p_index.
     bool closeTab(int p_index);
@@ -114,6 +117,9 @@ private slots:
     // Handle the vimStatusUpdated() signal of VEditTab.
     void handleTabVimStatusUpdated(const VVim *p_vim);
 
+    // Handle the matchCountUpdated() signal of VEditTab.
+    void handleTabMatchCountUpdated(int p_current, int p_count);
+
     // Handle the statusUpdated signal of VEditTab.
     void handleTabStatusUpdated(const VEditTabInfo &p_info);
 
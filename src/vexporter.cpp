@@ -22,6 +22,9 @@
 #include "vnote.h"
 #include "vmarkdownconverter.h"
 #include "vdocument.h"
+#include "vdirectory.h"
+#include "vnotebook.h"
+#include "vbatchexporter.h"
 
 extern VConfigManager *g_config;
 
@@ -29,7 +32,8 @@ QString VExporter::s_defaultPathDir = QDir::homePath();
 
 VExporter::VExporter(MarkdownConverterType p_mdType, QWidget *p_parent)
     : QDialog(p_parent), m_webViewer(NULL), m_mdType(p_mdType),
-      m_file(NULL), m_type(ExportType::PDF), m_source(ExportSource::Invalid),
+      m_file(NULL), m_dir(NULL), m_batchExporter(NULL),
+      m_type(ExportType::PDF), m_source(ExportSource::Invalid),
       m_noteState(NoteState::NotReady), m_state(ExportState::Idle),
       m_pageLayout(QPageLayout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF(0.0, 0.0, 0.0, 0.0))),
       m_exported(false)
@@ -69,6 +73,24 @@ void VExporter::setupUI()
     m_layoutBtn->hide();
 #endif
 
+    // Batch export.
+    m_workerLabel = new QLabel(tr("Parallel pages:"));
+    m_workerSpin = new QSpinBox();
+    m_workerSpin->setRange(1, 16);
+    m_workerSpin->setValue(VBatchExporter::defaultWorkerCount());
+    m_workerSpin->setToolTip(tr("Number of notes to convert in parallel"));
+    m_workerLabel->setBuddy(m_workerSpin);
+
+    m_skipExportedCB = new QCheckBox(tr("Skip notes exported already"));
+    m_skipExportedCB->setToolTip(tr("Skip notes whose target file is newer than the note "
+                                    "to resume an interrupted export"));
+
+    m_mergeCB = new QCheckBox(tr("Merge into one PDF file"));
+    m_mergeCB->setToolTip(tr("Merge all the notes into one PDF file with an outline "
+                             "following the folder structure"));
+    connect(m_mergeCB, &QCheckBox::toggled,
+            this, &VExporter::handleMergeCBToggled);
+
     // Progress.
     m_proLabel = new QLabel(this);
     m_proBar = new QProgressBar(this);
@@ -91,10 +113,18 @@ void VExporter::setupUI()
     mainLayout->addWidget(layoutLabel, 2, 0);
     mainLayout->addWidget(m_layoutLabel, 2, 1);
     mainLayout->addWidget(m_layoutBtn, 2, 2);
-    mainLayout->addWidget(m_proLabel, 3, 1, 1, 2);
-    mainLayout->addWidget(m_proBar, 4, 1, 1, 2);
-    mainLayout->addWidget(m_btnBox, 5, 1, 1, 2);
-
+    mainLayout->addWidget(m_workerLabel, 3, 0);
+    mainLayout->addWidget(m_workerSpin, 3, 1);
+    mainLayout->addWidget(m_skipExportedCB, 4, 1, 1, 2);
+    mainLayout->addWidget(m_mergeCB, 5, 1, 1, 2);
+    mainLayout->addWidget(m_proLabel, 6, 1, 1, 2);
+    mainLayout->addWidget(m_proBar, 7, 1, 1, 2);
+    mainLayout->addWidget(m_btnBox, 8, 1, 1, 2);
+
+    m_workerLabel->hide();
+    m_workerSpin->hide();
+    m_skipExportedCB->hide();
+    m_mergeCB->hide();
     m_proLabel->hide();
     m_proBar->hide();
 
@@ -118,6 +148,23 @@ static QString exportTypeStr(ExportType p_type)
 
 void VExporter::handleBrowseBtnClicked()
 {
+    if (isBatchExport() && !isMergeExport()) {
+        QString dirPath = QFileDialog::getExistingDirectory(this,
+                                                            tr("Select Target Folder"),
+                                                            getFilePath(),
+                                                            QFileDialog::ShowDirsOnly
+                                                            | QFileDialog::DontResolveSymlinks);
+        if (dirPath.isEmpty()) {
+            return;
+        }
+
+        setFilePath(dirPath);
+        s_defaultPathDir = dirPath;
+
+        m_openBtn->hide();
+        return;
+    }
+
     QFileInfo fi(getFilePath());
     QString fileType = m_type == ExportType::PDF ?
                        tr("Portable Document Format (*.pdf)") :
@@ -193,6 +240,191 @@ void VExporter::exportNote(VFile *p_file, ExportType p_type)
                                                 "." + exportTypeStr(p_type).toLower()));
 }
 
+void VExporter::exportDirectory(VDirectory *p_dir, ExportType p_type)
+{
+    m_source = ExportSource::Directory;
+    initBatchExport(p_dir, p_dir ? p_dir->getName() : QString(), p_type);
+}
+
+void VExporter::exportNotebook(VNotebook *p_notebook, ExportType p_type)
+{
+    m_source = ExportSource::Notebook;
+    initBatchExport(p_notebook ? p_notebook->getRootDir() : NULL,
+                    p_notebook ? p_notebook->getName() : QString(),
+                    p_type);
+}
+
+void VExporter::initBatchExport(VDirectory *p_dir, const QString &p_name, ExportType p_type)
+{
+    m_dir = p_dir;
+    m_type = p_type;
+
+    if (!m_dir) {
+        m_btnBox->button(QDialogButtonBox::Ok)->setEnabled(false);
+        return;
+    }
+
+    bool isNotebook = m_source == ExportSource::Notebook;
+    m_infoLabel->setText(tr("Export all the notes in %1 <span style=\"%2\">%3</span> as %4. "
+                            "The folder structure will be kept in the target folder.")
+                            .arg(isNotebook ? tr("notebook") : tr("folder"))
+                            .arg(g_config->c_dataTextStyle)
+                            .arg(p_name)
+                            .arg(exportTypeStr(p_type)));
+
+    setWindowTitle(tr("Export %1 As %2").arg(isNotebook ? tr("Notebook") : tr("Folder"))
+                                        .arg(exportTypeStr(p_type)));
+
+    m_workerLabel->show();
+    m_workerSpin->show();
+    m_skipExportedCB->show();
+
+    if (p_type == ExportType::PDF) {
+        m_mergeCB->show();
+    } else {
+        m_layoutBtn->setEnabled(false);
+    }
+
+    setFilePath(QDir(s_defaultPathDir).filePath(p_name));
+}
+
+bool VExporter::isBatchExport() const
+{
+    return m_source == ExportSource::Directory || m_source == ExportSource::Notebook;
+}
+
+bool VExporter::isMergeExport() const
+{
+    return isBatchExport() && m_type == ExportType::PDF && m_mergeCB->isChecked();
+}
+
+void VExporter::handleMergeCBToggled(bool p_checked)
+{
+    // Target is a PDF file instead of a folder.
+    QString path = getFilePath();
+    if (p_checked) {
+        if (!path.endsWith(".pdf", Qt::CaseInsensitive)) {
+            path += ".pdf";
+        }
+    } else if (path.endsWith(".pdf", Qt::CaseInsensitive)) {
+        path.chop(4);
+    }
+
+    setFilePath(path);
+
+    // Temporary PDF files are always newly exported.
+    m_skipExportedCB->setEnabled(!p_checked);
+    m_openBtn->hide();
+}
+
+int VExporter::exportBatch()
+{
+    V_ASSERT(m_dir);
+    m_proLabel->setText(tr("Collecting notes"));
+    m_proLabel->show();
+
+    if (isMergeExport()) {
+        return exportBatchToOnePdf();
+    }
+
+    QVector<VExportTask> tasks = VBatchExporter::generateTasks(m_dir, m_type, getFilePath());
+    if (tasks.isEmpty()) {
+        m_infoLabel->setText(tr("No note to export."));
+        m_state = ExportState::Failed;
+        return 0;
+    }
+
+    m_proBar->setEnabled(true);
+    m_proBar->setMinimum(0);
+    m_proBar->setMaximum(tasks.size());
+    m_proBar->reset();
+    m_proBar->show();
+
+    VBatchExporter exporter(m_mdType);
+    exporter.setWorkerCount(m_workerSpin->value());
+    exporter.setPageLayout(m_pageLayout);
+    exporter.setSkipUpToDate(m_skipExportedCB->isChecked());
+    connect(&exporter, &VBatchExporter::progressChanged,
+            this, [this](int p_done, int p_total, const QString &p_name) {
+                m_proLabel->setText(tr("Exported %1 (%2/%3)").arg(p_name).arg(p_done).arg(p_total));
+                m_proBar->setValue(p_done);
+            });
+
+    m_batchExporter = &exporter;
+    int exportedNum = exporter.exportNotes(tasks, m_type);
+    m_batchExporter = NULL;
+
+    if (m_state == ExportState::Cancelled) {
+        return exportedNum;
+    }
+
+    const QStringList &failedNotes = exporter.getFailedNotes();
+    m_infoLabel->setText(tr("%1 notes exported, %2 skipped, %3 failed.")
+                           .arg(exportedNum)
+                           .arg(exporter.getSkippedCount())
+                           .arg(failedNotes.size()));
+    if (!failedNotes.isEmpty()) {
+        m_infoLabel->setToolTip(failedNotes.join('\n'));
+        m_state = ExportState::Failed;
+    } else {
+        m_state = ExportState::Successful;
+    }
+
+    return exportedNum;
+}
+
+int VExporter::exportBatchToOnePdf()
+{
+    m_proBar->setEnabled(true);
+    m_proBar->setMinimum(0);
+    m_proBar->setMaximum(0);
+    m_proBar->reset();
+    m_proBar->show();
+
+    VBatchExporter exporter(m_mdType);
+    exporter.setWorkerCount(m_workerSpin->value());
+    exporter.setPageLayout(m_pageLayout);
+    connect(&exporter, &VBatchExporter::progressChanged,
+            this, [this](int p_done, int p_total, const QString &p_name) {
+                m_proLabel->setText(tr("Exported %1 (%2/%3)").arg(p_name).arg(p_done).arg(p_total));
+                m_proBar->setMaximum(p_total);
+                m_proBar->setValue(p_done);
+            });
+    connect(&exporter, &VBatchExporter::mergeProgressChanged,
+            this, [this](int p_done, int p_total) {
+                m_proLabel->setText(tr("Merging PDF files (%1/%2)").arg(p_done).arg(p_total));
+                m_proBar->setMaximum(p_total);
+                m_proBar->setValue(p_done);
+            });
+
+    m_batchExporter = &exporter;
+    int mergedNum = exporter.exportToOnePdf(m_dir, getFilePath());
+    m_batchExporter = NULL;
+
+    if (m_state == ExportState::Cancelled) {
+        return mergedNum;
+    }
+
+    const QStringList &failedNotes = exporter.getFailedNotes();
+    if (mergedNum == 0) {
+        m_infoLabel->setText(tr("Fail to export notes into one PDF file."));
+        m_state = ExportState::Failed;
+        return 0;
+    }
+
+    m_infoLabel->setText(tr("%1 notes merged into one PDF file, %2 failed.")
+                           .arg(mergedNum)
+                           .arg(failedNotes.size()));
+    if (!failedNotes.isEmpty()) {
+        m_infoLabel->setToolTip(failedNotes.join('\n'));
+        m_state = ExportState::Failed;
+    } else {
+        m_state = ExportState::Successful;
+    }
+
+    return mergedNum;
+}
+
 void VExporter::initWebViewer(VFile *p_file)
 {
     V_ASSERT(!m_webViewer);
@@ -342,6 +574,8 @@ void VExporter::startExport()
             m_proBar->setEnabled(false);
             m_state = ExportState::Failed;
         }
+    } else if (isBatchExport()) {
+        exportedNum = exportBatch();
     }
 
 exit:
@@ -370,6 +604,9 @@ void VExporter::cancelExport()
         reject();
     } else {
         m_state = ExportState::Cancelled;
+        if (m_batchExporter) {
+            m_batchExporter->cancel();
+        }
     }
 }
 
@@ -414,11 +651,16 @@ void VExporter::enableUserInput(bool p_enabled)
     m_btnBox->button(QDialogButtonBox::Ok)->setEnabled(p_enabled);
     m_pathEdit->setEnabled(p_enabled);
     m_browseBtn->setEnabled(p_enabled);
-    m_layoutBtn->setEnabled(p_enabled);
+    m_layoutBtn->setEnabled(p_enabled && m_type == ExportType::PDF);
+    m_workerSpin->setEnabled(p_enabled);
+    m_skipExportedCB->setEnabled(p_enabled && !m_mergeCB->isChecked());
+    m_mergeCB->setEnabled(p_enabled);
 }
 
 void VExporter::openTargetPath() const
 {
-    QUrl url = QUrl::fromLocalFile(VUtils::basePathFromPath(getFilePath()));
+    QString path = isBatchExport() && !isMergeExport() ? getFilePath()
+                                                       : VUtils::basePathFromPath(getFilePath());
+    QUrl url = QUrl::fromLocalFile(path);
     QDesktopServices::openUrl(url);
 }
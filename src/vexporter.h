@@ -5,20 +5,20 @@
 #include <QPageLayout>
 #include <QString>
 #include "vconfigmanager.h"
+#include "vconstants.h"
 
 class VWebView;
 class VFile;
+class VDirectory;
+class VNotebook;
+class VBatchExporter;
 class QLineEdit;
 class QLabel;
 class QDialogButtonBox;
 class QPushButton;
 class QProgressBar;
-
-enum class ExportType
-{
-    PDF = 0,
-    HTML
-};
+class QSpinBox;
+class QCheckBox;
 
 class VExporter : public QDialog
 {
@@ -28,6 +28,12 @@ public:
 
     void exportNote(VFile *p_file, ExportType p_type);
 
+    // Export all the notes in @p_dir and its sub-directories.
+    void exportDirectory(VDirectory *p_dir, ExportType p_type);
+
+    // Export all the notes in @p_notebook.
+    void exportNotebook(VNotebook *p_notebook, ExportType p_type);
+
 private slots:
     void handleBrowseBtnClicked();
     void handleLayoutBtnClicked();
@@ -36,6 +42,7 @@ private slots:
     void handleLogicsFinished();
     void handleLoadFinished(bool p_ok);
     void openTargetPath() const;
+    void handleMergeCBToggled(bool p_checked);
 
 private:
     enum class ExportSource
@@ -72,6 +79,23 @@ private:
 
     void setFilePath(const QString &p_path);
 
+    // Init UI to export all the notes in @p_dir as @p_type.
+    void initBatchExport(VDirectory *p_dir, const QString &p_name, ExportType p_type);
+
+    // Whether it will export multiple notes to a folder.
+    bool isBatchExport() const;
+
+    // Whether it will merge multiple notes into one PDF file.
+    bool isMergeExport() const;
+
+    // Export all the notes in m_dir with m_batchExporter.
+    // Returns the number of notes exported.
+    int exportBatch();
+
+    // Export all the notes in m_dir into one PDF file.
+    // Returns the number of notes merged.
+    int exportBatchToOnePdf();
+
     QString getFilePath() const;
 
     void initWebViewer(VFile *p_file);
@@ -92,6 +116,13 @@ private:
     MarkdownConverterType m_mdType;
     QString m_htmlTemplate;
     VFile *m_file;
+
+    // The directory to export for ExportSource::Directory and ExportSource::Notebook.
+    VDirectory *m_dir;
+
+    // Valid only during batch export.
+    VBatchExporter *m_batchExporter;
+
     ExportType m_type;
     ExportSource m_source;
     NoteState m_noteState;
@@ -103,6 +134,17 @@ private:
     QPushButton *m_browseBtn;
     QLabel *m_layoutLabel;
     QPushButton *m_layoutBtn;
+
+    // Number of web pages to use in parallel in batch export.
+    QLabel *m_workerLabel;
+    QSpinBox *m_workerSpin;
+
+    // Skip the notes which have been exported and not changed since then.
+    QCheckBox *m_skipExportedCB;
+
+    // Merge all the notes into one PDF file in batch export.
+    QCheckBox *m_mergeCB;
+
     QDialogButtonBox *m_btnBox;
     QPushButton *m_openBtn;
 
@@ -5,12 +5,16 @@
 #include <QTextEdit>
 #include <QFileInfo>
 #include "utils/vutils.h"
+#include "vnote.h"
+#include "vfilesaver.h"
+
+extern VNote *g_vnote;
 
 VFile::VFile(const QString &p_name, QObject *p_parent,
              FileType p_type, bool p_modifiable)
     : QObject(p_parent), m_name(p_name), m_opened(false), m_modified(false),
-      m_docType(VUtils::docTypeFromName(p_name)),
-      m_type(p_type), m_modifiable(p_modifiable)
+      m_docType(VUtils::docTypeFromName(p_name)), m_contentReleased(false),
+      m_type(p_type), m_modifiable(p_modifiable), m_pathRevision(-1)
 {
 }
 
@@ -28,6 +32,7 @@ bool VFile::open()
     QString path = retrivePath();
     qDebug() << "path" << path;
     m_content = VUtils::readFileFromDisk(path);
+    m_contentReleased = false;
     m_modified = false;
     m_opened = true;
     qDebug() << "file" << m_name << "opened";
@@ -39,7 +44,15 @@ void VFile::close()
     if (!m_opened) {
         return;
     }
+
+    // Make sure the content has been written before others touch the file.
+    // Callers which may discard the changes should have checked it already.
+    if (!waitForSaved()) {
+        qWarning() << "last save of file failed" << retrivePath();
+    }
+
     m_content.clear();
+    m_contentReleased = false;
     m_opened = false;
 }
 
@@ -65,8 +78,27 @@ void VFile::deleteDiskFile()
 bool VFile::save()
 {
     Q_ASSERT(m_opened);
-    bool ret = VUtils::writeFileToDisk(retrivePath(), m_content);
-    return ret;
+    if (m_contentReleased) {
+        // Nothing changed since the content was written or read.
+        return true;
+    }
+
+    // CLI export may run without VNote.
+    if (!g_vnote) {
+        return VFileSaver::writeFileAtomically(retrivePath(), m_content);
+    }
+
+    g_vnote->getFileSaver()->save(retrivePath(), m_content);
+    return true;
+}
+
+bool VFile::waitForSaved() const
+{
+    if (!g_vnote) {
+        return true;
+    }
+
+    return g_vnote->getFileSaver()->waitForFile(retrivePath());
 }
 
 void VFile::convert(DocType p_curType, DocType p_targetType)
@@ -115,6 +147,7 @@ void VFile::deleteLocalImages()
 void VFile::setName(const QString &p_name)
 {
     m_name = p_name;
+    VDirectory::invalidatePaths();
     DocType newType = VUtils::docTypeFromName(p_name);
     if (newType != m_docType) {
         qWarning() << "setName() change the DocType. A convertion should be followed";
@@ -145,6 +178,12 @@ DocType VFile::getDocType() const
 
 const QString &VFile::getContent() const
 {
+    if (m_contentReleased) {
+        Q_ASSERT(m_opened);
+        m_content = VUtils::readFileFromDisk(retrivePath());
+        m_contentReleased = false;
+    }
+
     return m_content;
 }
 
@@ -165,8 +204,13 @@ VNotebook *VFile::getNotebook()
 
 QString VFile::retrivePath() const
 {
-    QString dirPath = getDirectory()->retrivePath();
-    return QDir(dirPath).filePath(m_name);
+    int revision = VDirectory::getPathRevision();
+    if (m_pathRevision != revision) {
+        m_cachedPath = QDir(getDirectory()->retrivePath()).filePath(m_name);
+        m_pathRevision = revision;
+    }
+
+    return m_cachedPath;
 }
 
 QString VFile::retriveRelativePath() const
@@ -188,6 +232,17 @@ QString VFile::retriveImagePath() const
 void VFile::setContent(const QString &p_content)
 {
     m_content = p_content;
+    m_contentReleased = false;
+}
+
+void VFile::releaseContent()
+{
+    if (!m_opened) {
+        return;
+    }
+
+    m_content = QString();
+    m_contentReleased = true;
 }
 
 bool VFile::isModified() const
@@ -256,10 +311,12 @@ bool VFile::rename(const QString &p_name)
     }
 
     m_name = p_name;
+    VDirectory::invalidatePaths();
 
     // Update parent directory's config file.
     if (!dir->writeToConfig()) {
         m_name = oldName;
+        VDirectory::invalidatePaths();
         diskDir.rename(p_name, m_name);
         return false;
     }
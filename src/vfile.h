@@ -18,7 +18,14 @@ public:
     virtual ~VFile();
     virtual bool open();
     virtual void close();
+
+    // Queue the content to be written to disk in background.
+    // The result is reported by VFileSaver::fileSaved().
     virtual bool save();
+
+    // Block until the queued writes of this file finish.
+    // Returns false if the last one failed.
+    bool waitForSaved() const;
     // Convert current file type.
     virtual void convert(DocType p_curType, DocType p_targetType);
 
@@ -27,8 +34,14 @@ public:
     virtual VDirectory *getDirectory();
     virtual const VDirectory *getDirectory() const;
     DocType getDocType() const;
+
+    // Content will be read back from disk if it has been released.
     const QString &getContent() const;
     virtual void setContent(const QString &p_content);
+
+    // Drop the content while an editor holds the text, so there is only one
+    // copy of a large note in memory.
+    void releaseContent();
     virtual const VNotebook *getNotebook() const;
     virtual VNotebook *getNotebook();
     virtual QString getNotebookName() const;
@@ -76,10 +89,19 @@ protected:
     // File has been modified in editor
     bool m_modified;
     DocType m_docType;
-    QString m_content;
+
+    // Loaded lazily after released.
+    mutable QString m_content;
+    mutable bool m_contentReleased;
+
     FileType m_type;
     bool m_modifiable;
 
+private:
+    // Cached path, valid if m_pathRevision equals VDirectory::getPathRevision().
+    mutable QString m_cachedPath;
+    mutable int m_pathRevision;
+
     friend class VDirectory;
 };
 
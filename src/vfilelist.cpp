@@ -28,6 +28,10 @@ void VFileList::setupUI()
     fileList->setSelectionMode(QAbstractItemView::ExtendedSelection);
     fileList->setDragDropMode(QAbstractItemView::InternalMove);
     fileList->setObjectName("FileList");
+    // Lay out the items of a large folder in batches and do not query the
+    // size of every item.
+    fileList->setUniformItemSizes(true);
+    fileList->setLayoutMode(QListView::Batched);
 
     QVBoxLayout *mainLayout = new QVBoxLayout;
     mainLayout->addWidget(fileList);
@@ -108,11 +112,16 @@ void VFileList::updateFileList()
     if (!m_directory->open()) {
         return;
     }
+    // Add the items in bulk without repainting for each one.
+    fileList->setUpdatesEnabled(false);
     const QVector<VFile *> &files = m_directory->getFiles();
     for (int i = 0; i < files.size(); ++i) {
-        VFile *file = files[i];
-        insertFileListItem(file);
+        QListWidgetItem *item = new QListWidgetItem();
+        fillItem(item, files[i]);
+        fileList->addItem(item);
     }
+
+    fileList->setUpdatesEnabled(true);
 }
 
 void VFileList::fileInfo()
@@ -0,0 +1,132 @@
+#include "vfilesaver.h"
+
+#include <QSaveFile>
+#include <QTextStream>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QDebug>
+
+// Write one queued file.
+class VFileSaveRunnable : public QRunnable
+{
+public:
+    VFileSaveRunnable(VFileSaver *p_saver, const QString &p_path)
+        : m_saver(p_saver), m_path(p_path)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        m_saver->writeQueuedFile(m_path);
+    }
+
+private:
+    VFileSaver *m_saver;
+    QString m_path;
+};
+
+VFileSaver::VFileSaver(QObject *p_parent)
+    : QObject(p_parent)
+{
+    m_pool.setMaxThreadCount(1);
+    // Keep the thread to not start a new one for every save.
+    m_pool.setExpiryTimeout(-1);
+}
+
+VFileSaver::~VFileSaver()
+{
+    m_pool.waitForDone();
+}
+
+void VFileSaver::save(const QString &p_path, const QString &p_text)
+{
+    QMutexLocker locker(&m_mutex);
+    bool queued = m_queued.contains(p_path);
+
+    // QString is implicitly shared, so this does not copy the text.
+    m_queued.insert(p_path, p_text);
+    if (queued) {
+        qDebug() << "coalesce the save of" << p_path;
+        return;
+    }
+
+    m_pool.start(new VFileSaveRunnable(this, p_path));
+}
+
+bool VFileSaver::isPending(const QString &p_path) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queued.contains(p_path) || m_writing.contains(p_path);
+}
+
+bool VFileSaver::waitForFile(const QString &p_path)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queued.contains(p_path) || m_writing.contains(p_path)) {
+        m_written.wait(&m_mutex);
+    }
+
+    return m_results.value(p_path, true);
+}
+
+void VFileSaver::writeQueuedFile(const QString &p_path)
+{
+    QString text;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_queued.find(p_path);
+        if (it == m_queued.end()) {
+            return;
+        }
+
+        text = it.value();
+        m_queued.erase(it);
+        m_writing.insert(p_path);
+    }
+
+    bool ret = writeFileAtomically(p_path, text);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writing.remove(p_path);
+        m_results.insert(p_path, ret);
+        m_written.wakeAll();
+    }
+
+    QMetaObject::invokeMethod(this, "handleFileWritten", Qt::QueuedConnection,
+                              Q_ARG(QString, p_path),
+                              Q_ARG(bool, ret));
+}
+
+void VFileSaver::handleFileWritten(const QString &p_path, bool p_succeed)
+{
+    emit fileSaved(p_path, p_succeed);
+}
+
+bool VFileSaver::writeFileAtomically(const QString &p_path, const QString &p_text)
+{
+    // QSaveFile writes to a temporary file in the same directory, syncs it to
+    // disk and renames it over @p_path on commit.
+    QSaveFile file(p_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "fail to open file" << p_path << "to write" << file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream << p_text;
+    stream.flush();
+    if (stream.status() != QTextStream::Ok) {
+        qWarning() << "fail to write file" << p_path << file.errorString();
+        file.cancelWriting();
+        return false;
+    }
+
+    if (!file.commit()) {
+        qWarning() << "fail to commit file" << p_path << file.errorString();
+        return false;
+    }
+
+    qDebug() << "write file content:" << p_path;
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef VFILESAVER_H
+#define VFILESAVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+// Write notes to disk in a background thread so that saving a large note or
+// saving to a slow disk will not block the editor.
+// Each file is written to a temporary file, synced to disk, and then renamed
+// over the original one, so a crash during the saving will not corrupt the
+// note. Saves of the same file queued before it is written are coalesced into
+// the last one.
+class VFileSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VFileSaver(QObject *p_parent = 0);
+
+    // Wait for all the queued saves.
+    ~VFileSaver();
+
+    // Queue @p_text to be written to @p_path.
+    void save(const QString &p_path, const QString &p_text);
+
+    // Whether there is a save of @p_path queued or being written.
+    bool isPending(const QString &p_path) const;
+
+    // Block until all the saves of @p_path finish.
+    // Returns false if the last one failed.
+    bool waitForFile(const QString &p_path);
+
+    // Write @p_text to @p_path atomically. Thread-safe.
+    static bool writeFileAtomically(const QString &p_path, const QString &p_text);
+
+signals:
+    // Emitted when one save of @p_path finishes.
+    void fileSaved(const QString &p_path, bool p_succeed);
+
+private slots:
+    // Called in the GUI thread via queued invocation from the writer.
+    void handleFileWritten(const QString &p_path, bool p_succeed);
+
+private:
+    friend class VFileSaveRunnable;
+
+    // Take the queued text of @p_path and write it. Called in the writer thread.
+    void writeQueuedFile(const QString &p_path);
+
+    mutable QMutex m_mutex;
+
+    // Signalled when a file is written.
+    QWaitCondition m_written;
+
+    // Path -> text queued but not written yet.
+    QHash<QString, QString> m_queued;
+
+    // Paths being written.
+    QSet<QString> m_writing;
+
+    // Path -> whether the last save succeeded.
+    QHash<QString, bool> m_results;
+
+    // One writer thread keeps saves of the same file in order.
+    QThreadPool m_pool;
+};
+
+#endif // VFILESAVER_H
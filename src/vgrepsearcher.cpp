@@ -0,0 +1,522 @@
+#include "vgrepsearcher.h"
+
+#include <QFile>
+#include <QDir>
+#include <QByteArray>
+#include <QByteArrayMatcher>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QThread>
+#include <QDebug>
+#include <climits>
+
+#include "vdirectory.h"
+
+// Stop searching after so many matches.
+static const int c_maxMatchCount = 10000;
+
+// Max length of the line text of a match.
+static const int c_maxLineLength = 200;
+
+// State shared by the workers of one search.
+struct VGrepJob
+{
+    VGrepJob() : m_id(0), m_regExp(false), m_caseSensitive(false),
+                 m_next(0), m_cancelled(0), m_remaining(0),
+                 m_fileCount(0), m_matchCount(0)
+    {
+    }
+
+    int m_id;
+
+    QStringList m_notes;
+
+    QString m_pattern;
+    bool m_regExp;
+    bool m_caseSensitive;
+
+    // UTF-8 literal which must appear in a file to match.
+    // Lower case if not case sensitive.
+    QByteArray m_literal;
+
+    // Index of the next note to search.
+    QAtomicInt m_next;
+
+    QAtomicInt m_cancelled;
+
+    // Number of workers not finished yet.
+    QAtomicInt m_remaining;
+
+    QAtomicInt m_fileCount;
+    QAtomicInt m_matchCount;
+};
+
+// Whether @p_data contains @p_literal ignoring ASCII case.
+// @p_literal is lower case.
+static bool containsIgnoreCase(const char *p_data, int p_size, const QByteArray &p_literal)
+{
+    int litSize = p_literal.size();
+    const char *lit = p_literal.constData();
+    char first = lit[0];
+    char firstUpper = (first >= 'a' && first <= 'z') ? first - 'a' + 'A' : first;
+    for (int i = 0; i <= p_size - litSize; ++i) {
+        if (p_data[i] != first && p_data[i] != firstUpper) {
+            continue;
+        }
+
+        int j = 1;
+        for (; j < litSize; ++j) {
+            char ch = p_data[i + j];
+            if (ch >= 'A' && ch <= 'Z') {
+                ch = ch - 'A' + 'a';
+            }
+
+            if (ch != lit[j]) {
+                break;
+            }
+        }
+
+        if (j == litSize) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool isAscii(const QString &p_str)
+{
+    for (int i = 0; i < p_str.size(); ++i) {
+        if (p_str[i].unicode() > 0x7f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Search notes of a job one by one until all the notes are taken.
+class VGrepRunnable : public QRunnable
+{
+public:
+    VGrepRunnable(VGrepSearcher *p_searcher, const QSharedPointer<VGrepJob> &p_job)
+        : m_searcher(p_searcher), m_job(p_job)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    // Search note @p_path and append matches to @p_matches.
+    void searchFile(const QString &p_path, QVector<VGrepMatch> &p_matches);
+
+    // Whether the raw content may contain a match.
+    bool prefilter(const char *p_data, int p_size) const;
+
+    void searchText(const QString &p_path,
+                    const QString &p_text,
+                    QVector<VGrepMatch> &p_matches);
+
+    VGrepSearcher *m_searcher;
+    QSharedPointer<VGrepJob> m_job;
+    QRegularExpression m_regExp;
+};
+
+void VGrepRunnable::run()
+{
+    if (m_job->m_regExp) {
+        QRegularExpression::PatternOptions opts = QRegularExpression::MultilineOption;
+        if (!m_job->m_caseSensitive) {
+            opts |= QRegularExpression::CaseInsensitiveOption;
+        }
+
+        m_regExp = QRegularExpression(m_job->m_pattern, opts);
+    }
+
+    int fileCount = 0;
+    while (!m_job->m_cancelled.load()) {
+        int idx = m_job->m_next.fetchAndAddOrdered(1);
+        if (idx >= m_job->m_notes.size()) {
+            break;
+        }
+
+        QVector<VGrepMatch> matches;
+        searchFile(m_job->m_notes[idx], matches);
+        ++fileCount;
+        if (matches.isEmpty()) {
+            continue;
+        }
+
+        int total = m_job->m_matchCount.fetchAndAddOrdered(matches.size()) + matches.size();
+        if (total >= c_maxMatchCount) {
+            m_job->m_cancelled.store(1);
+        }
+
+        QMetaObject::invokeMethod(m_searcher, "handleMatches", Qt::QueuedConnection,
+                                  Q_ARG(int, m_job->m_id),
+                                  Q_ARG(QVector<VGrepMatch>, matches));
+    }
+
+    m_job->m_fileCount.fetchAndAddOrdered(fileCount);
+
+    // The last worker reports the end of the search.
+    if (m_job->m_remaining.fetchAndAddOrdered(-1) == 1) {
+        QMetaObject::invokeMethod(m_searcher, "handleJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_job->m_id),
+                                  Q_ARG(int, m_job->m_fileCount.load()),
+                                  Q_ARG(int, m_job->m_matchCount.load()));
+    }
+}
+
+void VGrepRunnable::searchFile(const QString &p_path, QVector<VGrepMatch> &p_matches)
+{
+    QFile file(p_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "fail to open file" << p_path << "to search";
+        return;
+    }
+
+    qint64 size = file.size();
+    if (size <= 0 || size > INT_MAX) {
+        return;
+    }
+
+    // Map the file to avoid copying it. Fall back to reading it if mapping
+    // is not supported.
+    QByteArray buf;
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        buf = file.readAll();
+        data = buf.constData();
+        size = buf.size();
+    }
+
+    if (!prefilter(data, size)) {
+        return;
+    }
+
+    searchText(p_path, QString::fromUtf8(data, size), p_matches);
+}
+
+bool VGrepRunnable::prefilter(const char *p_data, int p_size) const
+{
+    const QByteArray &literal = m_job->m_literal;
+    if (literal.isEmpty()) {
+        return true;
+    }
+
+    if (m_job->m_caseSensitive) {
+        QByteArrayMatcher matcher(literal);
+        return matcher.indexIn(p_data, p_size) != -1;
+    } else {
+        return containsIgnoreCase(p_data, p_size, literal);
+    }
+}
+
+void VGrepRunnable::searchText(const QString &p_path,
+                               const QString &p_text,
+                               QVector<VGrepMatch> &p_matches)
+{
+    Qt::CaseSensitivity cs = m_job->m_caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    int lineNumber = 1;
+    int lineStart = 0;
+    int pos = 0;
+    while (pos <= p_text.size()) {
+        int idx = -1;
+        if (m_job->m_regExp) {
+            QRegularExpressionMatch match = m_regExp.match(p_text, pos);
+            if (match.hasMatch()) {
+                idx = match.capturedStart();
+            }
+        } else {
+            idx = p_text.indexOf(m_job->m_pattern, pos, cs);
+        }
+
+        if (idx == -1) {
+            break;
+        }
+
+        // Advance the line number to the line of the match.
+        int nl = p_text.indexOf('\n', lineStart);
+        while (nl != -1 && nl < idx) {
+            ++lineNumber;
+            lineStart = nl + 1;
+            nl = p_text.indexOf('\n', lineStart);
+        }
+
+        int lineEnd = nl == -1 ? p_text.size() : nl;
+
+        VGrepMatch match;
+        match.m_path = p_path;
+        match.m_lineNumber = lineNumber;
+        match.m_lineText = p_text.mid(lineStart, qMin(lineEnd - lineStart, c_maxLineLength)).trimmed();
+        p_matches.append(match);
+
+        // One match per line.
+        if (nl == -1) {
+            break;
+        }
+
+        ++lineNumber;
+        lineStart = pos = nl + 1;
+    }
+}
+
+VGrepSearcher::VGrepSearcher(QObject *p_parent)
+    : QObject(p_parent), m_jobId(0)
+{
+    qRegisterMetaType<QVector<VGrepMatch>>();
+
+    // Reading files is mostly I/O bound, so it does not help much to use
+    // too many threads.
+    m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+}
+
+VGrepSearcher::~VGrepSearcher()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool VGrepSearcher::start(const QStringList &p_notes,
+                          const QString &p_pattern,
+                          bool p_regExp,
+                          bool p_caseSensitive)
+{
+    cancel();
+
+    if (p_pattern.isEmpty()) {
+        return false;
+    }
+
+    QString literal;
+    if (p_regExp) {
+        QRegularExpression reg(p_pattern);
+        if (!reg.isValid()) {
+            qWarning() << "invalid regular expression" << p_pattern << reg.errorString();
+            return false;
+        }
+
+        literal = requiredLiteral(p_pattern);
+    } else {
+        literal = p_pattern;
+    }
+
+    QSharedPointer<VGrepJob> job(new VGrepJob());
+    job->m_id = ++m_jobId;
+    job->m_notes = p_notes;
+    job->m_pattern = p_pattern;
+    job->m_regExp = p_regExp;
+    job->m_caseSensitive = p_caseSensitive;
+
+    // Only ASCII case folding is done on the raw bytes.
+    if (p_caseSensitive) {
+        job->m_literal = literal.toUtf8();
+    } else if (isAscii(literal)) {
+        job->m_literal = literal.toLower().toUtf8();
+    }
+
+    int nrWorkers = qMax(1, qMin(m_pool.maxThreadCount(), p_notes.size()));
+    job->m_remaining.store(nrWorkers);
+    m_job = job;
+
+    for (int i = 0; i < nrWorkers; ++i) {
+        m_pool.start(new VGrepRunnable(this, job));
+    }
+
+    return true;
+}
+
+void VGrepSearcher::cancel()
+{
+    if (m_job) {
+        m_job->m_cancelled.store(1);
+        m_job.clear();
+    }
+}
+
+bool VGrepSearcher::isRunning() const
+{
+    return !m_job.isNull();
+}
+
+void VGrepSearcher::handleMatches(int p_jobId, const QVector<VGrepMatch> &p_matches)
+{
+    if (p_jobId != m_jobId || !m_job) {
+        return;
+    }
+
+    emit matchesFound(p_matches);
+}
+
+void VGrepSearcher::handleJobFinished(int p_jobId, int p_fileCount, int p_matchCount)
+{
+    if (p_jobId != m_jobId || !m_job) {
+        return;
+    }
+
+    m_job.clear();
+    emit finished(p_fileCount, p_matchCount);
+}
+
+void VGrepSearcher::collectNotes(VDirectory *p_dir, QStringList &p_notes)
+{
+    if (!p_dir->open()) {
+        qWarning() << "fail to open directory" << p_dir->getName();
+        return;
+    }
+
+    // Use the names to not create VFile objects of all the notes.
+    QDir dir(p_dir->retrivePath());
+    for (auto const &name : p_dir->getFileNames()) {
+        p_notes.append(dir.filePath(name));
+    }
+
+    for (auto const &dir : p_dir->getSubDirs()) {
+        collectNotes(dir, p_notes);
+    }
+}
+
+// Skip the character class starting at @p_idx, which is the index of '['.
+// Returns the index of the closing ']', or the size of @p_pattern if not closed.
+static int skipCharClass(const QString &p_pattern, int p_idx)
+{
+    int i = p_idx + 1;
+    if (i < p_pattern.size() && p_pattern[i] == '^') {
+        ++i;
+    }
+
+    // A leading ']' is part of the class.
+    if (i < p_pattern.size() && p_pattern[i] == ']') {
+        ++i;
+    }
+
+    while (i < p_pattern.size() && p_pattern[i] != ']') {
+        if (p_pattern[i] == '\\') {
+            ++i;
+        } else if (p_pattern.midRef(i, 2) == "[:") {
+            // POSIX class like [:alpha:].
+            int end = p_pattern.indexOf(":]", i + 2);
+            if (end != -1) {
+                i = end + 1;
+            }
+        }
+
+        ++i;
+    }
+
+    return qMin(i, p_pattern.size());
+}
+
+QString VGrepSearcher::requiredLiteral(const QString &p_pattern)
+{
+    // Alternations and special groups may make any literal optional.
+    if (p_pattern.contains('|') || p_pattern.contains("(?")) {
+        return QString();
+    }
+
+    // Escapes taking arguments or denoting other characters.
+    static const QString argEscapes("xuopPNcgkQE0123456789");
+
+    QString best;
+    QString run;
+    int depth = 0;
+    auto endRun = [&best, &run]() {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+
+        run.clear();
+    };
+
+    // Drop the last character of current run since it is optional.
+    auto dropLast = [&run]() {
+        if (!run.isEmpty()) {
+            run.chop(1);
+            if (!run.isEmpty() && run[run.size() - 1].isHighSurrogate()) {
+                run.chop(1);
+            }
+        }
+    };
+
+    for (int i = 0; i < p_pattern.size(); ++i) {
+        QChar ch = p_pattern[i];
+        if (depth > 0) {
+            if (ch == '\\') {
+                ++i;
+            } else if (ch == '[') {
+                // A ')' in the class does not close the group.
+                i = skipCharClass(p_pattern, i);
+            } else if (ch == '(') {
+                ++depth;
+            } else if (ch == ')') {
+                --depth;
+            }
+
+            continue;
+        }
+
+        switch (ch.unicode()) {
+        case '\\':
+            if (i + 1 >= p_pattern.size()) {
+                return QString();
+            }
+
+            ++i;
+            if (argEscapes.contains(p_pattern[i])) {
+                return QString();
+            } else if (p_pattern[i].isLetterOrNumber()) {
+                // Character classes and assertions.
+                endRun();
+            } else {
+                run.append(p_pattern[i]);
+            }
+
+            break;
+
+        case '?':
+        case '*':
+            dropLast();
+            endRun();
+            break;
+
+        case '{':
+            dropLast();
+            endRun();
+            while (i < p_pattern.size() && p_pattern[i] != '}') {
+                ++i;
+            }
+
+            break;
+
+        case '+':
+            endRun();
+            break;
+
+        case '[':
+            endRun();
+            i = skipCharClass(p_pattern, i);
+            break;
+
+        case '(':
+            endRun();
+            ++depth;
+            break;
+
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+            endRun();
+            break;
+
+        default:
+            run.append(ch);
+            break;
+        }
+    }
+
+    endRun();
+    return best;
+}
@@ -0,0 +1,86 @@
+#ifndef VGREPSEARCHER_H
+#define VGREPSEARCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QMetaType>
+
+class VDirectory;
+
+// A line matched in a note.
+struct VGrepMatch
+{
+    VGrepMatch() : m_lineNumber(0)
+    {
+    }
+
+    QString m_path;
+
+    // Based on 1.
+    int m_lineNumber;
+
+    QString m_lineText;
+};
+
+Q_DECLARE_METATYPE(VGrepMatch)
+
+struct VGrepJob;
+
+// Search raw note files for a literal or regular expression pattern in
+// parallel, like grep.
+// Files are memory mapped and checked by a literal prefilter before being
+// decoded and matched. Matches are streamed back as they are found.
+class VGrepSearcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VGrepSearcher(QObject *p_parent = 0);
+
+    ~VGrepSearcher();
+
+    // Start to search @p_notes for @p_pattern in the background.
+    // Current search will be cancelled.
+    // Returns false if @p_pattern is invalid.
+    bool start(const QStringList &p_notes,
+               const QString &p_pattern,
+               bool p_regExp,
+               bool p_caseSensitive);
+
+    void cancel();
+
+    bool isRunning() const;
+
+    // Collect the paths of all the notes in @p_dir recursively.
+    // Will open the directories which are not opened yet.
+    static void collectNotes(VDirectory *p_dir, QStringList &p_notes);
+
+    // Get a literal which must appear in any match of regular expression
+    // @p_pattern. Returns empty if not sure.
+    static QString requiredLiteral(const QString &p_pattern);
+
+signals:
+    void matchesFound(const QVector<VGrepMatch> &p_matches);
+
+    // @p_fileCount: number of files searched.
+    void finished(int p_fileCount, int p_matchCount);
+
+private slots:
+    // Called in the GUI thread via queued invocation from the workers.
+    void handleMatches(int p_jobId, const QVector<VGrepMatch> &p_matches);
+
+    void handleJobFinished(int p_jobId, int p_fileCount, int p_matchCount);
+
+private:
+    QThreadPool m_pool;
+
+    QSharedPointer<VGrepJob> m_job;
+
+    // Id of current job. Results of previous jobs are dropped.
+    int m_jobId;
+};
+
+#endif // VGREPSEARCHER_H
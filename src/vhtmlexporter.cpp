@@ -0,0 +1,386 @@
+#include "vhtmlexporter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QDebug>
+
+#include "utils/vutils.h"
+#include "vconfigmanager.h"
+#include "vconstants.h"
+#include "vfile.h"
+#include "vmarkdownconverter.h"
+#include "vbatchexporter.h"
+
+extern VConfigManager *g_config;
+
+static const QString c_markdownTemplatePath(":/resources/markdown_template.html");
+
+static const QString c_titleHolder("<!-- TITLE_PLACE_HOLDER -->");
+
+static const QString c_bodyHolder("<div id=\"placeholder\"></div>");
+
+// Interval to report the progress while waiting for the export threads.
+static const int c_pollInterval = 100;
+
+VHtmlExporter::VHtmlExporter(QObject *p_parent)
+    : QObject(p_parent), m_workerCount(qMax(1, QThread::idealThreadCount())),
+      m_skippedCount(0)
+{
+    initHtmlTemplate();
+}
+
+// Replace the first match of @p_regExp in @p_text with @p_after literally.
+static void replaceFirst(QString &p_text, const QRegularExpression &p_regExp,
+                         const QString &p_after)
+{
+    QRegularExpressionMatch match = p_regExp.match(p_text);
+    if (match.hasMatch()) {
+        p_text.replace(match.capturedStart(), match.capturedLength(), p_after);
+    }
+}
+
+static QString readTemplateCss()
+{
+    QString cssUrl = g_config->getTemplateCssUrl();
+    QString cssPath;
+    if (cssUrl.startsWith("qrc")) {
+        cssPath = cssUrl.mid(3);
+    } else {
+        cssPath = QUrl(cssUrl).toLocalFile();
+    }
+
+    return VUtils::readFileFromDisk(cssPath);
+}
+
+void VHtmlExporter::initHtmlTemplate()
+{
+    m_htmlTemplate = VUtils::readFileFromDisk(c_markdownTemplatePath);
+
+    // Inline the template CSS so that the HTML file is standalone.
+    replaceFirst(m_htmlTemplate,
+                 QRegularExpression("<link [^>]*href=\"CSS_PLACE_HOLDER\"[^>]*>"),
+                 "<style type=\"text/css\">\n" + readTemplateCss() + "\n</style>");
+
+    // Remove links and scripts referring to the resources of VNote.
+    m_htmlTemplate.remove(QRegularExpression("<link [^>]*href=\"qrc:[^>]*>\\s*"));
+    m_htmlTemplate.remove(QRegularExpression("<script [^>]*>\\s*</script>\\s*"));
+    m_htmlTemplate.remove(c_htmlExtraHolder);
+
+    QString cssStyle;
+    if (g_config->getEnableImageConstraint()) {
+        cssStyle += "img { max-width: 100% !important; height: auto !important; }\n";
+    }
+
+    m_htmlTemplate.replace("<!-- BACKGROUND_PLACE_HOLDER -->", cssStyle);
+
+    m_htmlTemplate.replace("<head>", "<head>\n    <title>" + c_titleHolder + "</title>");
+}
+
+QString VHtmlExporter::generateHtml(const QString &p_body, const QString &p_title) const
+{
+    QString html = m_htmlTemplate;
+    html.replace(c_titleHolder, p_title.toHtmlEscaped());
+    html.replace(c_bodyHolder, "<div id=\"placeholder\">\n" + p_body + "\n</div>");
+    return html;
+}
+
+bool VHtmlExporter::exportNote(VFile *p_file, const QString &p_filePath)
+{
+    bool isOpened = p_file->isOpened();
+    if (!isOpened && !p_file->open()) {
+        return false;
+    }
+
+    QString content = p_file->getContent();
+    if (!isOpened) {
+        p_file->close();
+    }
+
+    return exportContent(content,
+                         p_file->retriveBasePath(),
+                         QFileInfo(p_file->getName()).completeBaseName(),
+                         p_filePath);
+}
+
+bool VHtmlExporter::exportContent(const QString &p_content,
+                                  const QString &p_basePath,
+                                  const QString &p_title,
+                                  const QString &p_filePath) const
+{
+    VMarkdownConverter mdConverter;
+    QString toc;
+    QString body = mdConverter.generateHtml(p_content,
+                                            g_config->getMarkdownExtensions(),
+                                            toc);
+
+    if (!VUtils::makePath(VUtils::basePathFromPath(p_filePath))) {
+        qWarning() << "fail to create directory for" << p_filePath;
+        return false;
+    }
+
+    bool ret = copyLocalImages(body, p_basePath, p_filePath);
+
+    QString html = generateHtml(body, p_title);
+    if (!VBatchExporter::writeTargetFile(p_filePath, html.toUtf8())) {
+        qWarning() << "fail to write file" << p_filePath;
+        return false;
+    }
+
+    return ret;
+}
+
+// A note to export in an export thread.
+struct VHtmlExportJob
+{
+    VHtmlExportJob() : m_idx(-1), m_isOpened(false)
+    {
+    }
+
+    // Index of the task.
+    int m_idx;
+
+    QString m_notePath;
+
+    // Content of an opened note, which may differ from the file.
+    bool m_isOpened;
+    QString m_content;
+
+    QString m_basePath;
+    QString m_title;
+    QString m_filePath;
+};
+
+// Shared by the export threads and the thread waiting for them.
+struct VHtmlExportResults
+{
+    QMutex m_mutex;
+
+    // Index of the task finished but not reported yet -> whether it succeeded.
+    QVector<QPair<int, bool>> m_finished;
+};
+
+class VHtmlExportRunnable : public QRunnable
+{
+public:
+    VHtmlExportRunnable(const VHtmlExporter *p_exporter,
+                        const VHtmlExportJob &p_job,
+                        VHtmlExportResults *p_results)
+        : m_exporter(p_exporter), m_job(p_job), m_results(p_results)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        bool ok = false;
+        if (m_job.m_isOpened) {
+            ok = m_exporter->exportContent(m_job.m_content, m_job.m_basePath,
+                                           m_job.m_title, m_job.m_filePath);
+        } else if (QFileInfo(m_job.m_notePath).isFile()) {
+            ok = m_exporter->exportContent(VUtils::readFileFromDisk(m_job.m_notePath),
+                                           m_job.m_basePath,
+                                           m_job.m_title,
+                                           m_job.m_filePath);
+        }
+
+        QMutexLocker locker(&m_results->m_mutex);
+        m_results->m_finished.append(qMakePair(m_job.m_idx, ok));
+    }
+
+private:
+    const VHtmlExporter *m_exporter;
+    VHtmlExportJob m_job;
+    VHtmlExportResults *m_results;
+};
+
+int VHtmlExporter::exportNotes(const QVector<VExportTask> &p_tasks, bool p_skipUpToDate)
+{
+    m_skippedCount = 0;
+    m_failedNotes.clear();
+
+    int total = p_tasks.size();
+    int done = 0;
+    int exportedNum = 0;
+
+    VHtmlExportResults results;
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_workerCount);
+    for (int i = 0; i < total; ++i) {
+        const VExportTask &task = p_tasks[i];
+        if (p_skipUpToDate && VBatchExporter::isUpToDate(task)) {
+            ++m_skippedCount;
+            ++done;
+            emit progressChanged(done, total, task.m_file->getName());
+            continue;
+        }
+
+        // VFile is accessed only in this thread.
+        VHtmlExportJob job;
+        job.m_idx = i;
+        job.m_notePath = task.m_file->retrivePath();
+        job.m_isOpened = task.m_file->isOpened();
+        if (job.m_isOpened) {
+            job.m_content = task.m_file->getContent();
+        }
+
+        job.m_basePath = task.m_file->retriveBasePath();
+        job.m_title = QFileInfo(task.m_file->getName()).completeBaseName();
+        job.m_filePath = task.m_filePath;
+        pool.start(new VHtmlExportRunnable(this, job, &results));
+    }
+
+    // Report the progress in this thread while waiting.
+    bool allDone = false;
+    while (!allDone) {
+        allDone = pool.waitForDone(c_pollInterval);
+
+        QVector<QPair<int, bool>> finished;
+        {
+            QMutexLocker locker(&results.m_mutex);
+            finished.swap(results.m_finished);
+        }
+
+        for (auto const &res : finished) {
+            const VExportTask &task = p_tasks[res.first];
+            if (res.second) {
+                ++exportedNum;
+            } else {
+                qWarning() << "fail to export note" << task.m_file->retrivePath();
+                m_failedNotes.append(task.m_file->retrivePath());
+            }
+
+            ++done;
+            emit progressChanged(done, total, task.m_file->getName());
+        }
+    }
+
+    return exportedNum;
+}
+
+// Return the local file path of image @p_src, or empty if it is not local.
+static QString localImagePath(const QString &p_src, const QString &p_basePath)
+{
+    // HTML escape in attribute.
+    QString src = p_src;
+    src.replace("&amp;", "&");
+
+    QUrl url(src);
+    QString scheme = url.scheme();
+    if (scheme == "file") {
+        return url.toLocalFile();
+    } else if (!scheme.isEmpty()
+               && !(scheme.size() == 1 && QDir::isAbsolutePath(src))) {
+        // Remote, resource or data URL. Single letter scheme is a Windows drive.
+        return QString();
+    }
+
+    QString path = QUrl::fromPercentEncoding(src.toUtf8());
+    if (QDir::isRelativePath(path)) {
+        path = QDir(p_basePath).filePath(path);
+    }
+
+    return QDir::cleanPath(path);
+}
+
+// Append a sequence to file name @p_name which is not in @p_usedNames.
+static QString nameWithSequence(const QString &p_name,
+                                const QHash<QString, QString> &p_usedNames)
+{
+    QFileInfo fi(p_name);
+    QString baseName = fi.baseName();
+    QString suffix = fi.completeSuffix();
+    int seq = 1;
+    QString name;
+    do {
+        name = QString("%1_%2").arg(baseName).arg(QString::number(seq++), 3, '0');
+        if (!suffix.isEmpty()) {
+            name = name + "." + suffix;
+        }
+    } while (p_usedNames.contains(name));
+
+    return name;
+}
+
+bool VHtmlExporter::copyLocalImages(QString &p_html,
+                                    const QString &p_basePath,
+                                    const QString &p_filePath)
+{
+    QRegularExpression imgExp("<img\\s[^>]*src=\"([^\"]+)\"",
+                              QRegularExpression::CaseInsensitiveOption);
+
+    QFileInfo fileInfo(p_filePath);
+    QString folderName = fileInfo.completeBaseName() + "_files";
+    QDir folder(QDir(fileInfo.absolutePath()).filePath(folderName));
+
+    bool ret = true;
+
+    // Source image path -> new link.
+    QHash<QString, QString> copiedImages;
+
+    // Image file name -> source image path.
+    QHash<QString, QString> usedNames;
+
+    // Replace from the end so the positions of the previous matches are valid.
+    QVector<QRegularExpressionMatch> matches;
+    QRegularExpressionMatchIterator it = imgExp.globalMatch(p_html);
+    while (it.hasNext()) {
+        matches.append(it.next());
+    }
+
+    for (int i = matches.size() - 1; i >= 0; --i) {
+        const QRegularExpressionMatch &match = matches[i];
+        QString imagePath = localImagePath(match.captured(1), p_basePath);
+        if (imagePath.isEmpty()) {
+            continue;
+        }
+
+        if (!QFileInfo(imagePath).isFile()) {
+            qWarning() << "image does not exist" << imagePath;
+            continue;
+        }
+
+        auto copiedIt = copiedImages.find(imagePath);
+        if (copiedIt == copiedImages.end()) {
+            if (!folder.exists() && !VUtils::makePath(folder.absolutePath())) {
+                qWarning() << "fail to create image folder" << folder.absolutePath();
+                return false;
+            }
+
+            // Use a sequence to avoid conflicts of images with the same name.
+            // It depends only on the images of this note, so exporting again
+            // overwrites the images exported last time instead of adding copies.
+            QString name = VUtils::fileNameFromPath(imagePath);
+            if (usedNames.contains(name)) {
+                name = nameWithSequence(name, usedNames);
+            }
+
+            QString destPath = folder.filePath(name);
+            if (QFileInfo::exists(destPath)) {
+                // Image exported last time.
+                QFile::remove(destPath);
+            }
+
+            if (!QFile::copy(imagePath, destPath)) {
+                qWarning() << "fail to copy image" << imagePath << "to" << destPath;
+                ret = false;
+                continue;
+            }
+
+            usedNames.insert(name, imagePath);
+            QString link = QString::fromUtf8(QUrl::toPercentEncoding(folderName)) + "/"
+                           + QString::fromUtf8(QUrl::toPercentEncoding(name));
+            copiedIt = copiedImages.insert(imagePath, link);
+        }
+
+        p_html.replace(match.capturedStart(1), match.capturedLength(1), copiedIt.value());
+    }
+
+    return ret;
+}
@@ -0,0 +1,94 @@
+#ifndef VHTMLEXPORTER_H
+#define VHTMLEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+class VFile;
+struct VExportTask;
+
+// Export Markdown notes as standalone HTML files natively via Hoedown
+// without QWebEngine, so it could run without GUI.
+// Local images referenced by a note will be copied to a folder named
+// "<note name>_files" besides the target HTML file.
+class VHtmlExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VHtmlExporter(QObject *p_parent = 0);
+
+    // Export @p_file to @p_filePath.
+    bool exportNote(VFile *p_file, const QString &p_filePath);
+
+    // Export all the notes in @p_tasks in a pool of threads.
+    // Skip notes whose target file is newer than the note itself if
+    // @p_skipUpToDate is true.
+    // Will return until all the notes are exported.
+    // Returns the number of notes exported.
+    int exportNotes(const QVector<VExportTask> &p_tasks, bool p_skipUpToDate);
+
+    // Number of threads used by exportNotes().
+    void setWorkerCount(int p_count);
+
+    // Number of notes skipped in last exportNotes().
+    int getSkippedCount() const;
+
+    // Paths of notes failed to export in last exportNotes().
+    const QStringList &getFailedNotes() const;
+
+    // Wrap @p_body into the standalone HTML template.
+    QString generateHtml(const QString &p_body, const QString &p_title) const;
+
+    // Copy local images referenced by @p_html to the images folder of
+    // @p_filePath and update the links in @p_html.
+    // @p_basePath: the base path to resolve relative image links.
+    // Returns false if any image fails to be copied.
+    static bool copyLocalImages(QString &p_html,
+                                const QString &p_basePath,
+                                const QString &p_filePath);
+
+    // Convert Markdown @p_content of a note to the standalone HTML file
+    // @p_filePath. Thread-safe.
+    // @p_basePath: the folder of the note.
+    bool exportContent(const QString &p_content,
+                       const QString &p_basePath,
+                       const QString &p_title,
+                       const QString &p_filePath) const;
+
+signals:
+    // Emitted in the thread calling exportNotes().
+    // @p_done: number of notes finished, including skipped and failed ones.
+    void progressChanged(int p_done, int p_total, const QString &p_name);
+
+private:
+    // Generate the template from markdown_template.html with styles inlined
+    // and scripts removed.
+    void initHtmlTemplate();
+
+    QString m_htmlTemplate;
+
+    int m_workerCount;
+
+    int m_skippedCount;
+    QStringList m_failedNotes;
+};
+
+inline void VHtmlExporter::setWorkerCount(int p_count)
+{
+    m_workerCount = qMax(1, p_count);
+}
+
+inline int VHtmlExporter::getSkippedCount() const
+{
+    return m_skippedCount;
+}
+
+inline const QStringList &VHtmlExporter::getFailedNotes() const
+{
+    return m_failedNotes;
+}
+
+#endif // VHTMLEXPORTER_H
@@ -41,6 +41,8 @@ void VHtmlTab::setupUI()
             this, &VHtmlTab::editFile);
     connect(m_editor, &VEdit::statusMessage,
             this, &VEditTab::statusMessage);
+    connect(m_editor, &VEdit::matchCountUpdated,
+            this, &VEditTab::matchCountUpdated);
     connect(m_editor, &VEdit::vimStatusUpdated,
             this, &VEditTab::vimStatusUpdated);
 
@@ -126,7 +128,12 @@ void VHtmlTab::readFile()
                                       QMessageBox::Save, this);
         switch (ret) {
         case QMessageBox::Save:
-            saveFile();
+            // Keep editing if the note is not written, which will be warned
+            // by handleFileSaved().
+            if (!saveFile() || !m_file->waitForSaved()) {
+                return;
+            }
+
             // Fall through
 
         case QMessageBox::Discard:
@@ -156,7 +163,6 @@ bool VHtmlTab::saveFile()
         return true;
     }
 
-    bool ret;
     // Make sure the file already exists. Temporary deal with cases when user delete or move
     // a file.
     QString filePath = m_file->retrivePath();
@@ -169,23 +175,32 @@ bool VHtmlTab::saveFile()
         return false;
     }
 
+    // The content is written in background and the result is reported
+    // to handleFileSaved().
     m_editor->saveFile();
-    ret = m_file->save();
-    if (!ret) {
-        VUtils::showMessage(QMessageBox::Warning, tr("Warning"), tr("Fail to save note."),
-                            tr("Fail to write to disk when saving a note. Please try it again."),
-                            QMessageBox::Ok, QMessageBox::Ok, this);
-        m_editor->setModified(true);
-    }
+    m_file->save();
 
     updateStatus();
 
-    return ret;
+    return true;
+}
+
+void VHtmlTab::handleFileSaved(bool p_succeed)
+{
+    VEditTab::handleFileSaved(p_succeed);
+
+    if (!p_succeed && m_editor) {
+        m_editor->setModified(true);
+        updateStatus();
+    }
 }
 
 void VHtmlTab::saveAndRead()
 {
-    saveFile();
+    if (!saveFile() || !m_file->waitForSaved()) {
+        return;
+    }
+
     readFile();
 }
 
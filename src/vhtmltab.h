@@ -78,6 +78,9 @@ private:
     // Focus the proper child widget.
     void focusChild() Q_DECL_OVERRIDE;
 
+    // Mark the note modified again if it failed to be written.
+    void handleFileSaved(bool p_succeed) Q_DECL_OVERRIDE;
+
     VEdit *m_editor;
 };
 #endif // VHTMLTAB_H
@@ -11,9 +11,12 @@
 #include "utils/vutils.h"
 #include "veditarea.h"
 #include "voutline.h"
+#include "vsearchpanel.h"
+#include "vsearchindexer.h"
 #include "vnotebookselector.h"
 #include "vavatar.h"
 #include "dialog/vfindreplacedialog.h"
+#include "dialog/vfindinnotebookdialog.h"
 #include "dialog/vsettingsdialog.h"
 #include "vcaptain.h"
 #include "vedittab.h"
@@ -26,6 +29,7 @@
 #include "vorphanfile.h"
 #include "dialog/vorphanfileinfodialog.h"
 #include "vsingleinstanceguard.h"
+#include "veditjournal.h"
 
 extern VConfigManager *g_config;
 
@@ -38,7 +42,7 @@ extern QFile g_logFile;
 #endif
 
 VMainWindow::VMainWindow(VSingleInstanceGuard *p_guard, QWidget *p_parent)
-    : QMainWindow(p_parent), m_onePanel(false), m_guard(p_guard),
+    : QMainWindow(p_parent), m_findInNotebookDialog(NULL), m_onePanel(false), m_guard(p_guard),
       m_windowOldState(Qt::WindowNoState), m_requestQuit(false)
 {
     setWindowIcon(QIcon(":/resources/icons/vnote.ico"));
@@ -62,6 +66,11 @@ VMainWindow::VMainWindow(VSingleInstanceGuard *p_guard, QWidget *p_parent)
     initCaptain();
 
     initSharedMemoryWatcher();
+
+    vnote->getSearchIndexer()->start();
+
+    // Prompt after the main window is shown.
+    QTimer::singleShot(0, this, &VMainWindow::recoverJournals);
 }
 
 void VMainWindow::initSharedMemoryWatcher()
@@ -824,6 +833,14 @@ void VMainWindow::initEditMenu()
     connect(m_replaceFindAct, SIGNAL(triggered(bool)),
             m_findReplaceDialog, SLOT(replaceFind()));
 
+    m_findInNotebookAct = new QAction(tr("Find In Notebook"), this);
+    m_findInNotebookAct->setToolTip(tr("Search the notes of notebooks for text or regular expression"));
+    keySeq = g_config->getShortcutKeySequence("FindInNotebook");
+    qDebug() << "set FindInNotebook shortcut to" << keySeq;
+    m_findInNotebookAct->setShortcut(QKeySequence(keySeq));
+    connect(m_findInNotebookAct, &QAction::triggered,
+            this, &VMainWindow::openFindInNotebookDialog);
+
     m_replaceAllAct = new QAction(tr("Replace All"), this);
     m_replaceAllAct->setToolTip(tr("Replace all occurences in current note"));
     connect(m_replaceAllAct, SIGNAL(triggered(bool)),
@@ -923,6 +940,8 @@ void VMainWindow::initEditMenu()
     findReplaceMenu->addAction(m_replaceFindAct);
     findReplaceMenu->addAction(m_replaceAllAct);
     findReplaceMenu->addSeparator();
+    findReplaceMenu->addAction(m_findInNotebookAct);
+    findReplaceMenu->addSeparator();
     findReplaceMenu->addAction(searchedWordAct);
     searchedWordAct->setChecked(g_config->getHighlightSearchedWord());
 
@@ -1009,6 +1028,12 @@ void VMainWindow::initDockWindows()
     connect(editArea, &VEditArea::curHeaderChanged,
             outline, &VOutline::updateCurHeader);
     toolBox->addItem(outline, QIcon(":/resources/icons/outline.svg"), tr("Outline"));
+
+    m_searchPanel = new VSearchPanel(vnote->getSearchIndex(), vnote->getSearchIndexer(), this);
+    connect(m_searchPanel, &VSearchPanel::noteActivated,
+            this, &VMainWindow::tryOpenInternalFile);
+    toolBox->addItem(m_searchPanel, QIcon(":/resources/icons/find_replace.svg"), tr("Search"));
+
     toolDock->setWidget(toolBox);
     addDockWidget(Qt::RightDockWidgetArea, toolDock);
 
@@ -1754,6 +1779,17 @@ void VMainWindow::openFindDialog()
     m_findReplaceDialog->openDialog(editArea->getSelectedText());
 }
 
+void VMainWindow::openFindInNotebookDialog()
+{
+    if (!m_findInNotebookDialog) {
+        m_findInNotebookDialog = new VFindInNotebookDialog(this);
+        connect(m_findInNotebookDialog, &VFindInNotebookDialog::noteActivated,
+                this, &VMainWindow::tryOpenInternalFile);
+    }
+
+    m_findInNotebookDialog->openDialog(editArea->getSelectedText());
+}
+
 void VMainWindow::viewSettings()
 {
     VSettingsDialog settingsDialog(this);
@@ -2041,3 +2077,58 @@ void VMainWindow::showMainWindow()
 
     this->activateWindow();
 }
+
+void VMainWindow::recoverJournals()
+{
+    QStringList journals = VEditJournal::listJournals();
+    if (journals.isEmpty()) {
+        return;
+    }
+
+    QVector<QPair<QString, QString>> notes;
+    QStringList names;
+    for (auto const &journal : journals) {
+        QString path, text;
+        if (VEditJournal::readJournal(journal, path, text) && QFileInfo::exists(path)) {
+            notes.append(QPair<QString, QString>(path, text));
+            names.append(path);
+        }
+    }
+
+    int ret = QMessageBox::No;
+    if (!notes.isEmpty()) {
+        ret = VUtils::showMessage(QMessageBox::Information, tr("Information"),
+                                  tr("VNote was not closed properly. Unsaved changes of "
+                                     "%1 notes are found.").arg(notes.size()),
+                                  tr("Do you want to recover them?\n%1").arg(names.join('\n')),
+                                  QMessageBox::Yes | QMessageBox::No,
+                                  QMessageBox::Yes, this);
+    }
+
+    // Tabs opened for recovering will write their own journals.
+    for (auto const &journal : journals) {
+        QFile::remove(journal);
+    }
+
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
+
+    for (auto const &note : notes) {
+        VFile *file = vnote->getInternalFile(note.first);
+        if (!file) {
+            file = vnote->getOrphanFile(note.first, true);
+        }
+
+        if (file->getDocType() != DocType::Markdown || !file->isModifiable()) {
+            continue;
+        }
+
+        editArea->openFile(file, OpenFileMode::Edit);
+        VMdTab *tab = dynamic_cast<VMdTab *>(editArea->currentEditTab());
+        if (tab && tab->getFile() == file) {
+            tab->editFile();
+            tab->recoverText(note.second);
+        }
+    }
+}
@@ -25,9 +25,11 @@ class VFileList;
 class VEditArea;
 class QToolBox;
 class VOutline;
+class VSearchPanel;
 class VNotebookSelector;
 class VAvatar;
 class VFindReplaceDialog;
+class VFindInNotebookDialog;
 class VCaptain;
 class VVimIndicator;
 class VTabIndicator;
@@ -88,6 +90,7 @@ private slots:
     void insertImage();
     void handleFindDialogTextChanged(const QString &p_text, uint p_options);
     void openFindDialog();
+    void openFindInNotebookDialog();
     void enableMermaid(bool p_checked);
     void enableMathjax(bool p_checked);
     void handleCaptainModeChanged(bool p_enabled);
@@ -120,6 +123,9 @@ private slots:
     // Restore main window.
     void showMainWindow();
 
+    // Offer to recover unsaved changes left in journals by last session.
+    void recoverJournals();
+
 protected:
     void closeEvent(QCloseEvent *event) Q_DECL_OVERRIDE;
     void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
@@ -199,8 +205,13 @@ private:
     QDockWidget *toolDock;
     QToolBox *toolBox;
     VOutline *outline;
+    VSearchPanel *m_searchPanel;
     VAvatar *m_avatar;
     VFindReplaceDialog *m_findReplaceDialog;
+
+    // Created on first use.
+    VFindInNotebookDialog *m_findInNotebookDialog;
+
     VVimIndicator *m_vimIndicator;
     VTabIndicator *m_tabIndicator;
 
@@ -229,6 +240,7 @@ private:
     QAction *m_replaceAct;
     QAction *m_replaceFindAct;
     QAction *m_replaceAllAct;
+    QAction *m_findInNotebookAct;
 
     QAction *m_autoIndentAct;
 
@@ -70,8 +70,6 @@ void VMdEdit::beginEdit()
 
     updateConfig();
 
-    Q_ASSERT(m_file->getContent() == toPlainTextWithoutImg());
-
     initInitImages();
 
     m_imagePreviewer->refresh();
@@ -81,6 +79,8 @@ void VMdEdit::beginEdit()
 
     // Request update outline.
     generateEditOutline();
+
+    m_file->releaseContent();
 }
 
 void VMdEdit::endEdit()
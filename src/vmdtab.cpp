@@ -17,13 +17,14 @@
 #include "veditarea.h"
 #include "vconstants.h"
 #include "vwebview.h"
+#include "veditjournal.h"
 
 extern VConfigManager *g_config;
 
 VMdTab::VMdTab(VFile *p_file, VEditArea *p_editArea,
                OpenFileMode p_mode, QWidget *p_parent)
     : VEditTab(p_file, p_editArea, p_parent), m_editor(NULL), m_webViewer(NULL),
-      m_document(NULL), m_mdConType(g_config->getMdConverterType())
+      m_document(NULL), m_mdConType(g_config->getMdConverterType()), m_journal(NULL)
 {
     V_ASSERT(m_file->getDocType() == DocType::Markdown);
 
@@ -126,6 +127,7 @@ void VMdTab::showFileEditMode()
     int outlineIndex = m_curHeader.m_outlineIndex;
 
     mdEdit->beginEdit();
+    m_journal->start();
     m_stacks->setCurrentWidget(mdEdit);
 
     int lineNumber = -1;
@@ -162,6 +164,7 @@ bool VMdTab::closeFile(bool p_forced)
         Q_ASSERT(m_editor);
         m_editor->reloadFile();
         m_editor->endEdit();
+        m_journal->stop();
 
         showFileReadMode();
     } else {
@@ -196,7 +199,12 @@ void VMdTab::readFile()
                                       QMessageBox::Save, this);
         switch (ret) {
         case QMessageBox::Save:
-            saveFile();
+            // Keep editing if the note is not written, which will be warned
+            // by handleFileSaved().
+            if (!saveFile() || !m_file->waitForSaved()) {
+                return;
+            }
+
             // Fall through
 
         case QMessageBox::Discard:
@@ -215,6 +223,7 @@ void VMdTab::readFile()
 
     if (m_editor) {
         m_editor->endEdit();
+        m_journal->stop();
     }
 
     showFileReadMode();
@@ -232,7 +241,6 @@ bool VMdTab::saveFile()
         return true;
     }
 
-    bool ret;
     // Make sure the file already exists. Temporary deal with cases when user delete or move
     // a file.
     QString filePath = m_file->retrivePath();
@@ -245,23 +253,53 @@ bool VMdTab::saveFile()
         return false;
     }
 
+    // The content is written in background and the result is reported
+    // to handleFileSaved().
     m_editor->saveFile();
-    ret = m_file->save();
-    if (!ret) {
-        VUtils::showMessage(QMessageBox::Warning, tr("Warning"), tr("Fail to save note."),
-                            tr("Fail to write to disk when saving a note. Please try it again."),
-                            QMessageBox::Ok, QMessageBox::Ok, this);
+    m_file->save();
+
+    updateStatus();
+
+    return true;
+}
+
+void VMdTab::handleFileSaved(bool p_succeed)
+{
+    VEditTab::handleFileSaved(p_succeed);
+
+    if (!m_editor) {
+        return;
+    }
+
+    if (!p_succeed) {
         m_editor->setModified(true);
+        updateStatus();
+    } else if (!m_editor->isModified()) {
+        m_journal->discard();
     }
+}
 
-    updateStatus();
+void VMdTab::recoverText(const QString &p_text)
+{
+    if (!m_isEditMode) {
+        return;
+    }
 
-    return ret;
+    Q_ASSERT(m_editor);
+
+    // Insert as an edit so that it could be undone and the note is modified.
+    QTextCursor cursor(m_editor->document());
+    cursor.select(QTextCursor::Document);
+    cursor.insertText(p_text);
+    updateStatus();
 }
 
 void VMdTab::saveAndRead()
 {
-    saveFile();
+    if (!saveFile() || !m_file->waitForSaved()) {
+        return;
+    }
+
     readFile();
 }
 
@@ -321,6 +359,8 @@ void VMdTab::setupMarkdownEditor()
             this, &VMdTab::saveFile);
     connect(m_editor, &VEdit::statusMessage,
             this, &VEditTab::statusMessage);
+    connect(m_editor, &VEdit::matchCountUpdated,
+            this, &VEditTab::matchCountUpdated);
     connect(m_editor, &VEdit::vimStatusUpdated,
             this, &VEditTab::vimStatusUpdated);
     connect(m_editor, &VEdit::requestCloseFindReplaceDialog,
@@ -330,6 +370,8 @@ void VMdTab::setupMarkdownEditor()
 
     m_editor->reloadFile();
     m_stacks->addWidget(m_editor);
+
+    m_journal = new VEditJournal(m_file->retrivePath(), m_editor->document(), this);
 }
 
 static void parseTocUl(QXmlStreamReader &p_xml, QVector<VHeader> &p_headers,
@@ -12,6 +12,7 @@ class VWebView;
 class QStackedLayout;
 class VEdit;
 class VDocument;
+class VEditJournal;
 
 class VMdTab : public VEditTab
 {
@@ -60,6 +61,9 @@ public:
     // Insert decoration markers or decorate selected text.
     void decorateText(TextDecoration p_decoration) Q_DECL_OVERRIDE;
 
+    // Replace the text in edit mode with @p_text recovered from a journal.
+    void recoverText(const QString &p_text);
+
 public slots:
     // Enter edit mode.
     void editFile() Q_DECL_OVERRIDE;
@@ -125,6 +129,9 @@ private:
     // Focus the proper child widget.
     void focusChild() Q_DECL_OVERRIDE;
 
+    // Mark the note modified again if it failed to be written.
+    void handleFileSaved(bool p_succeed) Q_DECL_OVERRIDE;
+
     // Create a filled VEditTabInfo.
     VEditTabInfo createEditTabInfo() Q_DECL_OVERRIDE;
 
@@ -136,6 +143,9 @@ private:
     VDocument *m_document;
     MarkdownConverterType m_mdConType;
 
+    // Journal of unsaved changes in edit mode.
+    VEditJournal *m_journal;
+
     QStackedLayout *m_stacks;
 };
 
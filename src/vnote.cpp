@@ -3,6 +3,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDir>
+#include <QFileInfo>
 #include <QFont>
 #include <QFontMetrics>
 #include <QStringList>
@@ -12,6 +13,9 @@
 #include "vconfigmanager.h"
 #include "vmainwindow.h"
 #include "vorphanfile.h"
+#include "vsearchindex.h"
+#include "vsearchindexer.h"
+#include "vfilesaver.h"
 
 extern VConfigManager *g_config;
 
@@ -56,6 +60,10 @@ VNote::VNote(QObject *parent)
 {
     initTemplate();
     g_config->getNotebooks(m_notebooks, this);
+
+    m_searchIndex = new VSearchIndex(this);
+    m_searchIndexer = new VSearchIndexer(m_searchIndex, this);
+    m_fileSaver = new VFileSaver(this);
 }
 
 void VNote::initPalette(QPalette palette)
@@ -313,12 +321,34 @@ VFile *VNote::getOrphanFile(const QString &p_path, bool p_modifiable, bool p_sys
     return file;
 }
 
+// Key of @p_path in the file index.
+static QString fileIndexKey(const QString &p_path)
+{
+    QString path = QDir::cleanPath(p_path);
+#if defined(Q_OS_WIN)
+    path = path.toLower();
+#endif
+    return path;
+}
+
 VFile *VNote::getInternalFile(const QString &p_path)
 {
+    QString key = fileIndexKey(p_path);
+    auto it = m_fileIndex.find(key);
+    if (it != m_fileIndex.end()) {
+        VFile *file = it.value();
+        if (file && fileIndexKey(file->retrivePath()) == key) {
+            return QFileInfo::exists(p_path) ? file : NULL;
+        }
+
+        m_fileIndex.erase(it);
+    }
+
     VFile *file = NULL;
     for (auto & nb : m_notebooks) {
         file = nb->tryLoadFile(p_path);
         if (file) {
+            m_fileIndex.insert(key, file);
             break;
         }
     }
@@ -326,3 +356,8 @@ VFile *VNote::getInternalFile(const QString &p_path)
     return file;
 }
 
+void VNote::indexInternalFile(VFile *p_file)
+{
+    m_fileIndex.insert(fileIndexKey(p_file->retrivePath()), p_file);
+}
+
@@ -10,11 +10,15 @@
 #include <QPair>
 #include <QHash>
 #include <QPalette>
+#include <QPointer>
 #include "vnotebook.h"
 #include "vconstants.h"
 
 class VMainWindow;
 class VFile;
+class VSearchIndex;
+class VSearchIndexer;
+class VFileSaver;
 
 class VNote : public QObject
 {
@@ -84,8 +88,21 @@ public:
     // Given the path of a file, try to find it in all notebooks.
     // Returns a VFile struct if it is a note in one notebook.
     // Otherwise, returns NULL.
+    // The file index is looked up before searching the notebooks.
     VFile *getInternalFile(const QString &p_path);
 
+    // Add @p_file to the index of internal files.
+    void indexInternalFile(VFile *p_file);
+
+    // Full-text search index of all the notebooks.
+    VSearchIndex *getSearchIndex() const;
+
+    // Background indexer keeping the search index up to date.
+    VSearchIndexer *getSearchIndexer() const;
+
+    // Background writer of notes.
+    VFileSaver *getFileSaver() const;
+
 public slots:
     void updateTemplate();
 
@@ -100,6 +117,17 @@ private:
     // Hold all external file: Orphan File.
     // Need to clean up periodly.
     QList<VFile *> m_externalFiles;
+
+    // Path -> internal file loaded.
+    // Entries are checked on lookup since the file may be renamed, moved or
+    // deleted after indexed.
+    QHash<QString, QPointer<VFile>> m_fileIndex;
+
+    VSearchIndex *m_searchIndex;
+
+    VSearchIndexer *m_searchIndexer;
+
+    VFileSaver *m_fileSaver;
 };
 
 inline const QVector<QPair<QString, QString> >& VNote::getPalette() const
@@ -112,4 +140,19 @@ inline VMainWindow *VNote::getMainWindow() const
     return m_mainWindow;
 }
 
+inline VSearchIndex *VNote::getSearchIndex() const
+{
+    return m_searchIndex;
+}
+
+inline VSearchIndexer *VNote::getSearchIndexer() const
+{
+    return m_searchIndexer;
+}
+
+inline VFileSaver *VNote::getFileSaver() const
+{
+    return m_fileSaver;
+}
+
 #endif // VNOTE_H
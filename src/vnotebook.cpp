@@ -5,6 +5,7 @@
 #include "utils/vutils.h"
 #include "vconfigmanager.h"
 #include "vfile.h"
+#include "vdirconfigcache.h"
 
 extern VConfigManager *g_config;
 
@@ -12,17 +13,19 @@ VNotebook::VNotebook(const QString &name, const QString &path, QObject *parent)
     : QObject(parent), m_name(name)
 {
     m_path = QDir::cleanPath(path);
+    m_configCache = new VDirConfigCache(m_path);
     m_rootDir = new VDirectory(this, VUtils::directoryNameFromPath(path));
 }
 
 VNotebook::~VNotebook()
 {
     delete m_rootDir;
+    delete m_configCache;
 }
 
 bool VNotebook::readConfig()
 {
-    QJsonObject configJson = VConfigManager::readDirectoryConfig(m_path);
+    QJsonObject configJson = readDirectoryConfig(m_path);
     if (configJson.isEmpty()) {
         qWarning() << "fail to read notebook configuration" << m_path;
         return false;
@@ -63,14 +66,14 @@ QJsonObject VNotebook::toConfigJson() const
 
 bool VNotebook::writeToConfig() const
 {
-    return VConfigManager::writeDirectoryConfig(m_path, toConfigJson());
+    return writeDirectoryConfig(m_path, toConfigJson());
 }
 
 bool VNotebook::writeConfig() const
 {
     QJsonObject json = toConfigJson();
 
-    QJsonObject configJson = VConfigManager::readDirectoryConfig(m_path);
+    QJsonObject configJson = readDirectoryConfig(m_path);
     if (configJson.isEmpty()) {
         qWarning() << "fail to read notebook configuration" << m_path;
         return false;
@@ -79,7 +82,7 @@ bool VNotebook::writeConfig() const
     json[DirConfig::c_subDirectories] = configJson[DirConfig::c_subDirectories];
     json[DirConfig::c_files] = configJson[DirConfig::c_files];
 
-    return VConfigManager::writeDirectoryConfig(m_path, json);
+    return writeDirectoryConfig(m_path, json);
 }
 
 QString VNotebook::getName() const
@@ -95,6 +98,22 @@ QString VNotebook::getPath() const
 void VNotebook::close()
 {
     m_rootDir->close();
+    m_configCache->save();
+}
+
+QJsonObject VNotebook::readDirectoryConfig(const QString &p_path) const
+{
+    return m_configCache->readDirectoryConfig(p_path);
+}
+
+bool VNotebook::writeDirectoryConfig(const QString &p_path, const QJsonObject &p_json) const
+{
+    return m_configCache->writeDirectoryConfig(p_path, p_json);
+}
+
+bool VNotebook::deleteDirectoryConfig(const QString &p_path) const
+{
+    return m_configCache->deleteDirectoryConfig(p_path);
 }
 
 bool VNotebook::open()
@@ -152,7 +171,7 @@ bool VNotebook::deleteNotebook(VNotebook *p_notebook, bool p_deleteFiles)
         }
 
         // Delete the config file.
-        if (!VConfigManager::deleteDirectoryConfig(p_notebook->getPath())) {
+        if (!p_notebook->deleteDirectoryConfig(p_notebook->getPath())) {
             ret = false;
             goto exit;
         }
@@ -168,6 +187,7 @@ bool VNotebook::deleteNotebook(VNotebook *p_notebook, bool p_deleteFiles)
 
 exit:
     p_notebook->close();
+    p_notebook->m_configCache->clear();
     delete p_notebook;
 
     return ret;
@@ -6,6 +6,7 @@
 
 class VDirectory;
 class VFile;
+class VDirConfigCache;
 
 class VNotebook : public QObject
 {
@@ -66,6 +67,14 @@ public:
     // Return only the info of notebook part in json.
     QJsonObject toConfigJsonNotebook() const;
 
+    // Read the config of directory @p_path in this notebook via the cache.
+    QJsonObject readDirectoryConfig(const QString &p_path) const;
+
+    // Write the config of directory @p_path in this notebook via the cache.
+    bool writeDirectoryConfig(const QString &p_path, const QJsonObject &p_json) const;
+
+    bool deleteDirectoryConfig(const QString &p_path) const;
+
 signals:
     void contentChanged();
 
@@ -86,6 +95,9 @@ private:
 
     // Parent is NULL for root directory
     VDirectory *m_rootDir;
+
+    // Cache of the configs of the directories in this notebook.
+    VDirConfigCache *m_configCache;
 };
 
 inline VDirectory *VNotebook::getRootDir() const
@@ -18,6 +18,7 @@
 #include "vdirectory.h"
 #include "utils/vutils.h"
 #include "vnote.h"
+#include "vexporter.h"
 #include "veditarea.h"
 #include "vnofocusitemdelegate.h"
 
@@ -64,6 +65,20 @@ void VNotebookSelector::initActions()
     m_notebookInfoAct->setToolTip(tr("View and edit current notebook's information"));
     connect(m_notebookInfoAct, SIGNAL(triggered(bool)),
             this, SLOT(editNotebookInfo()));
+
+    m_exportAsPDFAct = new QAction(tr("Export As &PDF"), this);
+    m_exportAsPDFAct->setToolTip(tr("Export all the notes of current notebook as PDF files"));
+    connect(m_exportAsPDFAct, &QAction::triggered,
+            this, [this]() {
+                exportNotebook(ExportType::PDF);
+            });
+
+    m_exportAsHTMLAct = new QAction(tr("Export As &HTML"), this);
+    m_exportAsHTMLAct->setToolTip(tr("Export all the notes of current notebook as HTML files"));
+    connect(m_exportAsHTMLAct, &QAction::triggered,
+            this, [this]() {
+                exportNotebook(ExportType::HTML);
+            });
 }
 
 void VNotebookSelector::updateComboBox()
@@ -275,6 +290,21 @@ int VNotebookSelector::indexOfNotebook(const VNotebook *p_notebook)
 }
 
 
+void VNotebookSelector::exportNotebook(ExportType p_type)
+{
+    QList<QListWidgetItem *> items = m_listWidget->selectedItems();
+    if (items.isEmpty()) {
+        return;
+    }
+    Q_ASSERT(items.size() == 1);
+    int index = indexOfListItem(items[0]);
+    VNotebook *notebook = getNotebookFromComboIndex(index);
+
+    VExporter exporter(g_config->getMdConverterType(), this);
+    exporter.exportNotebook(notebook, p_type);
+    exporter.exec();
+}
+
 void VNotebookSelector::editNotebookInfo()
 {
     QList<QListWidgetItem *> items = m_listWidget->selectedItems();
@@ -350,6 +380,10 @@ void VNotebookSelector::requestPopupListContextMenu(QPoint p_pos)
     QMenu menu(this);
     menu.setToolTipsVisible(true);
     menu.addAction(m_deleteNotebookAct);
+    menu.addSeparator();
+    menu.addAction(m_exportAsPDFAct);
+    menu.addAction(m_exportAsHTMLAct);
+    menu.addSeparator();
     menu.addAction(m_notebookInfoAct);
 
     menu.exec(m_listWidget->mapToGlobal(p_pos));
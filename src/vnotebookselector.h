@@ -5,6 +5,7 @@
 #include <QVector>
 #include <QString>
 #include "vnavigationmode.h"
+#include "vconstants.h"
 
 class VNotebook;
 class VNote;
@@ -49,6 +50,9 @@ private slots:
     void deleteNotebook();
     void editNotebookInfo();
 
+    // Export all the notes of the selected notebook.
+    void exportNotebook(ExportType p_type);
+
 private:
     void initActions();
     void updateComboBox();
@@ -85,6 +89,8 @@ private:
     // Actions
     QAction *m_deleteNotebookAct;
     QAction *m_notebookInfoAct;
+    QAction *m_exportAsPDFAct;
+    QAction *m_exportAsHTMLAct;
 
     // We will add several special action item in the combobox. This is the start index
     // of the real notebook items related to m_notebooks.
@@ -5,8 +5,11 @@
 #include <QDir>
 #include "utils/vutils.h"
 #include "vconfigmanager.h"
+#include "vnote.h"
+#include "vfilesaver.h"
 
 extern VConfigManager *g_config;
+extern VNote *g_vnote;
 
 VOrphanFile::VOrphanFile(const QString &p_path, QObject *p_parent,
                          bool p_modifiable, bool p_systemFile)
@@ -27,6 +30,7 @@ bool VOrphanFile::open()
     Q_ASSERT(QFileInfo::exists(m_path));
 
     m_content = VUtils::readFileFromDisk(m_path);
+    m_contentReleased = false;
     m_modified = false;
     m_opened = true;
     return true;
@@ -66,7 +70,17 @@ bool VOrphanFile::save()
 {
     Q_ASSERT(m_opened);
     Q_ASSERT(m_modifiable);
-    return VUtils::writeFileToDisk(retrivePath(), m_content);
+    if (m_contentReleased) {
+        // Nothing changed since the content was written or read.
+        return true;
+    }
+
+    if (!g_vnote) {
+        return VFileSaver::writeFileAtomically(retrivePath(), m_content);
+    }
+
+    g_vnote->getFileSaver()->save(retrivePath(), m_content);
+    return true;
 }
 
 void VOrphanFile::convert(DocType /* p_curType */, DocType /* p_targetType */)
@@ -107,6 +121,7 @@ VNotebook *VOrphanFile::getNotebook()
 void VOrphanFile::setContent(const QString & p_content)
 {
     m_content = p_content;
+    m_contentReleased = false;
 }
 
 bool VOrphanFile::isInternalImageFolder(const QString &p_path) const
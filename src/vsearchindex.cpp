@@ -0,0 +1,682 @@
+#include "vsearchindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTimer>
+#include <QRunnable>
+#include <QSet>
+#include <QRegularExpression>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#include "utils/vutils.h"
+#include "vconfigmanager.h"
+#include "vconstants.h"
+
+extern VConfigManager *g_config;
+
+static const QString c_indexFileName = "search_index.db";
+
+static const quint32 c_indexMagic = 0x564e5349;
+
+static const quint32 c_indexVersion = 1;
+
+// Terms longer than this are most likely not words, such as base64 data.
+static const int c_maxTermLength = 64;
+
+// Parameters of BM25.
+static const double c_bm25K1 = 1.2;
+static const double c_bm25B = 0.75;
+
+// Interval to save the index after it is changed.
+static const int c_saveInterval = 5000;
+
+// Compact the index when the share of deleted postings exceeds this.
+static const double c_maxDeletedPostingRatio = 0.25;
+
+VSearchIndex::VSearchIndex(QObject *p_parent)
+    : QObject(p_parent), m_totalLength(0), m_postingCount(0), m_deletedPostingCount(0),
+      m_loaded(false), m_dirty(false)
+{
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(c_saveInterval);
+    connect(m_saveTimer, &QTimer::timeout,
+            this, &VSearchIndex::save);
+
+    m_writePool.setMaxThreadCount(1);
+}
+
+VSearchIndex::~VSearchIndex()
+{
+    save();
+    m_writePool.waitForDone();
+}
+
+// Whether @p_ch is a CJK character, which is indexed as bigrams.
+static inline bool isCJKChar(uint p_ch)
+{
+    return (p_ch >= 0x4E00 && p_ch <= 0x9FFF)       // CJK Unified Ideographs.
+           || (p_ch >= 0x3400 && p_ch <= 0x4DBF)    // Extension A.
+           || (p_ch >= 0x20000 && p_ch <= 0x2FA1F)  // Extension B and later.
+           || (p_ch >= 0xF900 && p_ch <= 0xFAFF)    // Compatibility Ideographs.
+           || (p_ch >= 0x3040 && p_ch <= 0x30FF)    // Hiragana and Katakana.
+           || (p_ch >= 0xAC00 && p_ch <= 0xD7AF);   // Hangul Syllables.
+}
+
+static inline bool isWordChar(uint p_ch)
+{
+    return !isCJKChar(p_ch) && (QChar::isLetterOrNumber(p_ch) || p_ch == '_');
+}
+
+QStringList VSearchIndex::tokenize(const QString &p_text)
+{
+    QStringList terms;
+    QVector<uint> chars = p_text.toCaseFolded().toUcs4();
+    int size = chars.size();
+    int i = 0;
+    while (i < size) {
+        int start = i;
+        if (isCJKChar(chars[i])) {
+            while (i < size && isCJKChar(chars[i])) {
+                ++i;
+            }
+
+            if (i - start == 1) {
+                terms.append(QString::fromUcs4(&chars[start], 1));
+            } else {
+                for (int j = start; j < i - 1; ++j) {
+                    terms.append(QString::fromUcs4(&chars[j], 2));
+                }
+            }
+        } else if (isWordChar(chars[i])) {
+            while (i < size && isWordChar(chars[i])) {
+                ++i;
+            }
+
+            if (i - start <= c_maxTermLength) {
+                terms.append(QString::fromUcs4(&chars[start], i - start));
+            }
+        } else {
+            ++i;
+        }
+    }
+
+    return terms;
+}
+
+QHash<QString, int> VSearchIndex::termFrequencies(const QString &p_text, int &p_length)
+{
+    QHash<QString, int> freqs;
+    QStringList terms = tokenize(p_text);
+    for (auto const &term : terms) {
+        ++freqs[term];
+    }
+
+    p_length = terms.size();
+    return freqs;
+}
+
+// Get the text to index of note @p_path with content @p_content.
+static QString noteText(const QString &p_path, const QString &p_content)
+{
+    if (VUtils::docTypeFromName(p_path) == DocType::Html) {
+        // Index only the text of rich text notes.
+        QString text = p_content;
+        text.replace(QRegularExpression("<[^>]*>"), " ");
+        return text;
+    }
+
+    return p_content;
+}
+
+QString VSearchIndex::readNoteText(const QString &p_path)
+{
+    QFile file(p_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "fail to read note" << p_path;
+        return QString();
+    }
+
+    return noteText(p_path, QString::fromUtf8(file.readAll()));
+}
+
+void VSearchIndex::collectNotes(const QString &p_dirPath,
+                                QStringList &p_notes,
+                                QStringList *p_dirs)
+{
+    QJsonObject configJson = VConfigManager::readDirectoryConfig(p_dirPath);
+    if (configJson.isEmpty()) {
+        qWarning() << "invalid directory configuration in path" << p_dirPath;
+        return;
+    }
+
+    if (p_dirs) {
+        p_dirs->append(QDir::cleanPath(p_dirPath));
+    }
+
+    QDir dir(p_dirPath);
+    QJsonArray fileJson = configJson[DirConfig::c_files].toArray();
+    for (int i = 0; i < fileJson.size(); ++i) {
+        QString name = fileJson[i].toObject()[DirConfig::c_name].toString();
+        p_notes.append(QDir::cleanPath(dir.filePath(name)));
+    }
+
+    QJsonArray dirJson = configJson[DirConfig::c_subDirectories].toArray();
+    for (int i = 0; i < dirJson.size(); ++i) {
+        QString name = dirJson[i].toObject()[DirConfig::c_name].toString();
+        collectNotes(dir.filePath(name), p_notes, p_dirs);
+    }
+}
+
+void VSearchIndex::updateNote(const QString &p_path,
+                              const QString &p_notebook,
+                              const QString &p_content)
+{
+    int length = 0;
+    QHash<QString, int> terms = termFrequencies(noteText(p_path, p_content), length);
+    qint64 mtime = QFileInfo(p_path).lastModified().toMSecsSinceEpoch();
+    updateNote(p_path, p_notebook, terms, length, mtime);
+}
+
+void VSearchIndex::updateNote(const QString &p_path,
+                              const QString &p_notebook,
+                              const QHash<QString, int> &p_terms,
+                              int p_length,
+                              qint64 p_mtime)
+{
+    ensureLoaded();
+
+    QString path = QDir::cleanPath(p_path);
+    removeNote(path);
+
+    int docId = m_docs.size();
+    Document doc;
+    doc.m_path = path;
+    doc.m_notebook = p_notebook;
+    doc.m_mtime = p_mtime;
+    doc.m_length = p_length;
+    doc.m_termCount = p_terms.size();
+    m_docs.append(doc);
+    m_docIds.insert(path, docId);
+    m_totalLength += p_length;
+    m_postingCount += doc.m_termCount;
+
+    for (auto it = p_terms.constBegin(); it != p_terms.constEnd(); ++it) {
+        m_postings[it.key()].append(Posting(docId, it.value()));
+    }
+
+    markDirty();
+}
+
+void VSearchIndex::removeNote(const QString &p_path)
+{
+    ensureLoaded();
+
+    auto it = m_docIds.find(QDir::cleanPath(p_path));
+    if (it == m_docIds.end()) {
+        return;
+    }
+
+    // Postings of the deleted document will be dropped in compact().
+    Document &doc = m_docs[it.value()];
+    doc.m_deleted = true;
+    m_totalLength -= doc.m_length;
+    m_deletedPostingCount += doc.m_termCount;
+    m_docIds.erase(it);
+
+    markDirty();
+}
+
+void VSearchIndex::retainNotes(const QStringList &p_paths, const QString &p_dirPath)
+{
+    ensureLoaded();
+
+    QSet<QString> paths;
+    for (auto const &path : p_paths) {
+        paths.insert(QDir::cleanPath(path));
+    }
+
+    QString prefix;
+    if (!p_dirPath.isEmpty()) {
+        prefix = QDir::cleanPath(p_dirPath) + "/";
+    }
+
+    QStringList removedPaths;
+    for (auto it = m_docIds.constBegin(); it != m_docIds.constEnd(); ++it) {
+        if (!it.key().startsWith(prefix)) {
+            continue;
+        }
+
+        if (!paths.contains(it.key())) {
+            removedPaths.append(it.key());
+        }
+    }
+
+    for (auto const &path : removedPaths) {
+        removeNote(path);
+    }
+}
+
+qint64 VSearchIndex::getNoteModifiedTime(const QString &p_path) const
+{
+    auto it = m_docIds.constFind(QDir::cleanPath(p_path));
+    if (it == m_docIds.constEnd()) {
+        return -1;
+    }
+
+    return m_docs[it.value()].m_mtime;
+}
+
+QHash<QString, qint64> VSearchIndex::getNoteModifiedTimes()
+{
+    ensureLoaded();
+
+    QHash<QString, qint64> mtimes;
+    mtimes.reserve(m_docIds.size());
+    for (auto it = m_docIds.constBegin(); it != m_docIds.constEnd(); ++it) {
+        mtimes.insert(it.key(), m_docs[it.value()].m_mtime);
+    }
+
+    return mtimes;
+}
+
+void VSearchIndex::reset()
+{
+    ensureLoaded();
+    clear();
+    markDirty();
+}
+
+QVector<VSearchResult> VSearchIndex::search(const QString &p_query, int p_maxCount)
+{
+    ensureLoaded();
+
+    QVector<VSearchResult> results;
+    int docCount = m_docIds.size();
+    if (docCount == 0) {
+        return results;
+    }
+
+    double avgLength = qMax(1.0, (double)m_totalLength / docCount);
+
+    QStringList terms = tokenize(p_query);
+    terms.removeDuplicates();
+
+    // Document id -> score.
+    QHash<int, double> scores;
+    for (auto const &term : terms) {
+        auto it = m_postings.constFind(term);
+        if (it == m_postings.constEnd()) {
+            continue;
+        }
+
+        const QVector<Posting> &postings = it.value();
+        int df = 0;
+        for (auto const &posting : postings) {
+            if (!m_docs[posting.m_docId].m_deleted) {
+                ++df;
+            }
+        }
+
+        if (df == 0) {
+            continue;
+        }
+
+        double idf = std::log(1 + (docCount - df + 0.5) / (df + 0.5));
+        for (auto const &posting : postings) {
+            const Document &doc = m_docs[posting.m_docId];
+            if (doc.m_deleted) {
+                continue;
+            }
+
+            double tf = posting.m_freq;
+            double norm = c_bm25K1 * (1 - c_bm25B + c_bm25B * doc.m_length / avgLength);
+            scores[posting.m_docId] += idf * tf * (c_bm25K1 + 1) / (tf + norm);
+        }
+    }
+
+    results.reserve(scores.size());
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        const Document &doc = m_docs[it.key()];
+        VSearchResult result;
+        result.m_path = doc.m_path;
+        result.m_notebook = doc.m_notebook;
+        result.m_score = it.value();
+        results.append(result);
+    }
+
+    auto cmp = [](const VSearchResult &p_a, const VSearchResult &p_b) {
+        return p_a.m_score > p_b.m_score;
+    };
+
+    if (p_maxCount > 0 && results.size() > p_maxCount) {
+        std::partial_sort(results.begin(), results.begin() + p_maxCount, results.end(), cmp);
+        results.resize(p_maxCount);
+    } else {
+        std::sort(results.begin(), results.end(), cmp);
+    }
+
+    return results;
+}
+
+int VSearchIndex::getNoteCount()
+{
+    ensureLoaded();
+    return m_docIds.size();
+}
+
+void VSearchIndex::ensureLoaded()
+{
+    if (m_loaded) {
+        return;
+    }
+
+    m_loaded = true;
+    if (!load()) {
+        clear();
+    }
+}
+
+void VSearchIndex::clear()
+{
+    m_docs.clear();
+    m_docIds.clear();
+    m_postings.clear();
+    m_totalLength = 0;
+    m_postingCount = 0;
+    m_deletedPostingCount = 0;
+}
+
+void VSearchIndex::markDirty()
+{
+    m_dirty = true;
+    m_saveTimer->start();
+
+    emit indexChanged();
+}
+
+void VSearchIndex::compact()
+{
+    if (m_docIds.size() == m_docs.size()) {
+        return;
+    }
+
+    // Old document id -> new document id.
+    QVector<int> newIds(m_docs.size(), -1);
+    QVector<Document> docs;
+    docs.reserve(m_docIds.size());
+    for (int i = 0; i < m_docs.size(); ++i) {
+        if (!m_docs[i].m_deleted) {
+            newIds[i] = docs.size();
+            m_docIds[m_docs[i].m_path] = docs.size();
+            docs.append(m_docs[i]);
+        }
+    }
+
+    m_docs = docs;
+
+    for (auto it = m_postings.begin(); it != m_postings.end();) {
+        QVector<Posting> &postings = it.value();
+        int j = 0;
+        for (int i = 0; i < postings.size(); ++i) {
+            int newId = newIds[postings[i].m_docId];
+            if (newId != -1) {
+                postings[j++] = Posting(newId, postings[i].m_freq);
+            }
+        }
+
+        if (j == 0) {
+            it = m_postings.erase(it);
+        } else {
+            postings.resize(j);
+            ++it;
+        }
+    }
+
+    m_postingCount -= m_deletedPostingCount;
+    m_deletedPostingCount = 0;
+}
+
+QString VSearchIndex::indexFilePath() const
+{
+    return g_config->getConfigFolder() + QDir::separator() + c_indexFileName;
+}
+
+static void writeVarInt(QByteArray &p_data, quint32 p_val)
+{
+    while (p_val >= 0x80) {
+        p_data.append(char((p_val & 0x7f) | 0x80));
+        p_val >>= 7;
+    }
+
+    p_data.append(char(p_val));
+}
+
+static bool readVarInt(const QByteArray &p_data, int &p_idx, quint32 &p_val)
+{
+    p_val = 0;
+    int shift = 0;
+    while (p_idx < p_data.size() && shift < 32) {
+        quint8 byte = p_data[p_idx++];
+        p_val |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+// Write a snapshot of the index to disk. Deleted documents are dropped
+// while writing, so the index in memory needs not to be compacted first.
+class VSearchIndex::WriteRunnable : public QRunnable
+{
+public:
+    WriteRunnable(VSearchIndex *p_index,
+                  const QString &p_filePath,
+                  const QVector<Document> &p_docs,
+                  const QHash<QString, QVector<Posting>> &p_postings)
+        : m_index(p_index), m_filePath(p_filePath), m_docs(p_docs), m_postings(p_postings)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        if (!write()) {
+            QMetaObject::invokeMethod(m_index, "handleSaveFailed", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    // The snapshot is shared with the index, so only read it.
+    bool write() const;
+
+    VSearchIndex *m_index;
+    QString m_filePath;
+    QVector<Document> m_docs;
+    QHash<QString, QVector<Posting>> m_postings;
+};
+
+bool VSearchIndex::WriteRunnable::write() const
+{
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "fail to open search index file" << m_filePath;
+        return false;
+    }
+
+    // Old document id -> written document id.
+    QVector<int> newIds(m_docs.size(), -1);
+    int docCount = 0;
+    for (int i = 0; i < m_docs.size(); ++i) {
+        if (!m_docs[i].m_deleted) {
+            newIds[i] = docCount++;
+        }
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << c_indexMagic << c_indexVersion;
+
+    out << qint32(docCount);
+    for (auto const &doc : m_docs) {
+        if (!doc.m_deleted) {
+            out << doc.m_path << doc.m_notebook << doc.m_mtime << qint32(doc.m_length);
+        }
+    }
+
+    // Terms with only deleted documents are dropped.
+    int termCount = 0;
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        for (auto const &posting : it.value()) {
+            if (newIds[posting.m_docId] != -1) {
+                ++termCount;
+                break;
+            }
+        }
+    }
+
+    // Posting lists are stored as variable-length integers of document id
+    // deltas and frequencies.
+    out << qint32(termCount);
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        const QVector<Posting> &postings = it.value();
+        QByteArray data;
+        data.reserve(postings.size() * 2);
+        int lastId = 0;
+        for (auto const &posting : postings) {
+            int newId = newIds[posting.m_docId];
+            if (newId == -1) {
+                continue;
+            }
+
+            writeVarInt(data, newId - lastId);
+            writeVarInt(data, posting.m_freq);
+            lastId = newId;
+        }
+
+        if (!data.isEmpty()) {
+            out << it.key() << data;
+        }
+    }
+
+    if (!file.commit()) {
+        qWarning() << "fail to write search index file" << m_filePath;
+        return false;
+    }
+
+    return true;
+}
+
+bool VSearchIndex::save()
+{
+    m_saveTimer->stop();
+    if (!m_loaded || !m_dirty) {
+        return true;
+    }
+
+    if (m_deletedPostingCount > m_postingCount * c_maxDeletedPostingRatio) {
+        compact();
+    }
+
+    // The containers are implicitly shared, so taking the snapshot is cheap
+    // and later changes will detach from it.
+    m_writePool.start(new WriteRunnable(this, indexFilePath(), m_docs, m_postings));
+    m_dirty = false;
+    return true;
+}
+
+void VSearchIndex::handleSaveFailed()
+{
+    // Try again with the next save.
+    m_dirty = true;
+}
+
+bool VSearchIndex::load()
+{
+    QString filePath = indexFilePath();
+    QFile file(filePath);
+    if (!file.exists()) {
+        return false;
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "fail to open search index file" << filePath;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != c_indexMagic || version != c_indexVersion) {
+        qWarning() << "unknown format of search index file" << filePath;
+        return false;
+    }
+
+    qint32 docCount;
+    in >> docCount;
+    if (docCount < 0) {
+        return false;
+    }
+
+    m_docs.reserve(docCount);
+    for (int i = 0; i < docCount && in.status() == QDataStream::Ok; ++i) {
+        Document doc;
+        qint32 length;
+        in >> doc.m_path >> doc.m_notebook >> doc.m_mtime >> length;
+        doc.m_length = length;
+        m_docIds.insert(doc.m_path, i);
+        m_totalLength += length;
+        m_docs.append(doc);
+    }
+
+    qint32 termCount;
+    in >> termCount;
+    for (int i = 0; i < termCount && in.status() == QDataStream::Ok; ++i) {
+        QString term;
+        QByteArray data;
+        in >> term >> data;
+
+        QVector<Posting> postings;
+        int idx = 0;
+        quint32 delta, freq;
+        int docId = 0;
+        while (idx < data.size()) {
+            if (!readVarInt(data, idx, delta) || !readVarInt(data, idx, freq)) {
+                return false;
+            }
+
+            docId += delta;
+            if (docId >= m_docs.size()) {
+                return false;
+            }
+
+            postings.append(Posting(docId, freq));
+            ++m_docs[docId].m_termCount;
+        }
+
+        m_postingCount += postings.size();
+
+        m_postings.insert(term, postings);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "fail to read search index file" << filePath;
+        return false;
+    }
+
+    qDebug() << "search index loaded with" << m_docs.size() << "notes";
+    return true;
+}
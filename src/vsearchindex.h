@@ -0,0 +1,188 @@
+#ifndef VSEARCHINDEX_H
+#define VSEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QThreadPool>
+
+class QTimer;
+
+// A note matched by a query.
+struct VSearchResult
+{
+    VSearchResult() : m_score(0)
+    {
+    }
+
+    // Absolute path of the note.
+    QString m_path;
+
+    QString m_notebook;
+
+    double m_score;
+};
+
+// Full-text inverted index of the notes of all the notebooks.
+// Results are ranked by BM25. The index is stored in the config folder and
+// updated incrementally when a note is saved.
+class VSearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VSearchIndex(QObject *p_parent = 0);
+
+    ~VSearchIndex();
+
+    // Split @p_text into lowercase terms.
+    // Runs of CJK characters are split into overlapping bigrams since there is
+    // no space between words.
+    static QStringList tokenize(const QString &p_text);
+
+    // Get the frequency of each term in @p_text.
+    // @p_length: will be set to the number of terms in @p_text.
+    static QHash<QString, int> termFrequencies(const QString &p_text, int &p_length);
+
+    // Read the text to index of note @p_path.
+    static QString readNoteText(const QString &p_path);
+
+    // Collect the paths of all the notes in directory @p_dirPath recursively
+    // according to the directory configs.
+    // @p_dirs: if not NULL, will append the paths of all the directories.
+    static void collectNotes(const QString &p_dirPath,
+                             QStringList &p_notes,
+                             QStringList *p_dirs = NULL);
+
+    // Add or replace note @p_path with content @p_content.
+    void updateNote(const QString &p_path,
+                    const QString &p_notebook,
+                    const QString &p_content);
+
+    // Add or replace note @p_path with terms already counted.
+    // @p_mtime: the last modified time of the note in msecs since epoch.
+    void updateNote(const QString &p_path,
+                    const QString &p_notebook,
+                    const QHash<QString, int> &p_terms,
+                    int p_length,
+                    qint64 p_mtime);
+
+    void removeNote(const QString &p_path);
+
+    // Remove all the notes not in @p_paths.
+    // @p_dirPath: if not empty, only notes within this directory are checked.
+    void retainNotes(const QStringList &p_paths, const QString &p_dirPath = QString());
+
+    // Last modified time of note @p_path when it was indexed.
+    // Returns -1 if it is not indexed.
+    qint64 getNoteModifiedTime(const QString &p_path) const;
+
+    // Last modified time of all the notes indexed.
+    QHash<QString, qint64> getNoteModifiedTimes();
+
+    // Remove all the notes.
+    void reset();
+
+    // Search @p_query and return at most @p_maxCount results with the
+    // highest scores first.
+    QVector<VSearchResult> search(const QString &p_query, int p_maxCount);
+
+    // Number of notes indexed.
+    int getNoteCount();
+
+    // Write the index to disk in the writer thread if changed.
+    bool save();
+
+signals:
+    void indexChanged();
+
+private slots:
+    // Called via queued invocation from the writer thread.
+    void handleSaveFailed();
+
+private:
+    class WriteRunnable;
+
+    // A note in the index.
+    struct Document
+    {
+        Document() : m_mtime(0), m_length(0), m_termCount(0), m_deleted(false)
+        {
+        }
+
+        QString m_path;
+        QString m_notebook;
+        qint64 m_mtime;
+
+        // Number of terms.
+        int m_length;
+
+        // Number of distinct terms, i.e. postings of this document.
+        int m_termCount;
+
+        bool m_deleted;
+    };
+
+    // Occurrence of a term in a document.
+    struct Posting
+    {
+        Posting() : m_docId(0), m_freq(0)
+        {
+        }
+
+        Posting(int p_docId, int p_freq) : m_docId(p_docId), m_freq(p_freq)
+        {
+        }
+
+        int m_docId;
+        int m_freq;
+    };
+
+    // Load the index from disk if not loaded yet.
+    void ensureLoaded();
+
+    bool load();
+
+    void clear();
+
+    // Drop deleted documents and their postings.
+    void compact();
+
+    // Mark the index changed and schedule a save.
+    void markDirty();
+
+    QString indexFilePath() const;
+
+    // Documents indexed by document id.
+    // Updating a note marks the old document deleted and appends a new one,
+    // so the posting lists are always sorted by document id.
+    QVector<Document> m_docs;
+
+    // Path -> id of the live document.
+    QHash<QString, int> m_docIds;
+
+    // Term -> posting list.
+    QHash<QString, QVector<Posting>> m_postings;
+
+    // Total number of terms of live documents.
+    qint64 m_totalLength;
+
+    // Number of postings, including those of deleted documents.
+    qint64 m_postingCount;
+
+    // Number of postings of deleted documents, which are dropped in compact().
+    qint64 m_deletedPostingCount;
+
+    bool m_loaded;
+
+    bool m_dirty;
+
+    // Delay the saving to disk after changes.
+    QTimer *m_saveTimer;
+
+    // One thread to write snapshots of the index in order.
+    QThreadPool m_writePool;
+};
+
+#endif // VSEARCHINDEX_H
@@ -0,0 +1,304 @@
+#include "vsearchindexer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QDebug>
+
+#include "vsearchindex.h"
+#include "vnote.h"
+#include "vnotebook.h"
+
+extern VNote *g_vnote;
+
+// Interval of the periodic scans.
+static const int c_scanInterval = 10 * 60 * 1000;
+
+// Delay of the first scan after start to not slow down the startup.
+static const int c_startDelay = 10 * 1000;
+
+// Interval to gather the changes of directories.
+static const int c_changeInterval = 2000;
+
+// Number of notes sent from the worker at a time.
+static const int c_batchSize = 64;
+
+// Watchers consume limited system resources, such as file descriptors on macOS.
+static const int c_maxWatchedDirs = 256;
+
+VSearchIndexWorker::VSearchIndexWorker(QObject *p_parent)
+    : QObject(p_parent), m_cancelled(0)
+{
+}
+
+void VSearchIndexWorker::cancel()
+{
+    m_cancelled.store(1);
+}
+
+void VSearchIndexWorker::scan(const QVector<VIndexScanTask> &p_tasks,
+                              const QHash<QString, qint64> &p_mtimes,
+                              bool p_full)
+{
+    m_cancelled.store(0);
+
+    QStringList notes;
+    QStringList dirs;
+    QVector<VIndexedNote> batch;
+    for (auto const &task : p_tasks) {
+        QStringList taskNotes;
+        VSearchIndex::collectNotes(task.m_dirPath, taskNotes, &dirs);
+        for (auto const &path : taskNotes) {
+            if (m_cancelled.load()) {
+                emit scanFinished(QVector<VIndexScanTask>(), QStringList(), QStringList(), false);
+                return;
+            }
+
+            QFileInfo fi(path);
+            if (!fi.isFile()) {
+                continue;
+            }
+
+            notes.append(path);
+
+            qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+            if (p_mtimes.value(path, -1) == mtime) {
+                continue;
+            }
+
+            VIndexedNote note;
+            note.m_path = path;
+            note.m_notebook = task.m_notebook;
+            note.m_mtime = mtime;
+            note.m_terms = VSearchIndex::termFrequencies(VSearchIndex::readNoteText(path),
+                                                         note.m_length);
+            batch.append(note);
+            if (batch.size() >= c_batchSize) {
+                emit notesIndexed(batch);
+                batch.clear();
+            }
+
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    if (!batch.isEmpty()) {
+        emit notesIndexed(batch);
+    }
+
+    emit scanFinished(p_tasks, notes, dirs, p_full);
+}
+
+VSearchIndexer::VSearchIndexer(VSearchIndex *p_index, QObject *p_parent)
+    : QObject(p_parent), m_index(p_index), m_fullScanPending(false), m_busy(false)
+{
+    qRegisterMetaType<QVector<VIndexScanTask>>();
+    qRegisterMetaType<QVector<VIndexedNote>>();
+    qRegisterMetaType<QHash<QString, qint64>>();
+
+    m_worker = new VSearchIndexWorker();
+    m_worker->moveToThread(&m_thread);
+    connect(this, &VSearchIndexer::scanRequested,
+            m_worker, &VSearchIndexWorker::scan);
+    connect(m_worker, &VSearchIndexWorker::notesIndexed,
+            this, &VSearchIndexer::handleNotesIndexed);
+    connect(m_worker, &VSearchIndexWorker::scanFinished,
+            this, &VSearchIndexer::handleScanFinished);
+
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &VSearchIndexer::handleDirectoryChanged);
+
+    m_scanTimer = new QTimer(this);
+    m_scanTimer->setInterval(c_scanInterval);
+    connect(m_scanTimer, &QTimer::timeout,
+            this, &VSearchIndexer::scanAll);
+
+    m_changeTimer = new QTimer(this);
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(c_changeInterval);
+    connect(m_changeTimer, &QTimer::timeout,
+            this, &VSearchIndexer::scanChangedDirs);
+}
+
+VSearchIndexer::~VSearchIndexer()
+{
+    m_worker->cancel();
+    m_thread.quit();
+    m_thread.wait();
+    delete m_worker;
+}
+
+void VSearchIndexer::start()
+{
+    if (m_thread.isRunning()) {
+        return;
+    }
+
+    m_thread.start(QThread::LowestPriority);
+
+    QTimer::singleShot(c_startDelay, this, &VSearchIndexer::scanAll);
+    m_scanTimer->start();
+}
+
+void VSearchIndexer::rebuild()
+{
+    start();
+
+    m_index->reset();
+    if (m_busy) {
+        m_worker->cancel();
+    }
+
+    scanAll();
+}
+
+void VSearchIndexer::scanAll()
+{
+    QVector<VIndexScanTask> tasks;
+    const QVector<VNotebook *> &notebooks = g_vnote->getNotebooks();
+    for (auto const &nb : notebooks) {
+        tasks.append(VIndexScanTask(QDir::cleanPath(nb->getPath()), nb->getName()));
+    }
+
+    // Covered by the full scan.
+    m_changedDirs.clear();
+
+    requestScan(tasks, true);
+}
+
+void VSearchIndexer::handleDirectoryChanged(const QString &p_path)
+{
+    m_changedDirs.insert(QDir::cleanPath(p_path));
+    m_changeTimer->start();
+}
+
+void VSearchIndexer::scanChangedDirs()
+{
+    if (m_changedDirs.isEmpty()) {
+        return;
+    }
+
+    if (m_busy) {
+        // Try again after current scan.
+        return;
+    }
+
+    // Directories are scanned recursively, so skip those within another one.
+    QStringList dirs = m_changedDirs.toList();
+    dirs.sort();
+    m_changedDirs.clear();
+
+    QVector<VIndexScanTask> tasks;
+    QString lastDir;
+    for (auto const &dir : dirs) {
+        if (!lastDir.isEmpty() && dir.startsWith(lastDir + "/")) {
+            continue;
+        }
+
+        // Removed directories are handled by the scan of their parents.
+        QString notebook = notebookOfPath(dir);
+        if (notebook.isEmpty() || !QFileInfo(dir).isDir()) {
+            continue;
+        }
+
+        tasks.append(VIndexScanTask(dir, notebook));
+        lastDir = dir;
+    }
+
+    if (!tasks.isEmpty()) {
+        requestScan(tasks, false);
+    }
+}
+
+void VSearchIndexer::requestScan(const QVector<VIndexScanTask> &p_tasks, bool p_full)
+{
+    if (m_busy) {
+        if (p_full) {
+            m_fullScanPending = true;
+        }
+
+        return;
+    }
+
+    setBusy(true);
+    emit scanRequested(p_tasks, m_index->getNoteModifiedTimes(), p_full);
+}
+
+void VSearchIndexer::handleNotesIndexed(const QVector<VIndexedNote> &p_notes)
+{
+    for (auto const &note : p_notes) {
+        // The note may be saved in VNote after it is read.
+        if (m_index->getNoteModifiedTime(note.m_path) > note.m_mtime) {
+            continue;
+        }
+
+        m_index->updateNote(note.m_path, note.m_notebook, note.m_terms,
+                            note.m_length, note.m_mtime);
+    }
+}
+
+void VSearchIndexer::handleScanFinished(const QVector<VIndexScanTask> &p_tasks,
+                                        const QStringList &p_notes,
+                                        const QStringList &p_dirs,
+                                        bool p_full)
+{
+    // Remove notes deleted or in removed notebooks.
+    if (p_full) {
+        m_index->retainNotes(p_notes);
+        updateWatchedDirs(p_dirs);
+    } else {
+        for (auto const &task : p_tasks) {
+            m_index->retainNotes(p_notes, task.m_dirPath);
+        }
+    }
+
+    qDebug() << "search index scan finished" << p_tasks.size() << p_notes.size();
+
+    setBusy(false);
+
+    if (m_fullScanPending) {
+        m_fullScanPending = false;
+        scanAll();
+    } else if (!m_changedDirs.isEmpty()) {
+        m_changeTimer->start();
+    }
+}
+
+void VSearchIndexer::updateWatchedDirs(const QStringList &p_dirs)
+{
+    QStringList watchedDirs = m_watcher->directories();
+    if (!watchedDirs.isEmpty()) {
+        m_watcher->removePaths(watchedDirs);
+    }
+
+    QStringList dirs = p_dirs.mid(0, c_maxWatchedDirs);
+    if (!dirs.isEmpty()) {
+        m_watcher->addPaths(dirs);
+    }
+}
+
+QString VSearchIndexer::notebookOfPath(const QString &p_path) const
+{
+    const QVector<VNotebook *> &notebooks = g_vnote->getNotebooks();
+    for (auto const &nb : notebooks) {
+        QString root = QDir::cleanPath(nb->getPath());
+        if (p_path == root || p_path.startsWith(root + "/")) {
+            return nb->getName();
+        }
+    }
+
+    return QString();
+}
+
+void VSearchIndexer::setBusy(bool p_busy)
+{
+    if (m_busy == p_busy) {
+        return;
+    }
+
+    m_busy = p_busy;
+    emit busyChanged(m_busy);
+}
@@ -0,0 +1,168 @@
+#ifndef VSEARCHINDEXER_H
+#define VSEARCHINDEXER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QAtomicInt>
+#include <QMetaType>
+
+class VSearchIndex;
+class QFileSystemWatcher;
+class QTimer;
+
+// A directory to scan for changed notes.
+struct VIndexScanTask
+{
+    VIndexScanTask()
+    {
+    }
+
+    VIndexScanTask(const QString &p_dirPath, const QString &p_notebook)
+        : m_dirPath(p_dirPath), m_notebook(p_notebook)
+    {
+    }
+
+    QString m_dirPath;
+    QString m_notebook;
+};
+
+// A note read and tokenized by VSearchIndexWorker.
+struct VIndexedNote
+{
+    VIndexedNote() : m_length(0), m_mtime(0)
+    {
+    }
+
+    QString m_path;
+    QString m_notebook;
+    QHash<QString, int> m_terms;
+    int m_length;
+    qint64 m_mtime;
+};
+
+Q_DECLARE_METATYPE(VIndexScanTask)
+Q_DECLARE_METATYPE(VIndexedNote)
+
+// Read and tokenize changed notes in the indexer thread.
+class VSearchIndexWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VSearchIndexWorker(QObject *p_parent = 0);
+
+    // Stop current scan as soon as possible. Thread-safe.
+    void cancel();
+
+public slots:
+    // Scan the notes in @p_tasks and index those whose last modified time
+    // differs from @p_mtimes.
+    // @p_full: whether @p_tasks cover all the notebooks.
+    void scan(const QVector<VIndexScanTask> &p_tasks,
+              const QHash<QString, qint64> &p_mtimes,
+              bool p_full);
+
+signals:
+    void notesIndexed(const QVector<VIndexedNote> &p_notes);
+
+    // @p_notes: all the notes found in @p_tasks.
+    // @p_dirs: all the directories found in @p_tasks.
+    // @p_tasks will be empty if the scan is cancelled.
+    void scanFinished(const QVector<VIndexScanTask> &p_tasks,
+                      const QStringList &p_notes,
+                      const QStringList &p_dirs,
+                      bool p_full);
+
+private:
+    QAtomicInt m_cancelled;
+};
+
+// Keep VSearchIndex up to date with notes changed outside VNote.
+// Notebook directories are watched for added, removed and renamed notes, and
+// all the notebooks are scanned periodically for notes modified in place.
+// Changed notes are read and tokenized in a low priority thread, so it will
+// not compete with the editor.
+class VSearchIndexer : public QObject
+{
+    Q_OBJECT
+public:
+    VSearchIndexer(VSearchIndex *p_index, QObject *p_parent = 0);
+
+    ~VSearchIndexer();
+
+    // Start watching the notebooks and schedule the first scan.
+    void start();
+
+    // Re-index all the notes of all the notebooks from scratch.
+    void rebuild();
+
+    bool isBusy() const;
+
+signals:
+    void busyChanged(bool p_busy);
+
+    void scanRequested(const QVector<VIndexScanTask> &p_tasks,
+                       const QHash<QString, qint64> &p_mtimes,
+                       bool p_full);
+
+private slots:
+    // Scan all the notebooks.
+    void scanAll();
+
+    void handleDirectoryChanged(const QString &p_path);
+
+    // Scan the directories changed since last scan.
+    void scanChangedDirs();
+
+    void handleNotesIndexed(const QVector<VIndexedNote> &p_notes);
+
+    void handleScanFinished(const QVector<VIndexScanTask> &p_tasks,
+                            const QStringList &p_notes,
+                            const QStringList &p_dirs,
+                            bool p_full);
+
+private:
+    // Start a scan if idle, or queue it until current scan finishes.
+    void requestScan(const QVector<VIndexScanTask> &p_tasks, bool p_full);
+
+    // Watch @p_dirs instead of current directories.
+    void updateWatchedDirs(const QStringList &p_dirs);
+
+    // Get the notebook containing @p_path.
+    // Returns empty if not found.
+    QString notebookOfPath(const QString &p_path) const;
+
+    void setBusy(bool p_busy);
+
+    VSearchIndex *m_index;
+
+    QThread m_thread;
+    VSearchIndexWorker *m_worker;
+
+    QFileSystemWatcher *m_watcher;
+
+    // Timer for periodic scans.
+    QTimer *m_scanTimer;
+
+    // Gather changes of directories into one scan.
+    QTimer *m_changeTimer;
+
+    // Directories changed but not scanned yet.
+    QSet<QString> m_changedDirs;
+
+    // Whether a full scan is queued.
+    bool m_fullScanPending;
+
+    bool m_busy;
+};
+
+inline bool VSearchIndexer::isBusy() const
+{
+    return m_busy;
+}
+
+#endif // VSEARCHINDEXER_H
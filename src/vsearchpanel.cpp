@@ -0,0 +1,132 @@
+#include "vsearchpanel.h"
+
+#include <QtWidgets>
+#include <QElapsedTimer>
+
+#include "vsearchindex.h"
+#include "vsearchindexer.h"
+
+const int VSearchPanel::c_maxResultCount = 100;
+
+// Delay of searching after the keyword is changed.
+static const int c_searchInterval = 300;
+
+VSearchPanel::VSearchPanel(VSearchIndex *p_index, VSearchIndexer *p_indexer, QWidget *p_parent)
+    : QWidget(p_parent), m_index(p_index), m_indexer(p_indexer)
+{
+    setupUI();
+
+    connect(m_index, &VSearchIndex::indexChanged,
+            this, &VSearchPanel::updateInfoLabel);
+    connect(m_indexer, &VSearchIndexer::busyChanged,
+            this, &VSearchPanel::updateInfoLabel);
+
+    // The index is loaded lazily on the first search.
+    m_infoLabel->setText(tr("Type keywords to search all the notebooks."));
+}
+
+void VSearchPanel::setupUI()
+{
+    m_keywordEdit = new QLineEdit();
+    m_keywordEdit->setPlaceholderText(tr("Search all notebooks"));
+    connect(m_keywordEdit, &QLineEdit::textChanged,
+            this, [this]() {
+                m_searchTimer->start();
+            });
+    connect(m_keywordEdit, &QLineEdit::returnPressed,
+            this, &VSearchPanel::doSearch);
+
+    m_rebuildBtn = new QPushButton(tr("&Rebuild"));
+    m_rebuildBtn->setToolTip(tr("Rebuild the search index of all the notebooks"));
+    connect(m_rebuildBtn, &QPushButton::clicked,
+            this, &VSearchPanel::rebuildIndex);
+
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(c_searchInterval);
+    connect(m_searchTimer, &QTimer::timeout,
+            this, &VSearchPanel::doSearch);
+
+    m_infoLabel = new QLabel();
+    m_infoLabel->setWordWrap(true);
+
+    m_resultTree = new QTreeWidget();
+    m_resultTree->setColumnCount(2);
+    m_resultTree->setHeaderLabels(QStringList() << tr("Note") << tr("Notebook"));
+    m_resultTree->setRootIsDecorated(false);
+    m_resultTree->setSelectionMode(QAbstractItemView::SingleSelection);
+    connect(m_resultTree, &QTreeWidget::itemActivated,
+            this, &VSearchPanel::handleItemActivated);
+
+    QHBoxLayout *keywordLayout = new QHBoxLayout();
+    keywordLayout->addWidget(m_keywordEdit);
+    keywordLayout->addWidget(m_rebuildBtn);
+    keywordLayout->setContentsMargins(0, 0, 0, 0);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout();
+    mainLayout->addLayout(keywordLayout);
+    mainLayout->addWidget(m_infoLabel);
+    mainLayout->addWidget(m_resultTree);
+    mainLayout->setContentsMargins(0, 0, 0, 0);
+
+    setLayout(mainLayout);
+}
+
+void VSearchPanel::doSearch()
+{
+    m_searchTimer->stop();
+    m_resultTree->clear();
+
+    QString keyword = m_keywordEdit->text().trimmed();
+    if (keyword.isEmpty()) {
+        updateInfoLabel();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<VSearchResult> results = m_index->search(keyword, c_maxResultCount);
+    qint64 elapsed = timer.elapsed();
+
+    for (auto const &result : results) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(m_resultTree);
+        item->setText(0, QFileInfo(result.m_path).completeBaseName());
+        item->setText(1, result.m_notebook);
+        item->setToolTip(0, result.m_path);
+        item->setData(0, Qt::UserRole, result.m_path);
+    }
+
+    m_infoLabel->setText(tr("%1 notes found in %2 ms.").arg(results.size()).arg(elapsed));
+}
+
+void VSearchPanel::rebuildIndex()
+{
+    m_resultTree->clear();
+    m_indexer->rebuild();
+}
+
+void VSearchPanel::handleItemActivated(QTreeWidgetItem *p_item, int p_column)
+{
+    Q_UNUSED(p_column);
+    if (!p_item) {
+        return;
+    }
+
+    emit noteActivated(p_item->data(0, Qt::UserRole).toString());
+}
+
+void VSearchPanel::updateInfoLabel()
+{
+    if (!m_keywordEdit->text().trimmed().isEmpty() && m_resultTree->topLevelItemCount() > 0) {
+        return;
+    }
+
+    int count = m_index->getNoteCount();
+    if (m_indexer->isBusy()) {
+        m_infoLabel->setText(tr("Indexing notes in background (%1 notes indexed).").arg(count));
+    } else if (count == 0) {
+        m_infoLabel->setText(tr("No note indexed. Click Rebuild to build the search index."));
+    } else {
+        m_infoLabel->setText(tr("%1 notes indexed.").arg(count));
+    }
+}
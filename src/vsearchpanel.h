@@ -0,0 +1,50 @@
+#ifndef VSEARCHPANEL_H
+#define VSEARCHPANEL_H
+
+#include <QWidget>
+#include <QString>
+
+class VSearchIndex;
+class VSearchIndexer;
+class QLineEdit;
+class QPushButton;
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QTimer;
+
+// Panel to search notes of all the notebooks via the full-text index.
+class VSearchPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    VSearchPanel(VSearchIndex *p_index, VSearchIndexer *p_indexer, QWidget *p_parent = 0);
+
+signals:
+    // Request to open note @p_path.
+    void noteActivated(const QString &p_path);
+
+private slots:
+    void doSearch();
+    void rebuildIndex();
+    void handleItemActivated(QTreeWidgetItem *p_item, int p_column);
+    void updateInfoLabel();
+
+private:
+    void setupUI();
+
+    VSearchIndex *m_index;
+    VSearchIndexer *m_indexer;
+
+    QLineEdit *m_keywordEdit;
+    QPushButton *m_rebuildBtn;
+    QLabel *m_infoLabel;
+    QTreeWidget *m_resultTree;
+
+    // Search after the user stops typing for a while.
+    QTimer *m_searchTimer;
+
+    static const int c_maxResultCount;
+};
+
+#endif // VSEARCHPANEL_H
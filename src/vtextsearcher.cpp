@@ -0,0 +1,157 @@
+#include "vtextsearcher.h"
+
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include "vconstants.h"
+
+VTextMatcher::VTextMatcher(const QString &p_pattern, uint p_options)
+    : m_pattern(p_pattern), m_regExp(compile(p_pattern, p_options))
+{
+}
+
+bool VTextMatcher::isValid() const
+{
+    return !m_pattern.isEmpty() && m_regExp.isValid();
+}
+
+QRegularExpression VTextMatcher::compile(const QString &p_pattern, uint p_options)
+{
+    QString pattern = (p_options & FindOption::RegularExpression)
+                      ? p_pattern : QRegularExpression::escape(p_pattern);
+    if (p_options & FindOption::WholeWordOnly) {
+        // Like QTextDocument::FindWholeWords, only the neighbours of the match
+        // must not be letters or numbers, so "C++" and "foo_bar" work as the
+        // word boundaries of the token index.
+        pattern = QString("(?<![\\p{L}\\p{N}])(?:%1)(?![\\p{L}\\p{N}])").arg(pattern);
+    }
+
+    QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+    if (!(p_options & FindOption::CaseSensitive)) {
+        options |= QRegularExpression::CaseInsensitiveOption;
+    }
+
+    QRegularExpression exp(pattern, options);
+
+    // Compile it now (with JIT if available) instead of at the first match.
+    exp.optimize();
+    return exp;
+}
+
+void VTextMatcher::match(const QString &p_block, int p_offset, QVector<VTextMatch> &p_matches) const
+{
+    QRegularExpressionMatchIterator it = m_regExp.globalMatch(p_block);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        // Skip empty matches.
+        if (match.capturedLength() > 0) {
+            p_matches.append(VTextMatch(p_offset + match.capturedStart(),
+                                        match.capturedLength()));
+        }
+    }
+}
+
+struct VTextSearchJob
+{
+    VTextSearchJob(const VTextMatcher &p_matcher)
+        : m_id(0), m_matcher(p_matcher), m_cancelled(0)
+    {
+    }
+
+    int m_id;
+
+    QString m_text;
+
+    VTextMatcher m_matcher;
+
+    QAtomicInt m_cancelled;
+};
+
+class VTextSearchRunnable : public QRunnable
+{
+public:
+    VTextSearchRunnable(VTextSearcher *p_searcher, const QSharedPointer<VTextSearchJob> &p_job)
+        : m_searcher(p_searcher), m_job(p_job)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const VTextMatcher &matcher = m_job->m_matcher;
+        QVector<VTextMatch> matches;
+        const QString &text = m_job->m_text;
+        int start = 0;
+        while (start <= text.size()) {
+            if (m_job->m_cancelled.load()) {
+                return;
+            }
+
+            int end = text.indexOf('\n', start);
+            if (end == -1) {
+                end = text.size();
+            }
+
+            matcher.match(text.mid(start, end - start), start, matches);
+            start = end + 1;
+        }
+
+        QMetaObject::invokeMethod(m_searcher, "handleJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_job->m_id),
+                                  Q_ARG(QVector<VTextMatch>, matches));
+    }
+
+private:
+    VTextSearcher *m_searcher;
+    QSharedPointer<VTextSearchJob> m_job;
+};
+
+VTextSearcher::VTextSearcher(QObject *p_parent)
+    : QObject(p_parent), m_jobId(0)
+{
+    qRegisterMetaType<QVector<VTextMatch>>();
+
+    // A new search cancels the old one, so one worker is enough.
+    m_pool.setMaxThreadCount(1);
+}
+
+VTextSearcher::~VTextSearcher()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+int VTextSearcher::start(const QString &p_text, const VTextMatcher &p_matcher)
+{
+    cancel();
+
+    if (!p_matcher.isValid()) {
+        return 0;
+    }
+
+    QSharedPointer<VTextSearchJob> job(new VTextSearchJob(p_matcher));
+    job->m_id = ++m_jobId;
+    job->m_text = p_text;
+    m_job = job;
+
+    m_pool.start(new VTextSearchRunnable(this, job));
+    return job->m_id;
+}
+
+void VTextSearcher::cancel()
+{
+    if (m_job) {
+        m_job->m_cancelled.store(1);
+        m_job.clear();
+    }
+}
+
+void VTextSearcher::handleJobFinished(int p_id, const QVector<VTextMatch> &p_matches)
+{
+    if (p_id != m_jobId || !m_job) {
+        return;
+    }
+
+    m_job.clear();
+    emit finished(p_id, p_matches);
+}
@@ -0,0 +1,90 @@
+#ifndef VTEXTSEARCHER_H
+#define VTEXTSEARCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QMetaType>
+
+// An occurence of a pattern in a text.
+struct VTextMatch
+{
+    VTextMatch() : m_start(0), m_length(0)
+    {
+    }
+
+    VTextMatch(int p_start, int p_length) : m_start(p_start), m_length(p_length)
+    {
+    }
+
+    int m_start;
+    int m_length;
+};
+
+Q_DECLARE_TYPEINFO(VTextMatch, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(VTextMatch)
+
+// Find the occurences of a pattern block by block, with the same semantics
+// as QTextDocument::find() for FindOption @p_options.
+// Literal and whole-word searches are compiled into a QRegularExpression, so
+// jumping to, highlighting and counting matches share one engine.
+class VTextMatcher
+{
+public:
+    VTextMatcher(const QString &p_pattern, uint p_options);
+
+    bool isValid() const;
+
+    // Append the matches in @p_block to @p_matches.
+    // @p_offset: the position of @p_block in the document.
+    void match(const QString &p_block, int p_offset, QVector<VTextMatch> &p_matches) const;
+
+    // Compile @p_pattern with FindOption @p_options.
+    static QRegularExpression compile(const QString &p_pattern, uint p_options);
+
+private:
+    QString m_pattern;
+
+    QRegularExpression m_regExp;
+};
+
+struct VTextSearchJob;
+
+// Search a snapshot of a document for a pattern in the background.
+class VTextSearcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VTextSearcher(QObject *p_parent = 0);
+
+    ~VTextSearcher();
+
+    // Start to search @p_text with @p_matcher, which is shared with the
+    // worker thread instead of being compiled again.
+    // Current search will be cancelled.
+    // Returns the id of the search, or 0 if @p_matcher is invalid.
+    int start(const QString &p_text, const VTextMatcher &p_matcher);
+
+    void cancel();
+
+signals:
+    // @p_matches are sorted by their start.
+    void finished(int p_id, const QVector<VTextMatch> &p_matches);
+
+private slots:
+    // Called in the GUI thread via queued invocation from the worker.
+    void handleJobFinished(int p_id, const QVector<VTextMatch> &p_matches);
+
+private:
+    QThreadPool m_pool;
+
+    QSharedPointer<VTextSearchJob> m_job;
+
+    // Id of current job. Results of previous jobs are dropped.
+    int m_jobId;
+};
+
+#endif // VTEXTSEARCHER_H